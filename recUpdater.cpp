@@ -11,6 +11,41 @@
 #include <cstring>
 #include <string>
 #include <list>
+#include <map>
+#include <queue>
+#include <vector>
+#include <future>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+#include <sys/eventfd.h>
+#include <arpa/inet.h>
+#include <chrono>
+#include <unordered_map>
+#include <set>
+#include <random>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <sys/un.h>
+#include <net/if.h>
+#include <cstdarg>
+#include <netdb.h>
+#include <strings.h>
+#include <deque>
+#include <memory>
+#include <curl/curl.h>
 
 // ++ DEFINES ++
 // General
@@ -30,19 +65,183 @@
 #define CFG_DEF_CURL_TIMEOUT_S 60
 #define CFG_DEF_ENABLE_IPV6 true
 #define CFG_DEF_LOGGING false
+#define CFG_DEF_MAX_PARALLEL_UPDATES 32
+#define CFG_DEF_BATCH_UPDATES false
+#define CFG_DEF_NETLINK_EVENTS false
+#define CFG_DEF_SAFETY_POLL_S 1800
+#define CFG_DEF_IP_SERVICE_QUORUM 1
+#define CFG_DEF_READ_BEFORE_WRITE true
+#define CFG_DEF_VERIFY_PERIOD_S 3600
+#define CFG_DEF_PERSIST_STATE true
+#define CFG_DEF_RETRY_BASE_S 5
+#define CFG_DEF_RETRY_MAX_S 900
+#define CFG_DEF_METRICS_PORT 0
+#define CFG_DEF_METRICS_ADDRESS "127.0.0.1"
+#define CFG_DEF_LOG_JSON false
+#define CFG_DEF_LOG_MAX_SIZE_KIB 10240
+#define CFG_DEF_LOG_ROTATE_FILES 3
+#define CFG_DEF_WATCH_CONFIG true
+#define CFG_DEF_CONTROL_SOCKET "/run/recUpdater.sock"
+#define CFG_DEF_PUSH_PORT 0
+#define CFG_DEF_PUSH_ADDRESS "0.0.0.0"
+#define CFG_DEF_PUSH_TOKEN ""
+#define CFG_DEF_IP_SOURCE "http"
+#define CFG_DEF_IP_INTERFACES ""
+#define CFG_DEF_IP_EXCLUDE (IP_EXCLUDE_PRIVATE | IP_EXCLUDE_LINK_LOCAL | IP_EXCLUDE_ULA | IP_EXCLUDE_TEMPORARY)
+#define CFG_DEF_IP_CROSS_CHECK_S 3600
+#define CFG_DEF_API_RATE_LIMIT 300
+#define CFG_DEF_API_BURST 10
+#define CFG_DEF_DNS_VERIFY false
+#define CFG_DEF_DNS_SERVERS ""
+#define CFG_DEF_DNS_VERIFY_DELAY_S 30
+#define CFG_DEF_DNS_VERIFY_ATTEMPTS 5
+#define CFG_DEF_DNS_TIMEOUT_MS 1000
+#define CFG_DEF_HTTP_VERSION CURL_HTTP_VERSION_2TLS
+#define CFG_DEF_ADAPTIVE_POLLING true
+#define CFG_DEF_POLL_MIN_S 30
+#define CFG_DEF_POLL_MAX_S 1800
+#define CFG_DEF_CLUSTER_DIR ""
+#define CFG_DEF_CLUSTER_NODE ""
+#define CFG_DEF_CLUSTER_LEASE_S 6
 #define CFG_ERR_NONE 0
 #define CFG_ERR_FILE 1
 #define CFG_ERR_ATTR_MISSING 2
 #define CFG_ERR_SYNTAX 3
 
+// HTTP
+#define HTTP_MAX_IDLE_HANDLES 4
+#define HTTP_USER_AGENT "recUpdater"
+#define HTTP_POLL_TIMEOUT_MS 100
+#define HTTP_MAX_STREAMS 100
+
+// Workers
+#define WORKER_THREADS 1
+
+// IP services
+#define IP_RACE_STAGGER_MS 250
+#define IP_STATS_WEIGHT 0.3
+#define IP_STATS_FAILURE_PENALTY_MS 5000.0
+
+// IP providers
+#define IP_SOURCE_HTTP "http"
+#define IP_SOURCE_INTERFACE "interface"
+#define IP_EXCLUDE_PRIVATE 0x01
+#define IP_EXCLUDE_LINK_LOCAL 0x02
+#define IP_EXCLUDE_ULA 0x04
+#define IP_EXCLUDE_TEMPORARY 0x08
+
+// Rate limiter
+#define RATE_MIN_FACTOR 0.1
+#define RATE_INCREASE_FACTOR 0.02
+#define RATE_DEF_RETRY_AFTER_S 1
+#define RATE_WAIT_SLICE_MS 100
+#define RATE_LIMITED_MSG "Rate limited (HTTP 429)"
+
+// JSON
+#define JSON_MAX_DEPTH 32
+
+// DNS verification
+#define DNS_DEF_PORT "53"
+#define DNS_TRIES 3
+#define DNS_MAX_IN_FLIGHT 256
+#define DNS_MAX_PACKET 1232
+#define DNS_MAX_POINTERS 16
+#define DNS_TYPE_A 1
+#define DNS_TYPE_AAAA 28
+#define DNS_CLASS_IN 1
+#define DNS_NOT_SERVED_MSG "Not served by the nameservers"
+
+// Netlink
+#define NL_BUFFER 8192
+#define NL_SETTLE_MS 1000
+
+// Control socket
+#define CTL_MAX_REQUEST 4096
+#define CTL_SEND_TIMEOUT_S 2
+#define CTL_BACKLOG 8
+
+// Reload
+#define RELOAD_BUFFER 4096
+#define RELOAD_SETTLE_MS 500
+
+// Event loop
+#define EVT_MAX_EVENTS 8
+#define EVT_NONE 0x00
+#define EVT_TERMINATE 0x01
+#define EVT_HANGUP 0x02
+#define EVT_TIMER 0x04
+#define EVT_WAKE 0x08
+
+// Metrics
+#define METRICS_BUCKETS 12
+#define METRICS_STATUS_CLASSES 6
+
+// HTTP server (metrics and push listener)
+#define HTTPD_MAX_REQUEST 8192
+#define HTTPD_TIMEOUT_S 5
+#define HTTPD_MAX_CLIENTS 64
+#define HTTPD_BACKLOG 16
+
 // Logging
 #define LOG_FILE_PATH "/var/log/recUpdater.log"
+#define LOG_MAX_SUBDOMAINS 10
+#define LOG_RING_SIZE 2048
+#define LOG_MESSAGE_SIZE 368
+#define LOG_FLUSH_MS 250
+#define LOG_LEVEL_UPDATE 0
+#define LOG_LEVEL_WARNING 1
+#define LOG_LEVEL_ERROR 2
+#define LOG_LEVEL_INFO 3
+
+// State
+#define STATE_FILE_PATH "/var/lib/recUpdater/state"
+#define JOURNAL_FILE_PATH "/var/lib/recUpdater/journal"
+#define JOURNAL_COMPACT_LINES 4096
+
+// Adaptive polling
+#define POLL_HISTORY_FILE_PATH "/var/lib/recUpdater/changes"
+#define POLL_HISTORY_SIZE 64
+#define POLL_STABLE_STEP_S 21600
+#define POLL_FLAP_WINDOW_S 3600
+#define POLL_FLAP_CHANGES 2
+#define POLL_MIN_PERIODS 3
+#define POLL_WINDOW_MIN_S 600
+#define POLL_HOUR_MIN_CHANGES 3
+
+// Cluster
+#define CLUSTER_LEASE_EXTENSION ".lease"
+#define CLUSTER_VIRTUAL_NODES 64
+#define CLUSTER_MOVED_MSG "Owners of the cluster changed"
 
 // Records
+#define REC_DIR_PATH "/etc/recUpdater/records.d"
+#define REC_FILE_EXTENSION ".conf"
 #define REC_ERR_NONE 0
 #define REC_ERR_ARGUMENTS 1
 #define REC_ERR_SPECIFER 2
 #define REC_ERR_APIDOM 3
+#define REC_ERR_FILE 4
+#define REC_ERR_SYNTAX 5
+
+// Benchmark
+#define BENCH_DEF_RECORDS 100000
+#define BENCH_SUBDOMAINS_PER_DOMAIN 100
+#define BENCH_DOMAINS_PER_FILE 10
+#define BENCH_API_KEYS 10
+#define BENCH_DEF_DOMAINS 100
+#define BENCH_DEF_SUBDOMAINS 10
+#define BENCH_DEF_CYCLES 3
+#define BENCH_DEF_LATENCY_MS 20
+#define BENCH_MAX_ROUNDS 5
+#define BENCH_DEF_LOG_LINES 10000
+#define BENCH_DEF_IP_READS 1000
+#define BENCH_DEF_ALLOC_UPDATES 1000
+#define BENCH_ALLOC_WARMUP 10
+
+// Mock server
+#define MOCK_DEF_PORT 8089
+#define MOCK_DEF_ADDRESS "203.0.113.1"
+#define MOCK_MAX_HEADER 16384
 
 // Colors
 #define COLOR_DEFAULT "\033[0m"
@@ -55,9 +254,13 @@
 // Struct ConfigContents
 struct SConfigContents
 {
-	std::string strAPI, strIPService, strSuccessMsg;
+	std::string strAPI, strIPService, strSuccessMsg, strMetricsAddress, strControlSocket, strPushAddress, strPushToken, strIPSource, strIPInterfaces, strDNSServers, strClusterDir, strClusterNode;
 	uint16_t iTTL, iUpdatePeriodS, iCurlTimeout;
-	bool bEnableIPv6, bLogging;
+	uint16_t iMaxParallelUpdates, iSafetyPollS, iIPServiceQuorum, iVerifyPeriodS, iRetryBaseS, iRetryMaxS, iMetricsPort, iLogMaxSizeKiB, iLogRotateFiles, iPushPort, iIPCrossCheckS, iAPIRateLimit, iAPIBurst;
+	uint16_t iDNSVerifyDelayS, iDNSVerifyAttempts, iDNSTimeoutMs, iPollMinS, iPollMaxS, iClusterLeaseS;
+	uint8_t iIPExclude;
+	long iHttpVersion;
+	bool bEnableIPv6, bLogging, bBatchUpdates, bNetlinkEvents, bReadBeforeWrite, bPersistState, bLogJson, bWatchConfig, bDNSVerify, bAdaptivePolling;
 
 
 	// Constructor
@@ -72,671 +275,10017 @@ struct SConfigContents
 		iCurlTimeout = CFG_DEF_CURL_TIMEOUT_S;
 		bEnableIPv6 = CFG_DEF_ENABLE_IPV6;
 		bLogging = CFG_DEF_LOGGING;
+		iMaxParallelUpdates = CFG_DEF_MAX_PARALLEL_UPDATES;
+		bBatchUpdates = CFG_DEF_BATCH_UPDATES;
+		bNetlinkEvents = CFG_DEF_NETLINK_EVENTS;
+		iSafetyPollS = CFG_DEF_SAFETY_POLL_S;
+		iIPServiceQuorum = CFG_DEF_IP_SERVICE_QUORUM;
+		bReadBeforeWrite = CFG_DEF_READ_BEFORE_WRITE;
+		iVerifyPeriodS = CFG_DEF_VERIFY_PERIOD_S;
+		bPersistState = CFG_DEF_PERSIST_STATE;
+		iRetryBaseS = CFG_DEF_RETRY_BASE_S;
+		iRetryMaxS = CFG_DEF_RETRY_MAX_S;
+		iMetricsPort = CFG_DEF_METRICS_PORT;
+		strMetricsAddress = CFG_DEF_METRICS_ADDRESS;
+		bLogJson = CFG_DEF_LOG_JSON;
+		iLogMaxSizeKiB = CFG_DEF_LOG_MAX_SIZE_KIB;
+		iLogRotateFiles = CFG_DEF_LOG_ROTATE_FILES;
+		bWatchConfig = CFG_DEF_WATCH_CONFIG;
+		strControlSocket = CFG_DEF_CONTROL_SOCKET;
+		iPushPort = CFG_DEF_PUSH_PORT;
+		strPushAddress = CFG_DEF_PUSH_ADDRESS;
+		strPushToken = CFG_DEF_PUSH_TOKEN;
+		strIPSource = CFG_DEF_IP_SOURCE;
+		strIPInterfaces = CFG_DEF_IP_INTERFACES;
+		iIPExclude = CFG_DEF_IP_EXCLUDE;
+		iIPCrossCheckS = CFG_DEF_IP_CROSS_CHECK_S;
+		iAPIRateLimit = CFG_DEF_API_RATE_LIMIT;
+		iAPIBurst = CFG_DEF_API_BURST;
+		bDNSVerify = CFG_DEF_DNS_VERIFY;
+		strDNSServers = CFG_DEF_DNS_SERVERS;
+		iDNSVerifyDelayS = CFG_DEF_DNS_VERIFY_DELAY_S;
+		iDNSVerifyAttempts = CFG_DEF_DNS_VERIFY_ATTEMPTS;
+		iDNSTimeoutMs = CFG_DEF_DNS_TIMEOUT_MS;
+		iHttpVersion = CFG_DEF_HTTP_VERSION;
+		bAdaptivePolling = CFG_DEF_ADAPTIVE_POLLING;
+		iPollMinS = CFG_DEF_POLL_MIN_S;
+		iPollMaxS = CFG_DEF_POLL_MAX_S;
+		strClusterDir = CFG_DEF_CLUSTER_DIR;
+		strClusterNode = CFG_DEF_CLUSTER_NODE;
+		iClusterLeaseS = CFG_DEF_CLUSTER_LEASE_S;
 
 	} // Constructor
 
 }; // Struct ConfigContents
 
-// Struct DomRecords
-struct SDomRecords
+// Struct RetryState
+struct SRetryState
 {
-	bool bUpToData;
-	std::string strAPIKey, strDomain;
-	std::list<std::string> lstSubDomains;
+	uint16_t iAttempts;
+	std::chrono::steady_clock::time_point tNextAttempt;
 
 	// Constructor
-	SDomRecords() { bUpToData = false; }
+	SRetryState() { iAttempts = 0; }
 
-}; // Struct DomRecords
+}; // Struct RetryState
 
+// Struct Histogram
+struct SHistogram
+{
+	static constexpr double c_dBoundsMs[METRICS_BUCKETS - 1] = { 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000 };
+	std::atomic<uint64_t> iBuckets[METRICS_BUCKETS];
+	std::atomic<uint64_t> iCount, iSumUs;
 
-// Function prototypes
-bool setup(SConfigContents* psConfigContents, std::list<SDomRecords>* plstDomRecords, int argc, char* argv[], std::ofstream* pcLogFile);
-std::string timeStamp();
-uint8_t domRecordsFromCmdLine(std::list<SDomRecords>* plstDomRecords, int argc, char* argv[]);
-std::string exec(const char* cCmd);
-bool readIPAddress(std::string *pstrIPv4, std::string* pstrIPv6, SConfigContents sConfigContens);
-bool updateRecord(SDomRecords *psDomRecords, SConfigContents sConfigContents, std::string strIPv4, std::string strIPv6, std::string *pstrErrorMsg = NULL);
-void sigInterrupt(int iSignal);
-uint8_t loadConfig(SConfigContents* psConfigContents);
-bool generateConfig();
+	// Constructor
+	SHistogram() : iBuckets{}, iCount(0), iSumUs(0) {}
 
-// Global variables
-std::mutex g_mtxSigInterrupt;
-std::condition_variable g_condSigInterrupt;
-volatile sig_atomic_t g_sigInterrupt = 0;
+	// Add an observation (lock-free)
+	void observe(double dTimeMs)
+	{
+		size_t i = std::upper_bound(c_dBoundsMs, (c_dBoundsMs + METRICS_BUCKETS - 1), dTimeMs) - c_dBoundsMs;
+		iBuckets[i].fetch_add(1, std::memory_order_relaxed);
+		iCount.fetch_add(1, std::memory_order_relaxed);
+		iSumUs.fetch_add((uint64_t)std::max((dTimeMs * 1000.0), 0.0), std::memory_order_relaxed);
+	}
 
+}; // Struct Histogram
 
-// Main function
-int main(int argc, char* argv[])
+// Struct LookupMetrics
+struct SLookupMetrics
 {
-	// Variables
-	SConfigContents sConfigContents;
-	std::ofstream cLogFile;
-	std::list<SDomRecords> lstRecords;
-	std::string strCurIPv4, strCurIPv6, strLastIPv4, strLastIPv6, strErrorMsg;
-	char cBuffer[SMALL_BUFFER];
+	std::atomic<uint64_t> iSuccess, iFailure, iCanceled;
+	SHistogram sLatency;
 
+	// Constructor
+	SLookupMetrics() : iSuccess(0), iFailure(0), iCanceled(0) {}
 
-	// Print program infos
-	printf("[ARM] RecUpdater v.%.2f (Build %i)\n", VERSION, BUILD);
+}; // Struct LookupMetrics
 
-	// Try to setupt everything
-	if (!setup(&sConfigContents, &lstRecords, argc, argv, &cLogFile))
-	{
-		// Print to terminal
-		std::cerr << COLOR_RED << "[ERROR]: Initalization has failed! Exiting program..." << COLOR_DEFAULT << std::endl;
-		return -1;
-	}
+// Struct RecordMetrics
+struct SRecordMetrics
+{
+	std::atomic<uint64_t> iRequests[METRICS_STATUS_CLASSES];
+	std::atomic<uint64_t> iRetries;
+	std::atomic<int64_t> tLastPublish;
 
-	// Print to terminal
-	std::cout << "Initalization was successfull. Starting main loop..." << std::endl;
+	// Constructor
+	SRecordMetrics() : iRequests{}, iRetries(0), tLastPublish(0) {}
 
+}; // Struct RecordMetrics
 
-	// Main loop
-	while (!g_sigInterrupt)
-	{
-		// Try to read IP address
-		if ((readIPAddress(&strCurIPv4, &strCurIPv6, sConfigContents)) && (!g_sigInterrupt))
-		{
-			// Check wether the IP address has changed
-			if ((strCurIPv4 != strLastIPv4) || (strCurIPv6 != strLastIPv6))
-			{
-				// Unset update flag of all records
-				for (std::list<SDomRecords>::iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
-					iRec->bUpToData = false;
+// Struct HttpRequest
+struct SHttpRequest
+{
+	std::string strMethod, strURL, strBody;
+	std::list<std::string> lstHeaders;
+	struct curl_slist* pHeaders;
+	uint16_t iTimeoutS;
+	uint32_t iDelayMs;
+	long iIPResolve, iHttpVersion;
 
-				// Remeber current IP addresses
-				strLastIPv4 = strCurIPv4;
-				strLastIPv6 = strCurIPv6;
-			}
+	// Constructor (a precompiled header list is not owned by the request and used instead of lstHeaders)
+	SHttpRequest() { strMethod = "GET"; pHeaders = NULL; iTimeoutS = CFG_DEF_CURL_TIMEOUT_S; iDelayMs = 0; iIPResolve = CURL_IPRESOLVE_WHATEVER; iHttpVersion = CURL_HTTP_VERSION_NONE; }
 
-			// Run through all records
-			for (std::list<SDomRecords>::iterator iRec = lstRecords.begin(); ((iRec != lstRecords.end()) && (g_sigInterrupt == 0)); iRec++)
-			{
-				// Skip if no update required
-				if (iRec->bUpToData)
-					continue;
+}; // Struct HttpRequest
 
+// Struct HttpResponse
+struct SHttpResponse
+{
+	long iStatus, iHttpVersion, iConnects;
+	std::string strBody, strError;
+	std::string strETag, strRetryAfter, strRateRemaining, strRateReset;
+	double dTimeMs;
+	bool bCanceled;
 
-				// Format string and run through all subdomains and print them to console
-				sprintf(cBuffer, "%s[UPDATE]: Updating record/s for \'%s\' (", timeStamp().c_str(), iRec->strDomain.c_str());
-				for (std::list<std::string>::iterator iSDom = iRec->lstSubDomains.begin(); ((iSDom != iRec->lstSubDomains.end()) && (g_sigInterrupt == 0)); iSDom++)
-					strcat(cBuffer, (*iSDom + ", ").c_str());
+	// Constructor
+	SHttpResponse() { reset(); }
 
-				// Format string and print to console
-				cBuffer[strlen(cBuffer) - 2] = '\0';
-				strcat(cBuffer, ")... ");
-				std::cout << cBuffer << std::flush;
+	// Clear for the next request (the strings keep their buffers)
+	void reset() { iStatus = 0; iHttpVersion = 0; iConnects = 0; strBody.clear(); strError.clear(); strETag.clear(); strRetryAfter.clear(); strRateRemaining.clear(); strRateReset.clear(); dTimeMs = 0; bCanceled = false; }
 
-				// Write to logfile if enabled
-				if (sConfigContents.bLogging)
-					cLogFile << cBuffer << std::flush;
+}; // Struct HttpResponse
 
+// Struct HttpTransfer (owned by the caller of the task group and reused for its next requests)
+struct SHttpTransfer
+{
+	SHttpRequest sRequest;
+	SHttpResponse sResponse;
+	std::function<void(bool)> fnDone;
+	std::string strPoolKey;
+	CURL* pCurl;
+	struct curl_slist* pHeaders;
+	SHttpTransfer* psPrev;
+	SHttpTransfer* psNext;
 
-				// Try to update current record
-				if (updateRecord(&(*iRec), sConfigContents, strCurIPv4, strCurIPv6, &strErrorMsg))
-				{
-					// Print to console and to logfile if enabled
-					std::cout << COLOR_GREEN << "Done" << COLOR_DEFAULT << std::endl;
-					if (sConfigContents.bLogging)
-						cLogFile << "Done" << std::endl << std::flush;
-				}
-				// Check if update was canceled
-				else if (g_sigInterrupt)
-				{
-					// Print to console and to logfile if enabled
-					std::cerr << COLOR_YELLOW << "\b\bCanceled" << COLOR_DEFAULT << std::endl;
-					if (sConfigContents.bLogging)
-						cLogFile << "Canceled" << std::endl << std::flush;
-				}
-				// Updating failed
-				else
-				{
-					// Print to console and to logfile if enabled
-					std::cerr << COLOR_RED << "Failed\n" << timeStamp() << "[ERROR]: Failed to update record/s for \'" << iRec->strDomain << "\': " << strErrorMsg << "." << COLOR_DEFAULT << std::endl;
-					if (sConfigContents.bLogging)
-						cLogFile << "Failed\n" << timeStamp() << "[ERROR]: Failed to update record/s for \'" << iRec->strDomain << "\': " << strErrorMsg << "." << std::endl << std::flush;
-				}
-			}
-		}
-		// Failed to read IP address
-		else
-		{
-			// Print to termninal
-			std::cerr << COLOR_RED << timeStamp() << "[ERROR]: Something went wrong. Cannot get your IP from \'" << sConfigContents.strIPService << "\'" << COLOR_DEFAULT << std::endl;
+	// Constructor
+	SHttpTransfer() { pCurl = NULL; pHeaders = NULL; psPrev = NULL; psNext = NULL; }
 
-			// Write to logfile if enabled
-			if (sConfigContents.bLogging)
-				cLogFile << timeStamp() << "[ERROR]: Something went wrong. Cannot get your IP from \'" << sConfigContents.strIPService << "\'" << std::endl << std::flush;
-		}
+}; // Struct HttpTransfer
 
-		// Start sleeper thread
-		std::thread thSleep([](SConfigContents sConfigContents) {
-			std::unique_lock<std::mutex> lockSigInterrupt(g_mtxSigInterrupt);
-			g_condSigInterrupt.wait_for(lockSigInterrupt, std::chrono::seconds(sConfigContents.iUpdatePeriodS), [] { return g_sigInterrupt; });
-		}, sConfigContents);
+// Struct HttpConnection (client of the HTTP server)
+struct SHttpConnection
+{
+	std::string strRequest, strResponse;
+	size_t iSent = 0;
+	std::chrono::steady_clock::time_point tDeadline;
 
-		// Join sleeper thread
-		thSleep.join();
-	}
+}; // Struct HttpConnection
 
-	// Close logfile and print to termnial
-	cLogFile.close();
-	std::cout << COLOR_RED << "\rterminated" << COLOR_DEFAULT << std::endl;
+// Struct RequestTemplate (requests of a record compiled once, their buffers are reused by all of its updates)
+struct SRequestTemplate
+{
+	std::string strAPI, strZoneURL;
+	std::shared_ptr<struct curl_slist> pHeaders;
+	SHttpTransfer sTransfer;
 
+}; // Struct RequestTemplate
 
-	// Success
-	return 0;
+// Struct SubDomain
+struct SSubDomain
+{
+	std::string strName;
+	uint16_t iTTL;
+	bool bIPv4, bIPv6, bOwned;
+	std::string strURLs[2];
 
-} // Main function
+	// Constructor (a TTL of 0 is replaced by the TTL of the config)
+	SSubDomain(const std::string& strName = "", uint16_t iTTL = 0, bool bIPv4 = true, bool bIPv6 = true) : strName(strName), iTTL(iTTL), bIPv4(bIPv4), bIPv6(bIPv6), bOwned(true) {}
 
+}; // Struct SubDomain
 
-//
-// setup
-//
-// Task: Setup everything
-//
-bool setup(SConfigContents* psConfigContents, std::list<SDomRecords> *plstDomRecords, int argc, char* argv[], std::ofstream* pcLogFile)
+// Struct DomRecords
+struct SDomRecords
 {
-	// Variables
-	uint8_t iLoadRes;
+	bool bUpToData, bShared;
+	std::string strAPIKey, strDomain;
+	std::list<SSubDomain> lstSubDomains;
+	time_t tLastVerified, tLastAttempt;
+	uint16_t iWritten;
+	std::set<std::string> setPending;
+	std::map<std::string, SRetryState> mapRetries;
+	std::map<std::string, std::string> mapFailed;
+	std::map<std::string, uint16_t> mapUnconfirmed;
+	std::set<std::string> setForce;
+	std::chrono::steady_clock::time_point tConfirm;
+	SRequestTemplate sTemplate;
+	mutable SRecordMetrics sMetrics;
 
+	// Constructor
+	SDomRecords() { bUpToData = false; bShared = false; tLastVerified = 0; tLastAttempt = 0; iWritten = 0; }
 
-	// Register interrupt signal, print to terminal and try to get records from command line
-	signal(SIGINT, sigInterrupt);
-	std::cout << "Reading command line... ";
-	iLoadRes = domRecordsFromCmdLine(plstDomRecords, argc, argv);
+}; // Struct DomRecords
 
-	// Check if reading failed
-	if (iLoadRes != REC_ERR_NONE)
-	{
-		// Print to terminal
-		std::cout << COLOR_RED << "Failed" << std::endl;
+// Struct JsonValue
+struct SJsonValue
+{
+	enum EType { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT } eType;
+	std::string strValue;
+	std::vector<std::string> vecKeys;
+	std::vector<SJsonValue> vecItems;
 
-		// Print corresponding error message to terminal
-		if (iLoadRes == REC_ERR_SPECIFER)
-			std::cerr << "[ERROR]: Unknown specifier! Sytax: recUpdater -k <APIKey> -d <domain> <subdomain1> <...>" << COLOR_DEFAULT << std::endl;
-		else if (iLoadRes == REC_ERR_ARGUMENTS)
-			std::cerr << "[ERROR]: Not enough arguments! Sytax: recUpdater -k <APIKey> -d <domain> <subdomain1> <...>" << COLOR_DEFAULT << std::endl;
-		else
-			std::cerr << "[ERROR]: No API key and/or domain specified! Sytax: recUpdater -k <APIKey> -d <domain> <subdomain1> <...>" << COLOR_DEFAULT << std::endl;
+	// Constructor
+	SJsonValue() { eType = JSON_NULL; }
 
-		// Failure
-		return false;
+	// Get member of an object (NULL if missing)
+	const SJsonValue* member(const std::string& strKey) const
+	{
+		for (size_t i = 0; i < vecKeys.size(); i++)
+			if (vecKeys[i] == strKey)
+				return &vecItems[i];
+		return NULL;
 	}
 
+}; // Struct JsonValue
 
-	// Print to terminal  and try to load the config
-	std::cout << COLOR_GREEN << "OK" << COLOR_DEFAULT << std::endl;
-	std::cout << "Loading config... ";
-	iLoadRes = loadConfig(psConfigContents);
+// Struct IPServiceStats
+struct SIPServiceStats
+{
+	double dLatencyMs, dFailureRate;
+	uint32_t iRequests, iFailures;
 
-	// Check if loading failed
-	if (iLoadRes != CFG_ERR_NONE)
-	{
-		// Print to terminal
-		std::cout << COLOR_RED << "Failed" << COLOR_DEFAULT << std::endl;
+	// Constructor
+	SIPServiceStats() { dLatencyMs = 0; dFailureRate = 0; iRequests = 0; iFailures = 0; }
 
-		// Check if config is missing
-		if (iLoadRes == CFG_ERR_FILE)
-		{
-			// Print to terminal
-			std::cout << "Missing config. Generating new config with default settings... ";
+}; // Struct IPServiceStats
 
-			// Try to generate new config
-			if (!generateConfig())
-			{
-				// Print to terminal
-				std::cout << COLOR_RED << "Failed" << std::endl;
-				std::cerr << "[ERROR]: Cannot create config file: " << std::strerror(errno) << "." << COLOR_DEFAULT << std::endl;
+// Class HttpClient
+class CHttpClient
+{
+public:
+	// Constructor / Destructor
+	CHttpClient() { m_iMaxIdleHandles = HTTP_MAX_IDLE_HANDLES; m_pShare = NULL; }
+	~CHttpClient();
+
+	// Methods
+	void setMaxIdleHandles(size_t iMaxIdleHandles) { m_iMaxIdleHandles = iMaxIdleHandles; }
+	bool request(const char* cMethod, const std::string& strURL, const std::list<std::string>& lstHeaders, const std::string& strBody, uint16_t iTimeoutS, SHttpResponse* psResponse, long iIPResolve = CURL_IPRESOLVE_WHATEVER);
+	bool request(const SHttpRequest& sRequest, SHttpResponse* psResponse);
+	void race(const std::vector<SHttpRequest>& vecRequests, std::vector<SHttpResponse>* pvecResponses, std::function<void(size_t)> fnDone, std::function<bool(size_t)> fnRequired);
+
+private:
+	// Task groups share the handles and connections
+	friend class CTaskGroup;
+
+	// Methods
+	struct curl_slist* prepareHandle(CURL* pCurl, const SHttpRequest& sRequest, SHttpResponse* psResponse);
+	CURL* acquireHandle(const std::string& strPoolKey);
+	void releaseHandle(const std::string& strPoolKey, CURL* pCurl);
+	static void poolKey(const std::string& strURL, long iIPResolve, std::string* pstrKey);
+	static size_t writeCallback(char* cData, size_t iSize, size_t iCount, void* pUserData);
+	static size_t headerCallback(char* cData, size_t iSize, size_t iCount, void* pUserData);
+	static int progressCallback(void* pUserData, curl_off_t iDlTotal, curl_off_t iDlNow, curl_off_t iUlTotal, curl_off_t iUlNow);
+	static void lockCallback(CURL* pCurl, curl_lock_data iData, curl_lock_access iAccess, void* pUserData);
+	static void unlockCallback(CURL* pCurl, curl_lock_data iData, void* pUserData);
 
-				// Failure
-				return false;
-			}
-		}
-		// Check if attributes missing
-		else if (iLoadRes == CFG_ERR_ATTR_MISSING)
-		{
-			// Print to terminal and return
-			std::cerr << COLOR_RED << "[ERROR]: Missing attributes in config. Please correct it and try again." << COLOR_DEFAULT << std::endl;
-			return false;
-		}
-		// Syntax error
-		else
-		{
-			// Print to terminal and return
-			std::cerr << COLOR_RED << "[ERROR]: Syntax error in config. Please correct it and try again." << COLOR_DEFAULT << std::endl;
-			return false;
-		}
-	}
+	// Variables
+	std::mutex m_mtxPool;
+	std::map<std::string, std::vector<CURL*>> m_mapPool;
+	size_t m_iMaxIdleHandles;
+	CURLSH* m_pShare;
+	std::mutex m_mtxShare[CURL_LOCK_DATA_LAST];
 
+}; // Class HttpClient
 
-	// Print to terminal
-	std::cout << COLOR_GREEN << "OK" << COLOR_DEFAULT << std::endl;
+// Class TaskGroup (callbacks of all requests and timers run on the thread that calls run(), one at a time)
+class CTaskGroup
+{
+public:
+	// Constructor / Destructor
+	CTaskGroup(CHttpClient* pcHttpClient);
+	~CTaskGroup();
+
+	// Methods
+	void request(SHttpTransfer* psTransfer);
+	void after(std::chrono::steady_clock::time_point tWhen, std::function<void()> fnTask);
+	void run();
+	void cancel();
+	bool canceled() const { return m_bCanceled; }
+	size_t running() const { return m_iRunning; }
+
+private:
+	// Methods
+	void finish(CURL* pCurl, CURLcode iRes);
+	void unlink(SHttpTransfer* psTransfer);
 
-	// Check if logging is enabled
-	if (psConfigContents->bLogging)
-	{
-		// Print to terminal and try to open logfile
-		std::cout << "Opening logfile... ";
-		pcLogFile->open(LOG_FILE_PATH, std::ios_base::app);
+	// Variables
+	CHttpClient* m_pcHttpClient;
+	CURLM* m_pMulti;
+	SHttpTransfer* m_psTransfers;
+	size_t m_iRunning;
+	std::multimap<std::chrono::steady_clock::time_point, std::function<void()>> m_mapTimers;
+	bool m_bCanceled;
 
-		// Check if failed
-		if (pcLogFile->fail())
-		{
-			// Print to terminal
-			std::cout << COLOR_RED << "Failed" << COLOR_DEFAULT << std::endl;
-			std::cerr << COLOR_YELLOW << "[WARNING]: Cannot open logfile: " << std::strerror(errno) << ". Logging disabled." << COLOR_DEFAULT << std::endl;
+}; // Class TaskGroup
 
-			// Close file and disable logging
-			pcLogFile->close();
-			psConfigContents->bLogging = false;
-		}
-		// Success
-		else
-		{
-			// Print to terminal
-			std::cout << COLOR_GREEN << "OK" << COLOR_DEFAULT << std::endl;
-		}
-	}
-	// Logging disabled
-	else
-	{
-		// Print to terminal
-		std::cout << "[Config]: Logging disabled." << std::endl;
-	}
+// Class IPServiceStats
+class CIPServiceStats
+{
+public:
+	// Methods
+	std::vector<std::string> rank(const std::vector<std::string>& vecServices, long iIPResolve);
+	void record(const std::string& strService, long iIPResolve, double dTimeMs, bool bSuccess, bool bCanceled = false);
+	std::map<std::string, SIPServiceStats> snapshot();
 
-	// Success
-	return true;
+private:
+	// Variables
+	std::mutex m_mtxStats;
+	std::map<std::string, SIPServiceStats> m_mapStats;
 
-} // setup
+}; // Class IPServiceStats
 
-//
-// domRecordsFromCmdLine
-//
-// Task: Get records from command line
-//
-uint8_t domRecordsFromCmdLine(std::list<SDomRecords> *plstDomRecords, int argc, char* argv[])
+// Class IPProvider
+class CIPProvider
 {
-	// Variables
-	SDomRecords sCurRecord;
+public:
+	// Constructor / Destructor
+	virtual ~CIPProvider() {}
 
+	// Methods (a family whose pointer is NULL is not required)
+	virtual bool read(const SConfigContents& sConfigContents, std::string* pstrIPv4, std::string* pstrIPv6) = 0;
 
-	// Check if not enough start parameters have been passed
-	if (argc < 6)
-		return REC_ERR_ARGUMENTS;
+}; // Class IPProvider
 
-	// Run through all start parameters
-	for (uint8_t i = 1; i < argc; i++)
-	{
-		// Check whether it is a signal sign
-		if (argv[i][0] == '-')
-		{
-			// Clear subdomains and increase iterator
-			sCurRecord.lstSubDomains.clear();
-			i++;
+// Class HttpIPProvider
+class CHttpIPProvider : public CIPProvider
+{
+public:
+	// Constructor
+	CHttpIPProvider(CHttpClient* pcHttpClient, CIPServiceStats* pcIPServiceStats) { m_pcHttpClient = pcHttpClient; m_pcIPServiceStats = pcIPServiceStats; }
 
-			// Check whether there are not enough parameters
-			if (argc < (i + 2))
-				return REC_ERR_ARGUMENTS;
+	// Methods
+	bool read(const SConfigContents& sConfigContents, std::string* pstrIPv4, std::string* pstrIPv6) override;
 
-			switch (argv[i - 1][1])
-			{
-				// API key
-				case 'K':
-				case 'k':
-					// Clear domain and assign API key
-					sCurRecord.strDomain.clear();
-					sCurRecord.strAPIKey = argv[i];
-					break;
+private:
+	// Variables
+	CHttpClient* m_pcHttpClient;
+	CIPServiceStats* m_pcIPServiceStats;
 
-				// Domain
-				case 'D':
-				case 'd':
-					// Assign domain
-					sCurRecord.strDomain = argv[i];
-					break;
+}; // Class HttpIPProvider
 
-				// Error
-				default:
-					return REC_ERR_SPECIFER;
-			}
-		}
-		// No signal sign
-		else
-		{
-			// Check if record is valid
-			if ((sCurRecord.strAPIKey.length() == 0) || (sCurRecord.strDomain.length() == 0))
-				return REC_ERR_APIDOM;
+// Class InterfaceIPProvider
+class CInterfaceIPProvider : public CIPProvider
+{
+public:
+	// Methods
+	bool read(const SConfigContents& sConfigContents, std::string* pstrIPv4, std::string* pstrIPv6) override;
+	static bool isExcluded(uint8_t iFamily, const unsigned char* cAddr, uint32_t iFlags, uint8_t iExclude);
 
-			// Add current record to list
-			sCurRecord.lstSubDomains.push_back(argv[i]);
+private:
+	// Variables
+	std::string m_strLast[2];
 
-			// Add record to list
-			if ((argc == (i + 1)) || ((argc > (i + 1)) && (argv[i + 1][0] == '-')))
-				plstDomRecords->push_back(sCurRecord);
-		}
-	}
+}; // Class InterfaceIPProvider
 
-	// Success
-	return REC_ERR_NONE;
+// Struct ZoneCacheEntry
+struct SZoneCacheEntry
+{
+	std::string strETag;
+	SJsonValue sZone;
 
-} // domRecordsFromCmdLine
+}; // Struct ZoneCacheEntry
 
-//
-// timeStamp
-//
-// Task: Get timastemp
-//
-std::string timeStamp()
+// Class ZoneCache
+class CZoneCache
 {
+public:
+	// Methods
+	void prepareRead(const SDomRecords* psDomRecords, SHttpRequest* psRequest);
+	bool readResult(const SDomRecords* psDomRecords, bool bSent, const SHttpResponse& sResponse, SJsonValue* psZone, std::string* pstrErrorMsg);
+
+private:
 	// Variables
-	time_t tTime;
-	tm* ptCurTime;
-	char cTimeStamp[SMALL_BUFFER];
+	std::mutex m_mtxZones;
+	std::map<std::string, SZoneCacheEntry> m_mapZones;
 
+}; // Class ZoneCache
 
-	// Get current time
-	tTime = time(NULL);
-	ptCurTime = localtime(&tTime);
+// Struct PendingUpdate
+struct SPendingUpdate
+{
+	std::list<SDomRecords>::iterator iRec;
+	std::string strErrorMsg;
+	std::set<std::string> setRRSets;
+	bool bVerifyOnly, bResult;
+
+	// Context of the update task (set when it is started)
+	const SConfigContents* psConfigContents;
+	const std::string* pstrIPs[2];
+	CTaskGroup* pcTasks;
+	CZoneCache* pcZoneCache;
+	std::function<void(SPendingUpdate*)>* pfnDone;
+	uint64_t iGeneration;
+
+	// Progress of the update task
+	enum EStage { STAGE_BATCH_READ, STAGE_BATCH_WRITE, STAGE_READ, STAGE_WRITE } eStage;
+	SJsonValue sZone;
+	std::vector<std::pair<const SSubDomain*, const char*>> vecWrites;
+	size_t iNextWrite, iManaged;
+	std::string strKey;
 
-	// Format string and return result
-	sprintf(cTimeStamp, "[%.2i.%.2i.%i | %.2i:%.2i] ", ptCurTime->tm_mday, (ptCurTime->tm_mon + 1), (ptCurTime->tm_year + 1900), ptCurTime->tm_hour, ptCurTime->tm_min);
-	return cTimeStamp;
+	// Constructor
+	SPendingUpdate() { bVerifyOnly = false; bResult = false; psConfigContents = NULL; pstrIPs[0] = NULL; pstrIPs[1] = NULL; pcTasks = NULL; pcZoneCache = NULL; pfnDone = NULL; iGeneration = 0; eStage = STAGE_WRITE; iNextWrite = 0; iManaged = 0; }
 
-} // timeStamp
+}; // Struct PendingUpdate
 
-//
-// exec
-//
-// Task: Execute command and return result as string
-//
-std::string exec(const char* cCmd)
+// Struct DnsServer
+struct SDnsServer
 {
-	// Variables
-	char cBuffer[SMALL_BUFFER] = "";
-	std::string strResult;
-	FILE *pPipe = popen(cCmd, "r");
-
+	struct sockaddr_storage sAddr;
+	socklen_t iAddrLen;
 
-	// Check for failure
-	if (!pPipe)
-		return NULL;
+}; // Struct DnsServer
 
-	// Get result
-	while (fgets(cBuffer, sizeof(cBuffer), pPipe) != NULL)
-		strResult.append(cBuffer);
+// Struct DnsQuery
+struct SDnsQuery
+{
+	std::string strName;
+	uint16_t iType;
+	const SDnsServer* psServer;
+	std::vector<std::string> vecAnswers;
+	bool bAnswered;
 
-	// Close pipe and return result
-	pclose(pPipe);
-	return strResult;
+}; // Struct DnsQuery
 
-} // exec
+// Struct DnsCheck
+struct SDnsCheck
+{
+	SDomRecords* psDomRecords;
+	std::string strRRSet, strValue;
+	bool bAnswered, bConfirmed;
 
+}; // Struct DnsCheck
 
-//
-// readIPAddress
-//
-// Task: Get IP address of system
-//
-bool readIPAddress(std::string *pstrIPv4, std::string *pstrIPv6, SConfigContents sConfigContens)
+// Class DnsClient
+class CDnsClient
 {
-	// Variables
-	char cCommand[SMALL_BUFFER];
+public:
+	// Constructor/Destructor
+	CDnsClient() : m_cRandom(std::random_device{}()) { m_iSocket[0] = -1; m_iSocket[1] = -1; }
+	~CDnsClient() { for (int iSocket : m_iSocket) if (iSocket != -1) close(iSocket); }
 
+	// Methods
+	bool resolve(std::vector<SDnsQuery>* pvecQueries, uint32_t iTimeoutMs);
+	static bool parseServer(const std::string& strServer, SDnsServer* psServer);
+	static std::string encodeQuery(uint16_t iID, const std::string& strName, uint16_t iType);
+	static bool decodeResponse(const unsigned char* cPacket, size_t iLength, uint16_t* piID, std::string* pstrName, uint16_t* piType, std::vector<std::string>* pvecAnswers);
 
-	// Format and execute command
-	sprintf(cCommand, "curl -m %i -s4 %s", sConfigContens.iCurlTimeout, sConfigContens.strIPService.c_str());
-	*pstrIPv4 = exec(cCommand);
+private:
+	// Methods
+	static bool readName(const unsigned char* cPacket, size_t iLength, size_t* piPos, std::string* pstrName);
 
-	// Remove newline specifier if required
-	if (pstrIPv4->length() > 0)
-		pstrIPv4->pop_back();
+	// Variables
+	int m_iSocket[2];
+	std::mt19937 m_cRandom;
 
-	// Check if IPv6 support is enabled
-	if (sConfigContens.bEnableIPv6)
-	{
-		// Format and execute command
-		sprintf(cCommand, "curl -m %i -s6 %s", sConfigContens.iCurlTimeout, sConfigContens.strIPService.c_str());
-		*pstrIPv6 = exec(cCommand);
+}; // Class DnsClient
 
-		// Remove newline specifier if required
-		if (pstrIPv6->length() > 0)
-			pstrIPv6->pop_back();
-	}
+// Struct PublishedRRSet
+struct SPublishedRRSet
+{
+	std::string strValue;
+	uint16_t iTTL;
+	time_t tPublished;
 
-	// Check if the IP address could not be loaded
-	if ((pstrIPv4->length() == 0) && (pstrIPv6->length() == 0))
-		return false;
+}; // Struct PublishedRRSet
 
-	// Success
+// Class StateStore
+class CStateStore
+{
+public:
+	// Constructor
+	CStateStore() { m_bDirty = false; }
+
+	// Methods
+	bool load(const char* cPath);
+	bool save(const char* cPath);
+	bool isPublished(const SDomRecords& sDomRecords, const SConfigContents& sConfigContents, const std::string& strIPv4, const std::string& strIPv6, time_t* ptPublished);
+	void setPublished(const std::string& strDomain, const std::string& strSubDomain, const std::string& strType, const std::string& strValue, uint16_t iTTL, time_t tPublished);
+
+private:
+	// Methods
+	static std::string key(const std::string& strDomain, const std::string& strSubDomain, const char* cType);
+	bool matches(const std::string& strKey, const std::string& strValue, uint16_t iTTL, time_t* ptPublished);
+
+	// Variables
+	std::unordered_map<std::string, SPublishedRRSet> m_mapRRSets;
+	bool m_bDirty;
+
+}; // Class StateStore
+
+// Struct JournalEntry
+struct SJournalEntry
+{
+	std::string strValue;
+	uint16_t iTTL;
+	time_t tDesired;
+
+}; // Struct JournalEntry
+
+// Class Journal
+class CJournal
+{
+public:
+	// Constructor/Destructor
+	CJournal() { m_iFile = -1; m_iLines = 0; m_bCompact = false; }
+	~CJournal() { if (m_iFile != -1) close(m_iFile); }
+
+	// Methods
+	bool open(const char* cPath);
+	void want(const SDomRecords& sDomRecords, const std::set<std::string>& setRRSets, const std::string& strIPv4, const std::string& strIPv6);
+	void done(const std::string& strDomain, const std::string& strSubDomain, const std::string& strType);
+	void drop(const SDomRecords& sDomRecords);
+	void prune(const std::list<SDomRecords>& lstRecords);
+	bool flush();
+	bool latest(const char* cType, std::string* pstrValue);
+	size_t size() { return m_mapEntries.size(); }
+
+private:
+	// Methods
+	bool compact();
+
+	// Variables
+	std::unordered_map<std::string, SJournalEntry> m_mapEntries;
+	std::string m_strPath, m_strBuffer;
+	size_t m_iLines;
+	int m_iFile;
+	bool m_bCompact;
+
+}; // Class Journal
+
+// Struct RetryEntry
+struct SRetryEntry
+{
+	std::chrono::steady_clock::time_point tDue;
+	SDomRecords* psDomRecords;
+	std::string strRRSet;
+
+	// Order by due time
+	bool operator>(const SRetryEntry& sOther) const { return (tDue > sOther.tDue); }
+
+}; // Struct RetryEntry
+
+// Class RetryScheduler
+class CRetryScheduler
+{
+public:
+	// Constructor
+	CRetryScheduler() : m_cRandom(std::random_device()()) { m_iBaseS = CFG_DEF_RETRY_BASE_S; m_iMaxS = CFG_DEF_RETRY_MAX_S; }
+
+	// Methods
+	void configure(uint16_t iBaseS, uint16_t iMaxS) { m_iBaseS = iBaseS; m_iMaxS = iMaxS; }
+	std::chrono::steady_clock::time_point schedule(SDomRecords* psDomRecords, const std::string& strRRSet, uint16_t iAttempts, std::chrono::steady_clock::time_point tNow);
+	std::chrono::steady_clock::time_point defer(SDomRecords* psDomRecords, const std::string& strRRSet, std::chrono::steady_clock::time_point tDue);
+	std::map<SDomRecords*, std::set<std::string>> popDue(std::chrono::steady_clock::time_point tNow);
+	bool nextDue(std::chrono::steady_clock::time_point* ptNext);
+	void remove(const SDomRecords* psDomRecords);
+
+private:
+	// Variables
+	std::priority_queue<SRetryEntry, std::vector<SRetryEntry>, std::greater<SRetryEntry>> m_queEntries;
+	std::mt19937 m_cRandom;
+	uint16_t m_iBaseS, m_iMaxS;
+
+}; // Class RetryScheduler
+
+// Class PollScheduler
+class CPollScheduler
+{
+public:
+	// Constructor
+	CPollScheduler() { m_bAdaptive = CFG_DEF_ADAPTIVE_POLLING; m_bDirty = false; m_iBaseS = m_iIntervalS = CFG_DEF_UPDATE_PERIOD_S; m_iMinS = m_iRetryS = CFG_DEF_POLL_MIN_S; m_iMaxS = CFG_DEF_POLL_MAX_S; m_iFailures = 0; m_cReason = "default"; m_tStart = time(NULL); }
+
+	// Methods
+	void configure(bool bAdaptive, uint16_t iBaseS, uint16_t iRetryS, uint16_t iMinS, uint16_t iMaxS) { m_bAdaptive = bAdaptive; m_iBaseS = iBaseS; m_iRetryS = std::max<uint16_t>(iRetryS, 1); m_iMinS = iMinS; m_iMaxS = iMaxS; }
+	void changed(uint8_t iFamily, time_t tNow);
+	void polled(bool bSuccess) { m_iFailures = (bSuccess ? 0 : (m_iFailures + 1)); }
+	uint32_t next(time_t tNow);
+	uint32_t interval() const { return m_iIntervalS; }
+	const char* reason() const { return m_cReason; }
+	size_t size() const { return (m_deqChanges[0].size() + m_deqChanges[1].size()); }
+	bool load(const char* cPath);
+	bool save(const char* cPath);
+
+private:
+	// Methods
+	uint32_t retryInterval(uint32_t iIntervalS) const;
+	uint32_t familyInterval(const std::deque<time_t>& deqChanges, time_t tNow, uint32_t iIntervalS);
+	static time_t median(std::vector<time_t> vecValues);
+
+	// Variables
+	std::deque<time_t> m_deqChanges[2];
+	bool m_bAdaptive, m_bDirty;
+	uint16_t m_iBaseS, m_iRetryS, m_iMinS, m_iMaxS;
+	uint32_t m_iFailures, m_iIntervalS;
+	const char* m_cReason;
+	time_t m_tStart;
+
+}; // Class PollScheduler
+
+// Class Cluster
+class CCluster
+{
+public:
+	// Constructor
+	CCluster() { m_iTimer = -1; m_iLeaseS = CFG_DEF_CLUSTER_LEASE_S; m_tJoined = 0; m_tRenewed = 0; m_bActive = false; }
+
+	// Methods
+	bool start(const std::string& strDir, const std::string& strNode, uint16_t iLeaseS, std::string* pstrErrorMsg);
+	void stop();
+	bool process();
+	const std::string* owner(const std::string& strDomain, const std::string& strSubDomain) const;
+	bool owns(const std::string& strDomain, const std::string& strSubDomain) const;
+	const char* state() const;
+	bool enabled() const { return (m_iTimer >= 0); }
+	int fd() const { return m_iTimer; }
+	const std::string& node() const { return m_strNode; }
+	const std::vector<std::string>& nodes() const { return m_vecNodes; }
+	uint64_t generation() const { return m_iGeneration.load(std::memory_order_relaxed); }
+
+private:
+	// Methods
+	bool renew(time_t tNow);
+	static uint64_t hash(const std::string& strValue);
+
+	// Variables
+	std::string m_strDir, m_strNode, m_strPath;
+	std::vector<std::string> m_vecNodes;
+	std::vector<std::pair<uint64_t, size_t>> m_vecRing;
+	std::atomic<uint64_t> m_iGeneration{0};
+	time_t m_tJoined, m_tRenewed;
+	uint16_t m_iLeaseS;
+	int m_iTimer;
+	bool m_bActive;
+
+}; // Class Cluster
+
+// Struct RateBucket
+struct SRateBucket
+{
+	double dTokens, dRate;
+	std::chrono::steady_clock::time_point tRefill, tBlocked;
+	uint32_t iInFlight;
+
+}; // Struct RateBucket
+
+// Class RateLimiter
+class CRateLimiter
+{
+public:
+	// Constructor
+	CRateLimiter() { m_dMaxRate = (CFG_DEF_API_RATE_LIMIT / 60.0); m_dBurst = CFG_DEF_API_BURST; }
+
+	// Methods
+	void configure(uint16_t iPerMinute, uint16_t iBurst);
+	bool acquire(const std::string& strAPIKey);
+	bool tryAcquire(const std::string& strAPIKey, std::chrono::steady_clock::time_point* ptReady);
+	void update(const std::string& strAPIKey, const SHttpResponse& sResponse);
+	size_t budget(const std::string& strAPIKey, std::chrono::steady_clock::time_point* ptReady);
+
+private:
+	// Methods
+	SRateBucket* bucket(const std::string& strAPIKey, std::chrono::steady_clock::time_point tNow);
+	bool take(const std::string& strAPIKey, std::chrono::steady_clock::time_point tNow, std::chrono::steady_clock::time_point* ptReady);
+
+	// Variables
+	std::mutex m_mtxBuckets;
+	std::condition_variable m_condBuckets;
+	std::unordered_map<std::string, SRateBucket> m_mapBuckets;
+	double m_dMaxRate, m_dBurst;
+
+}; // Class RateLimiter
+
+// Class RecordTable
+class CRecordTable
+{
+public:
+	// Methods
+	bool add(const std::string& strAPIKey, const std::string& strDomain, const SSubDomain& sSubDomain);
+	bool remove(const std::string& strDomain, const std::string& strSubDomain, std::function<void(SDomRecords*)> fnRemove);
+	SSubDomain* find(const std::string& strDomain, const std::string& strSubDomain);
+	SDomRecords* findZone(const std::string& strDomain);
+	static bool parseSubDomain(const std::vector<std::string>& vecFields, SSubDomain* psSubDomain, std::string* pstrErrorMsg);
+	uint8_t loadDirectory(const char* cPath, std::string* pstrErrorMsg);
+	void applyDefaultTTL(uint16_t iTTL);
+	std::map<SDomRecords*, std::set<std::string>> merge(CRecordTable* pcNew, std::function<void(SDomRecords*)> fnRemove, size_t* piRemoved);
+	std::list<SDomRecords>& records() { return m_lstRecords; }
+	size_t size() const { return m_mapSubDomains.size(); }
+	size_t duplicates() const { return m_iDuplicates; }
+	size_t shared() const { return m_iShared; }
+
+private:
+	// Methods
+	uint8_t loadFile(const std::string& strPath, std::string* pstrErrorMsg);
+	void countZone(const std::string& strDomain, int iDelta);
+
+	// Variables
+	std::list<SDomRecords> m_lstRecords;
+	std::unordered_map<std::string, SDomRecords*> m_mapDomains;
+	std::unordered_map<std::string, SSubDomain*> m_mapSubDomains;
+	std::unordered_map<std::string, size_t> m_mapZones;
+	size_t m_iDuplicates = 0, m_iShared = 0;
+
+}; // Class RecordTable
+
+// Class WorkerPool
+class CWorkerPool
+{
+public:
+	// Constructor / Destructor
+	CWorkerPool(size_t iWorkers, std::function<void()> fnNotify = nullptr);
+	~CWorkerPool();
+
+	// Methods
+	std::future<bool> submit(std::function<bool()> fnTask);
+
+private:
+	// Methods
+	void run();
+
+	// Variables
+	std::mutex m_mtxQueue;
+	std::condition_variable m_condQueue;
+	std::queue<std::packaged_task<bool()>> m_queTasks;
+	std::vector<std::thread> m_vecWorkers;
+	std::function<void()> m_fnNotify;
+	bool m_bStop;
+
+}; // Class WorkerPool
+
+// Class NetlinkWatcher
+class CNetlinkWatcher
+{
+public:
+	// Constructor / Destructor
+	CNetlinkWatcher() { m_iSocket = -1; }
+	~CNetlinkWatcher();
+
+	// Methods
+	bool start();
+	int fd() const { return m_iSocket; }
+	bool process();
+
+private:
+	// Methods
+	bool isRelevant(const char* cBuffer, ssize_t iLength);
+
+	// Variables
+	int m_iSocket;
+
+}; // Class NetlinkWatcher
+
+// Class ConfigWatcher
+class CConfigWatcher
+{
+public:
+	// Constructor / Destructor
+	CConfigWatcher() { m_iFd = -1; m_iConfigDir = -1; m_iRecordsDir = -1; }
+	~CConfigWatcher();
+
+	// Methods
+	bool start();
+	int fd() const { return m_iFd; }
+	bool process();
+
+private:
+	// Variables
+	int m_iFd, m_iConfigDir, m_iRecordsDir;
+
+}; // Class ConfigWatcher
+
+// Class EventLoop
+class CEventLoop
+{
+public:
+	// Constructor / Destructor
+	CEventLoop() { m_iEpoll = -1; m_iTimer = -1; m_iSignal = -1; m_iWake = -1; }
+	~CEventLoop();
+
+	// Methods
+	bool init();
+	bool watch(int iFd, std::function<void()> fnReadable);
+	bool watchWritable(int iFd);
+	void setTimer(std::chrono::steady_clock::time_point tExpire);
+	void wake();
+	uint8_t run();
+	void unwatch(int iFd);
+
+private:
+	// Variables
+	int m_iEpoll, m_iTimer, m_iSignal, m_iWake;
+	std::map<int, std::function<void()>> m_mapWatches;
+
+}; // Class EventLoop
+
+// Class Metrics
+class CMetrics
+{
+public:
+	// Methods
+	void init(const std::vector<std::string>& vecServices);
+	void countLookup(const std::string& strService, long iIPResolve, double dTimeMs, bool bSuccess, bool bCanceled);
+	void countRequest(const SDomRecords* psDomRecords, const SHttpResponse& sResponse);
+	std::string render(const std::list<SDomRecords>& lstRecords);
+
+	// Variables
+	std::atomic<uint64_t> iPolls{0}, iPollFailures{0}, iAddressChanges{0}, iPushes{0}, iCrossCheckMismatches{0}, iRateLimited{0}, iRateDeferred{0}, iJournalPending{0}, iDNSConfirmed{0}, iDNSUnconfirmed{0}, iDNSRequeued{0}, iHttp2Requests{0}, iConnections{0}, iPollIntervalS{0}, iClusterNodes{0}, iClusterOwned{0};
+
+private:
+	// Methods
+	static std::string label(const std::string& strValue);
+	static void renderHistogram(std::string* pstrResult, const char* cName, const std::string& strLabels, const SHistogram& sHistogram);
+
+	// Variables
+	std::map<std::string, std::unique_ptr<SLookupMetrics>> m_mapLookups;
+	SHistogram m_sRequestLatency;
+
+}; // Class Metrics
+
+// Class HttpServer
+class CHttpServer
+{
+public:
+	// Constructor / Destructor
+	CHttpServer() { m_iSocket = -1; m_iTimer = -1; m_pcEventLoop = NULL; }
+	~CHttpServer();
+
+	// Methods
+	bool start(const std::string& strAddress, uint16_t iPort, CEventLoop* pcEventLoop, std::function<int(const std::string&, std::string*, std::string*)> fnHandle);
+
+private:
+	// Methods
+	void accept();
+	void serve(int iClient);
+	void expire();
+	void arm();
+	void drop(int iClient);
+
+	// Variables
+	int m_iSocket, m_iTimer;
+	CEventLoop* m_pcEventLoop;
+	std::function<int(const std::string&, std::string*, std::string*)> m_fnHandle;
+	std::map<int, SHttpConnection> m_mapClients;
+
+}; // Class HttpServer
+
+// Class ControlServer
+class CControlServer
+{
+public:
+	// Constructor / Destructor
+	CControlServer() { m_iSocket = -1; m_pcEventLoop = NULL; }
+	~CControlServer();
+
+	// Methods
+	bool start(const std::string& strPath, CEventLoop* pcEventLoop);
+	bool pending() const { return !m_lstRequests.empty(); }
+	void process(std::function<std::string(const std::vector<std::string>&)> fnHandle);
+
+private:
+	// Methods
+	void accept();
+	void serve(int iClient);
+	void drop(int iClient);
+
+	// Variables
+	int m_iSocket;
+	std::string m_strPath;
+	CEventLoop* m_pcEventLoop;
+	std::map<int, std::string> m_mapClients;
+	std::list<std::pair<int, std::string>> m_lstRequests;
+
+}; // Class ControlServer
+
+// Struct LogRecord
+struct SLogRecord
+{
+	std::atomic<size_t> iSequence;
+	time_t tTime;
+	uint8_t iLevel;
+	char cMessage[LOG_MESSAGE_SIZE];
+
+}; // Struct LogRecord
+
+// Class Logger
+class CLogger
+{
+public:
+	// Constructor / Destructor
+	CLogger() { m_iFd = -1; m_iTail = 0; m_iSize = 0; m_iMaxSize = 0; m_iRotateFiles = 0; m_bJson = false; m_tStamp = -1; }
+	~CLogger() { close(); }
+
+	// Methods
+	bool open(const char* cPath, bool bJson, off_t iMaxSize, uint16_t iRotateFiles);
+	void close();
+	void log(uint8_t iLevel, const char* cFormat, ...) __attribute__((format(printf, 3, 4)));
+	uint64_t dropped() { return m_iDroppedTotal; }
+
+private:
+	// Methods
+	void run();
+	void append(const SLogRecord& sRecord, std::string* pstrBatch);
+	void write(const std::string& strBatch);
+	void rotate();
+
+	// Variables
+	std::unique_ptr<SLogRecord[]> m_psRing;
+	std::atomic<size_t> m_iHead{0};
+	std::atomic<uint64_t> m_iDropped{0}, m_iDroppedTotal{0};
+	std::atomic<bool> m_bOpen{false}, m_bStop{false};
+	size_t m_iTail;
+	int m_iFd;
+	off_t m_iSize, m_iMaxSize;
+	uint16_t m_iRotateFiles;
+	bool m_bJson;
+	std::string m_strPath;
+	std::thread m_thrWriter;
+	std::mutex m_mtxWake;
+	std::condition_variable m_condWake;
+	time_t m_tStamp;
+	std::string m_strStamp;
+
+}; // Class Logger
+
+// Struct MockRRSet
+struct SMockRRSet
+{
+	std::string strName, strType;
+	uint32_t iTTL;
+	std::vector<std::string> vecValues, vecPrevious;
+	time_t tChanged = 0;
+
+}; // Struct MockRRSet
+
+// Struct MockZone
+struct SMockZone
+{
+	uint64_t iVersion = 0;
+	std::map<std::string, SMockRRSet> mapRRSets;
+
+}; // Struct MockZone
+
+// Class MockServer
+class CMockServer
+{
+public:
+	// Constructor
+	CMockServer(uint16_t iLatencyMs, double dErrorRate, double dLimitRate, uint32_t iPerMinute = 0, uint32_t iPropagationS = 0) { m_iSocket = -1; m_iDnsSocket = -1; m_iLatencyMs = iLatencyMs; m_dErrorRate = dErrorRate; m_dLimitRate = dLimitRate; m_iPerMinute = iPerMinute; m_iPropagationS = iPropagationS; m_strAddress = MOCK_DEF_ADDRESS; }
+
+	// Methods
+	bool listen(uint16_t iPort);
+	uint16_t port();
+	void run();
+
+private:
+	// Methods
+	void serve(int iClient);
+	void serveDns();
+	int handle(const std::string& strMethod, const std::string& strPath, const std::string& strIfNoneMatch, const std::string& strAPIKey, const std::string& strBody, std::string* pstrResponse, std::string* pstrHeaders);
+	bool limit(const std::string& strAPIKey, std::string* pstrHeaders);
+
+	// Variables
+	int m_iSocket, m_iDnsSocket;
+	uint16_t m_iLatencyMs;
+	double m_dErrorRate, m_dLimitRate;
+	uint32_t m_iPerMinute, m_iPropagationS;
+	std::mutex m_mtxZones;
+	std::map<std::string, SMockZone> m_mapZones;
+	std::map<std::string, std::pair<time_t, uint32_t>> m_mapWindows;
+	std::string m_strAddress;
+
+}; // Class MockServer
+
+
+// Function prototypes
+bool setup(SConfigContents* psConfigContents, CRecordTable* pcRecordTable, int argc, char* argv[], CEventLoop* pcEventLoop);
+std::string timeStamp();
+bool loadSnapshot(SConfigContents* psConfigContents, CRecordTable* pcRecordTable, int argc, char* argv[], std::string* pstrErrorMsg);
+void reloadConfig(SConfigContents* psConfigContents, CRecordTable* pcRecordTable, CRecordTable* pcRuntimeRecords, const std::set<std::string>& setRuntimeRemoved, CRetryScheduler* pcRetryScheduler, CPollScheduler* pcPollScheduler, CJournal* pcJournal, std::map<std::string, std::vector<SDnsServer>>* pmapNameServers, bool bIPKnown, const std::string& strIPv4, const std::string& strIPv6, std::chrono::steady_clock::time_point tNow, std::chrono::steady_clock::time_point* ptNextPoll, int argc, char* argv[]);
+bool keepStartupSettings(SConfigContents* psNewConfig, const SConfigContents& sConfigContents);
+std::string handleControlCommand(const std::vector<std::string>& vecArgs, const SConfigContents& sConfigContents, CRecordTable* pcRecordTable, CRecordTable* pcRuntimeRecords, std::set<std::string>* psetRuntimeRemoved, CRetryScheduler* pcRetryScheduler, const CPollScheduler& cPollScheduler, CJournal* pcJournal, bool bIPKnown, const std::string& strIPv4, const std::string& strIPv6, bool* pbPaused, std::chrono::steady_clock::time_point* ptNextPoll);
+int handlePushRequest(const std::string& strRequest, const SConfigContents& sConfigContents, const std::string& strLastIPv4, const std::string& strLastIPv6, std::string* pstrPushIPv4, std::string* pstrPushIPv6, bool* pbPush, std::string* pstrHeaders, std::string* pstrBody);
+void dropForeign(SDomRecords* psDomRecords, std::set<std::string>* psetRRSets, CJournal* pcJournal);
+void applyOwners(std::list<SDomRecords>* plstRecords, const SConfigContents& sConfigContents, CRetryScheduler* pcRetryScheduler, CJournal* pcJournal, bool bIPKnown, const std::string& strIPv4, const std::string& strIPv6, std::chrono::steady_clock::time_point tNow);
+uint8_t domRecordsFromCmdLine(CRecordTable* pcRecordTable, int argc, char* argv[]);
+bool readIPAddress(std::string *pstrIPv4, std::string* pstrIPv6, SConfigContents sConfigContens, CHttpClient* pcHttpClient, CIPServiceStats* pcIPServiceStats);
+bool resolveIPAddress(const std::map<std::string, CIPProvider*>& mapProviders, const SConfigContents& sConfigContents, bool bCrossCheck, std::string* pstrIPv4, std::string* pstrIPv6);
+std::vector<std::string> splitList(const std::string& strList, char cSeparator);
+void updateRecords(std::list<SPendingUpdate>* plstPending, const SConfigContents& sConfigContents, const std::string& strIPv4, const std::string& strIPv6, CHttpClient* pcHttpClient, CZoneCache* pcZoneCache, std::function<void(SPendingUpdate*)> fnDone = nullptr);
+void updateRecord(SPendingUpdate* psPending);
+void updateSingle(SPendingUpdate* psPending);
+void answerRecord(SPendingUpdate* psPending, bool bSent);
+void stepRecord(SPendingUpdate* psPending, bool bSent);
+void writeRecord(SPendingUpdate* psPending, bool bZone);
+void writeNext(SPendingUpdate* psPending);
+void checkWrite(SPendingUpdate* psPending, bool bSent);
+void finishRecord(SPendingUpdate* psPending);
+void compileTemplate(SDomRecords* psDomRecords, const SConfigContents& sConfigContents);
+std::set<std::string> rrsetKeys(const SDomRecords& sDomRecords, const SConfigContents& sConfigContents, const std::string& strIPv6);
+void writeZone(SPendingUpdate* psPending);
+std::unordered_map<std::string, const SJsonValue*> indexZone(const SJsonValue& sZone);
+bool rrsetMatches(const std::unordered_map<std::string, const SJsonValue*>& mapZone, const std::string& strName, const char* cType, const std::string& strValue, uint16_t iTTL);
+bool scanJsonString(const std::string& strText, const char* cKey, size_t* piStart, size_t* piLength);
+bool containsNoCase(const char* cText, size_t iLength, const std::string& strWord);
+bool parseJson(const std::string& strText, SJsonValue* psValue);
+bool parseJsonValue(const std::string& strText, size_t* piPos, SJsonValue* psValue, uint8_t iDepth);
+bool decodeJsonUnicode(const std::string& strText, size_t* piPos, std::string* pstrResult);
+std::string jsonEscape(const std::string& strText);
+bool parsePushRequest(const std::string& strRequest, std::map<std::string, std::string>* pmapQuery);
+std::string urlDecode(const std::string& strText);
+std::string base64Decode(const std::string& strText);
+bool tokenMatches(const std::string& strGiven, const std::string& strToken);
+bool apiRequest(const SDomRecords* psDomRecords, const char* cMethod, const std::string& strURL, const std::list<std::string>& lstHeaders, const std::string& strBody, const SConfigContents& sConfigContents, CHttpClient* pcHttpClient, SHttpResponse* psResponse);
+void sendRequest(SPendingUpdate* psPending);
+bool lookupNameServers(const SDomRecords* psDomRecords, const SConfigContents& sConfigContents, CHttpClient* pcHttpClient, std::vector<SDnsServer>* pvecServers, std::string* pstrErrorMsg);
+bool confirmRecords(std::vector<SDnsCheck>* pvecChecks, const SConfigContents& sConfigContents, CHttpClient* pcHttpClient, CDnsClient* pcDnsClient, std::map<std::string, std::vector<SDnsServer>>* pmapNameServers);
+uint8_t loadConfig(SConfigContents* psConfigContents);
+bool assignOptionalAttr(SConfigContents* psConfigContents, const std::string& strKey, const std::string& strValue, const std::string& strRawValue, bool* pbSyntaxError);
+bool parseBool(const std::string& strValue, bool* pbResult);
+bool generateConfig();
+int runBenchmark(int argc, char* argv[]);
+int benchRecords(size_t iAmount);
+int benchLogging(size_t iLines);
+int benchIPProvider(size_t iReads);
+int benchUpdates(size_t iDomains, size_t iSubDomains, size_t iCycles, uint16_t iLatencyMs, double dErrorRate, double dLimitRate, uint32_t iPerMinute);
+int benchAllocations(size_t iUpdates);
+int runMock(int argc, char* argv[]);
+int runControl(int argc, char* argv[]);
+double percentile(std::vector<double>* pvecValues, double dRank);
+size_t residentMemoryKiB();
+
+// Global variables
+volatile sig_atomic_t g_sigInterrupt = 0;
+CMetrics g_cMetrics;
+CLogger g_cLogger;
+CRateLimiter g_cRateLimiter;
+CCluster g_cCluster;
+std::atomic<uint64_t> g_iAllocations(0);
+
+
+// Main function
+int main(int argc, char* argv[])
+{
+	// Variables
+	SConfigContents sConfigContents;
+	CRecordTable cRecordTable;
+	std::list<SDomRecords>& lstRecords = cRecordTable.records();
+	CHttpClient cHttpClient;
+	CIPServiceStats cIPServiceStats;
+	CHttpIPProvider cHttpIPProvider(&cHttpClient, &cIPServiceStats);
+	CInterfaceIPProvider cInterfaceIPProvider;
+	std::map<std::string, CIPProvider*> mapIPProviders = { { IP_SOURCE_HTTP, &cHttpIPProvider }, { IP_SOURCE_INTERFACE, &cInterfaceIPProvider } };
+	CZoneCache cZoneCache;
+	CStateStore cStateStore;
+	CJournal cJournal;
+	CDnsClient cDnsClient;
+	std::map<std::string, std::vector<SDnsServer>> mapNameServers;
+	CRetryScheduler cRetryScheduler;
+	CPollScheduler cPollScheduler;
+	CEventLoop cEventLoop;
+	CNetlinkWatcher cNetlinkWatcher;
+	CConfigWatcher cConfigWatcher;
+	CHttpServer cMetricsServer, cPushServer;
+	CControlServer cControlServer;
+	CRecordTable cRuntimeRecords;
+	std::set<std::string> setRuntimeRemoved;
+	std::string strCurIPv4, strCurIPv6, strLastIPv4, strLastIPv6, strPushIPv4, strPushIPv6;
+	std::chrono::steady_clock::time_point tNextPoll = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point tReload, tNextCrossCheck, tNextConfirm = std::chrono::steady_clock::time_point::max();
+	bool bIPKnown = false, bReload = false, bPaused = false, bPush = false, bJournal = false, bClusterChanged = false;
+
+	// Process events until a result of the workers is ready (a hangup forces a reload and the next poll)
+	auto waitResult = [&cEventLoop, &tNextPoll, &tReload, &bReload](std::future<bool>* pftrResult) {
+		while (pftrResult->wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			if (cEventLoop.run() & EVT_HANGUP)
+			{
+				tNextPoll = tReload = std::chrono::steady_clock::now();
+				bReload = true;
+			}
+		return pftrResult->get();
+	};
+
+
+	// Send command to a running program instead if requested (without banner, the output may be parsed)
+	if ((argc >= 2) && (strcmp(argv[1], "--ctl") == 0))
+		return runControl(argc, argv);
+
+	// Print program infos
+	printf("[ARM] RecUpdater v.%.2f (Build %i)\n", VERSION, BUILD);
+
+	// Run benchmark or mock server instead if requested
+	if ((argc >= 2) && (strcmp(argv[1], "--bench") == 0))
+		return runBenchmark(argc, argv);
+	if ((argc >= 2) && (strcmp(argv[1], "--mock") == 0))
+		return runMock(argc, argv);
+
+	// Try to setupt everything
+	if (!setup(&sConfigContents, &cRecordTable, argc, argv, &cEventLoop))
+	{
+		// Print to terminal
+		std::cerr << COLOR_RED << "[ERROR]: Initalization has failed! Exiting program..." << COLOR_DEFAULT << std::endl;
+		return -1;
+	}
+
+	// Start control socket if enabled
+	if ((!sConfigContents.strControlSocket.empty()) && (!cControlServer.start(sConfigContents.strControlSocket, &cEventLoop)))
+	{
+		// Never run twice on the same records
+		if (errno == EADDRINUSE)
+		{
+			std::cerr << COLOR_RED << "[ERROR]: Already running: another instance answers on control socket " << sConfigContents.strControlSocket << "." << COLOR_DEFAULT << std::endl;
+			return -1;
+		}
+
+		// Print to terminal
+		std::cerr << COLOR_YELLOW << "[WARNING]: Cannot open control socket " << sConfigContents.strControlSocket << ": " << std::strerror(errno) << ". Control disabled." << COLOR_DEFAULT << std::endl;
+	}
+
+	// Join cluster if enabled (zones are not replaced as a whole, as they contain rrsets of other nodes)
+	if (!sConfigContents.strClusterDir.empty())
+	{
+		// Variables
+		std::string strErrorMsg;
+
+
+		// Print to terminal and try to write the lease of this node
+		std::cout << "Joining cluster... ";
+		if ((!g_cCluster.start(sConfigContents.strClusterDir, sConfigContents.strClusterNode, sConfigContents.iClusterLeaseS, &strErrorMsg)) || (!cEventLoop.watch(g_cCluster.fd(), [&bClusterChanged]() { bClusterChanged |= g_cCluster.process(); })))
+		{
+			// Print to terminal
+			std::cerr << COLOR_RED << "Failed\n[ERROR]: Cannot join cluster in " << sConfigContents.strClusterDir << ": " << (strErrorMsg.empty() ? std::strerror(errno) : strErrorMsg) << COLOR_DEFAULT << std::endl;
+			g_cCluster.stop();
+			return -1;
+		}
+		std::cout << COLOR_GREEN << "OK" << COLOR_DEFAULT << " (node " << g_cCluster.node() << ", taking over records in " << sConfigContents.iClusterLeaseS << "s)" << std::endl;
+		sConfigContents.bBatchUpdates = false;
+
+		// Records are written once they are owned by this node
+		for (std::list<SDomRecords>::iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+			for (std::list<SSubDomain>::iterator iSDom = iRec->lstSubDomains.begin(); iSDom != iRec->lstSubDomains.end(); iSDom++)
+				iSDom->bOwned = false;
+	}
+
+	// Start watching for local address changes if enabled
+	if ((sConfigContents.bNetlinkEvents) && ((!cNetlinkWatcher.start()) || (!cEventLoop.watch(cNetlinkWatcher.fd(), [&cNetlinkWatcher, &tNextPoll]() {
+		// Let a burst of address events settle before asking the IP service
+		if (cNetlinkWatcher.process())
+			tNextPoll = std::min(tNextPoll, (std::chrono::steady_clock::now() + std::chrono::milliseconds(NL_SETTLE_MS)));
+	}))))
+	{
+		// Print to terminal and fall back to polling
+		std::cerr << COLOR_YELLOW << "[WARNING]: Cannot watch for address changes: " << std::strerror(errno) << ". Falling back to polling." << COLOR_DEFAULT << std::endl;
+		sConfigContents.bNetlinkEvents = false;
+	}
+
+	// Start watching the config and records directory if enabled
+	if ((sConfigContents.bWatchConfig) && ((!cConfigWatcher.start()) || (!cEventLoop.watch(cConfigWatcher.fd(), [&cConfigWatcher, &tReload, &bReload]() {
+		// Let editors finish writing before reloading
+		if (cConfigWatcher.process())
+		{
+			tReload = std::chrono::steady_clock::now() + std::chrono::milliseconds(RELOAD_SETTLE_MS);
+			bReload = true;
+		}
+	}))))
+	{
+		// Print to terminal (reloading is still possible with SIGHUP)
+		std::cerr << COLOR_YELLOW << "[WARNING]: Cannot watch config for changes: " << std::strerror(errno) << ". Reload with SIGHUP instead." << COLOR_DEFAULT << std::endl;
+		sConfigContents.bWatchConfig = false;
+	}
+
+	// Start metrics listener if enabled
+	g_cMetrics.init(splitList(sConfigContents.strIPService, ','));
+	if ((sConfigContents.iMetricsPort != 0) && (!cMetricsServer.start(sConfigContents.strMetricsAddress, sConfigContents.iMetricsPort, &cEventLoop, [&lstRecords](const std::string& strRequest, std::string* pstrHeaders, std::string* pstrBody) {
+		// Check path
+		*pstrHeaders = "Content-Type: text/plain; version=0.0.4\r\n";
+		if ((strRequest.compare(0, 13, "GET /metrics ") != 0) && (strRequest.compare(0, 6, "GET / ") != 0))
+		{
+			*pstrBody = "Not found\n";
+			return 404;
+		}
+
+		// Render metrics
+		*pstrBody = g_cMetrics.render(lstRecords);
+		return 200;
+	})))
+		std::cerr << COLOR_YELLOW << "[WARNING]: Cannot start metrics listener on " << sConfigContents.strMetricsAddress << ":" << sConfigContents.iMetricsPort << ": " << std::strerror(errno) << ". Metrics disabled." << COLOR_DEFAULT << std::endl;
+
+	// Start push listener if enabled (routers report their new address, it is used after the running updates)
+	if ((sConfigContents.iPushPort != 0) && (sConfigContents.strPushToken.empty()))
+		std::cerr << COLOR_YELLOW << "[WARNING]: PushToken is required for the push listener. Push disabled." << COLOR_DEFAULT << std::endl;
+	else if ((sConfigContents.iPushPort != 0) && (!cPushServer.start(sConfigContents.strPushAddress, sConfigContents.iPushPort, &cEventLoop, [&sConfigContents, &strLastIPv4, &strLastIPv6, &strPushIPv4, &strPushIPv6, &bPush](const std::string& strRequest, std::string* pstrHeaders, std::string* pstrBody) {
+		return handlePushRequest(strRequest, sConfigContents, strLastIPv4, strLastIPv6, &strPushIPv4, &strPushIPv6, &bPush, pstrHeaders, pstrBody);
+	})))
+		std::cerr << COLOR_YELLOW << "[WARNING]: Cannot start push listener on " << sConfigContents.strPushAddress << ":" << sConfigContents.iPushPort << ": " << std::strerror(errno) << ". Push disabled." << COLOR_DEFAULT << std::endl;
+
+	// Load published state if enabled
+	if (sConfigContents.bPersistState)
+	{
+		// Print to terminal and try to load state
+		std::cout << "Loading published state... ";
+		if (cStateStore.load(STATE_FILE_PATH))
+			std::cout << COLOR_GREEN << "OK" << COLOR_DEFAULT << std::endl;
+		else
+			std::cout << COLOR_YELLOW << "None" << COLOR_DEFAULT << std::endl;
+
+		// Print to terminal and try to load the history of address changes
+		std::cout << "Loading address history... ";
+		if (cPollScheduler.load(POLL_HISTORY_FILE_PATH))
+			std::cout << COLOR_GREEN << "OK" << COLOR_DEFAULT << " (" << cPollScheduler.size() << " changes)" << std::endl;
+		else
+			std::cout << COLOR_YELLOW << "None" << COLOR_DEFAULT << std::endl;
+
+		// Print to terminal and try to replay the journal of pending updates (entries of records that are not managed anymore are dropped)
+		std::cout << "Loading journal... ";
+		if ((bJournal = cJournal.open(JOURNAL_FILE_PATH)))
+		{
+			cJournal.prune(lstRecords);
+			std::cout << COLOR_GREEN << "OK" << COLOR_DEFAULT << " (" << cJournal.size() << " pending rrsets)" << std::endl;
+		}
+		else
+			std::cerr << COLOR_YELLOW << "Failed\n[WARNING]: Cannot open journal file " << JOURNAL_FILE_PATH << ": " << std::strerror(errno) << ". Journal disabled." << COLOR_DEFAULT << std::endl;
+	}
+
+	// Write the journal if enabled
+	auto flushJournal = [&cJournal, &bJournal]() {
+		// Append changes
+		if ((!bJournal) || (cJournal.flush()))
+			return;
+
+		// Print to terminal and to logfile if enabled
+		std::cerr << COLOR_YELLOW << timeStamp() << "[WARNING]: Cannot write journal file: " << std::strerror(errno) << "." << COLOR_DEFAULT << std::endl;
+		g_cLogger.log(LOG_LEVEL_WARNING, "Cannot write journal file: %s.", std::strerror(errno));
+	};
+
+	// Schedule all records if the current address changed
+	auto applyAddress = [&](std::chrono::steady_clock::time_point tNow) {
+		// Check wether the IP address has changed
+		if ((bIPKnown) && (strCurIPv4 == strLastIPv4) && (strCurIPv6 == strLastIPv6))
+			return;
+
+		// Count change and remember it for each changed family (not the first address)
+		if (bIPKnown)
+		{
+			g_cMetrics.iAddressChanges++;
+			if (strCurIPv4 != strLastIPv4)
+				cPollScheduler.changed(0, time(NULL));
+			if (strCurIPv6 != strLastIPv6)
+				cPollScheduler.changed(1, time(NULL));
+		}
+
+		// Remeber current IP addresses
+		strLastIPv4 = strCurIPv4;
+		strLastIPv6 = strCurIPv6;
+		bIPKnown = true;
+
+		// Run through all records
+		for (std::list<SDomRecords>::iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+		{
+			// Reset retries
+			iRec->mapRetries.clear();
+
+			// Skip records that have already been published with these addresses
+			if ((sConfigContents.bPersistState) && (cStateStore.isPublished(*iRec, sConfigContents, strCurIPv4, strCurIPv6, &iRec->tLastVerified)))
+			{
+				iRec->setPending.clear();
+				iRec->bUpToData = true;
+				if (bJournal)
+					cJournal.drop(*iRec);
+				continue;
+			}
+
+			// Schedule all rrsets for an immediate update (superseding older desired states)
+			iRec->setPending = rrsetKeys(*iRec, sConfigContents, strCurIPv6);
+			iRec->bUpToData = false;
+			if (bJournal)
+				cJournal.want(*iRec, iRec->setPending, strCurIPv4, strCurIPv6);
+			for (std::set<std::string>::iterator iRRSet = iRec->setPending.begin(); iRRSet != iRec->setPending.end(); iRRSet++)
+				cRetryScheduler.schedule(&(*iRec), *iRRSet, 0, tNow);
+
+			// Leave rrsets of other nodes of the cluster to them
+			if (g_cCluster.enabled())
+				dropForeign(&(*iRec), NULL, (bJournal ? &cJournal : NULL));
+		}
+	};
+
+	// Print to terminal and start workers
+	std::cout << "Initalization was successfull. Starting main loop..." << std::endl;
+	CWorkerPool cWorkerPool(WORKER_THREADS, [&cEventLoop]() { cEventLoop.wake(); });
+	cRetryScheduler.configure(sConfigContents.iRetryBaseS, sConfigContents.iRetryMaxS);
+	cPollScheduler.configure(sConfigContents.bAdaptivePolling, (sConfigContents.bNetlinkEvents ? sConfigContents.iSafetyPollS : sConfigContents.iUpdatePeriodS), std::min(sConfigContents.iUpdatePeriodS, sConfigContents.iPollMinS), sConfigContents.iPollMinS, sConfigContents.iPollMaxS);
+	g_cRateLimiter.configure(sConfigContents.iAPIRateLimit, sConfigContents.iAPIBurst);
+	cHttpClient.setMaxIdleHandles(std::max<size_t>(HTTP_MAX_IDLE_HANDLES, sConfigContents.iMaxParallelUpdates));
+
+
+	// Main loop
+	while (!g_sigInterrupt)
+	{
+		// Variables
+		std::list<SPendingUpdate> lstPending;
+		std::map<SDomRecords*, std::set<std::string>> mapDue;
+		std::map<std::string, std::vector<std::list<SDomRecords>::iterator>> mapByKey;
+		std::map<std::string, std::pair<size_t, std::chrono::steady_clock::time_point>> mapBudgets;
+		std::chrono::steady_clock::time_point tNow = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point tWakeUp;
+		time_t tNowWall = time(NULL);
+
+
+		// Reload config and records if requested (no update is running, so all records can be changed)
+		if ((bReload) && (tNow >= tReload))
+		{
+			bReload = false;
+			reloadConfig(&sConfigContents, &cRecordTable, &cRuntimeRecords, setRuntimeRemoved, &cRetryScheduler, &cPollScheduler, (bJournal ? &cJournal : NULL), &mapNameServers, bIPKnown, strCurIPv4, strCurIPv6, tNow, &tNextPoll, argc, argv);
+		}
+
+		// Answer commands of the control socket (no update is running)
+		if (cControlServer.pending())
+			cControlServer.process([&](const std::vector<std::string>& vecArgs) { return handleControlCommand(vecArgs, sConfigContents, &cRecordTable, &cRuntimeRecords, &setRuntimeRemoved, &cRetryScheduler, cPollScheduler, (bJournal ? &cJournal : NULL), bIPKnown, strCurIPv4, strCurIPv6, &bPaused, &tNextPoll); });
+
+		// Use address pushed by the router instead of asking the IP service
+		if (bPush)
+		{
+			// Take over pushed families and schedule records if changed
+			bPush = false;
+			g_cMetrics.iPushes++;
+			if (!strPushIPv4.empty())
+				strCurIPv4 = strPushIPv4;
+			if (!strPushIPv6.empty())
+				strCurIPv6 = strPushIPv6;
+
+			// Print to terminal and to logfile if enabled
+			std::cout << timeStamp() << "[INFO]: Address pushed by router (" << (strCurIPv4.empty() ? "-" : strCurIPv4) << ", " << (strCurIPv6.empty() ? "-" : strCurIPv6) << ")." << std::endl;
+			g_cLogger.log(LOG_LEVEL_INFO, "Address pushed by router (%s, %s).", (strCurIPv4.empty() ? "-" : strCurIPv4.c_str()), (strCurIPv6.empty() ? "-" : strCurIPv6.c_str()));
+			applyAddress(tNow);
+			tNextPoll = tNow + std::chrono::seconds(cPollScheduler.next(time(NULL)));
+		}
+
+		// Check if the IP address has to be read
+		else if (tNow >= tNextPoll)
+		{
+			// Set time of next poll (chosen again with the result)
+			tNextPoll = tNow + std::chrono::seconds(cPollScheduler.interval());
+
+			// Check if the local address has to be cross-checked by the following sources
+			bool bCrossCheck = ((sConfigContents.iIPCrossCheckS != 0) && (tNow >= tNextCrossCheck));
+			if (bCrossCheck)
+				tNextCrossCheck = tNow + std::chrono::seconds(sConfigContents.iIPCrossCheckS);
+
+			// Try to read IP address (on a worker, so signals are still handled)
+			std::future<bool> ftrIPAddress = cWorkerPool.submit([&strCurIPv4, &strCurIPv6, sConfigContents, &mapIPProviders, bCrossCheck]() {
+				return resolveIPAddress(mapIPProviders, sConfigContents, bCrossCheck, &strCurIPv4, &strCurIPv6);
+			});
+			g_cMetrics.iPolls++;
+			if ((waitResult(&ftrIPAddress)) && (!g_sigInterrupt))
+			{
+				applyAddress(tNow);
+				cPollScheduler.polled(true);
+				tNextPoll = tNow + std::chrono::seconds(cPollScheduler.next(time(NULL)));
+			}
+			// Failed to read IP address (not if canceled)
+			else if (!g_sigInterrupt)
+			{
+				// Count failure and poll again soon
+				g_cMetrics.iPollFailures++;
+				cPollScheduler.polled(false);
+				tNextPoll = tNow + std::chrono::seconds(cPollScheduler.next(time(NULL)));
+
+				// Print to termninal and to logfile if enabled
+				std::cerr << COLOR_RED << timeStamp() << "[ERROR]: Something went wrong. Cannot get your IP from \'" << ((sConfigContents.strIPSource == IP_SOURCE_HTTP) ? sConfigContents.strIPService : sConfigContents.strIPSource) << "\'" << COLOR_DEFAULT << std::endl;
+				g_cLogger.log(LOG_LEVEL_ERROR, "Something went wrong. Cannot get your IP from '%s'", ((sConfigContents.strIPSource == IP_SOURCE_HTTP) ? sConfigContents.strIPService : sConfigContents.strIPSource).c_str());
+
+				// Replay the journal with the last desired address if the current one is not known yet (an IPv4 address is required)
+				if ((!bIPKnown) && (bJournal) && (cJournal.latest("A", &strCurIPv4)))
+				{
+					// Use last desired IPv6 address too if there is any
+					strCurIPv6.clear();
+					cJournal.latest("AAAA", &strCurIPv6);
+
+					// Print to terminal and to logfile if enabled
+					std::cout << timeStamp() << "[INFO]: Replaying " << cJournal.size() << " pending rrset/s of the journal (" << strCurIPv4 << ", " << (strCurIPv6.empty() ? "-" : strCurIPv6) << ")." << std::endl;
+					g_cLogger.log(LOG_LEVEL_INFO, "Replaying %zu pending rrset/s of the journal (%s, %s).", cJournal.size(), strCurIPv4.c_str(), (strCurIPv6.empty() ? "-" : strCurIPv6.c_str()));
+					applyAddress(tNow);
+				}
+			}
+		}
+
+		// Take over or hand over subdomains if the owners of the cluster changed
+		if (bClusterChanged)
+		{
+			bClusterChanged = false;
+			applyOwners(&lstRecords, sConfigContents, &cRetryScheduler, (bJournal ? &cJournal : NULL), bIPKnown, strCurIPv4, strCurIPv6, tNow);
+		}
+
+		// Make desired states durable before any of them is sent
+		flushJournal();
+
+		// Collect due rrsets (not while paused)
+		if ((bIPKnown) && (!g_sigInterrupt) && (!bPaused))
+		{
+			// Rrsets whose (next) attempt is due
+			mapDue = cRetryScheduler.popDue(tNow);
+
+			// Records that are due for verification
+			for (std::list<SDomRecords>::iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+				if ((iRec->bUpToData) && (sConfigContents.bReadBeforeWrite) && (sConfigContents.iVerifyPeriodS != 0) && ((tNowWall - iRec->tLastVerified) >= sConfigContents.iVerifyPeriodS))
+					mapDue[&(*iRec)] = rrsetKeys(*iRec, sConfigContents, strCurIPv6);
+
+			// Rrsets of subdomains that are owned by other nodes are not written
+			if (g_cCluster.enabled())
+				for (std::map<SDomRecords*, std::set<std::string>>::iterator iDue = mapDue.begin(); iDue != mapDue.end(); iDue++)
+					dropForeign(iDue->first, &iDue->second, (bJournal ? &cJournal : NULL));
+		}
+
+		// Group due records by API key (pending updates before verifications, only as many as the rate limit of the key allows, the others are deferred)
+		for (bool bVerifyPass : { false, true })
+		{
+			for (std::list<SDomRecords>::iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+			{
+				// Variables
+				std::map<SDomRecords*, std::set<std::string>>::iterator iDue = mapDue.find(&(*iRec));
+				std::map<std::string, std::pair<size_t, std::chrono::steady_clock::time_point>>::iterator iBudget;
+				size_t iCost;
+
+
+				// Skip if nothing is due or not part of this pass
+				if ((iDue == mapDue.end()) || (iDue->second.empty()) || (iRec->bUpToData != bVerifyPass))
+					continue;
+
+				// Get budget of API key once per iteration
+				if ((iBudget = mapBudgets.find(iRec->strAPIKey)) == mapBudgets.end())
+				{
+					iBudget = mapBudgets.emplace(iRec->strAPIKey, std::make_pair(0, tNow)).first;
+					iBudget->second.first = g_cRateLimiter.budget(iRec->strAPIKey, &iBudget->second.second);
+				}
+
+				// Estimate requests of the record (the first record of a key is always allowed if any token is left)
+				iCost = (((sConfigContents.bBatchUpdates) && (!iRec->bShared)) ? 2 : (iDue->second.size() + (sConfigContents.bReadBeforeWrite ? 1 : 0)));
+				if ((iBudget->second.first > 0) && ((iCost <= iBudget->second.first) || (mapByKey[iRec->strAPIKey].empty())))
+				{
+					iBudget->second.first -= std::min(iCost, iBudget->second.first);
+					mapByKey[iRec->strAPIKey].push_back(iRec);
+					continue;
+				}
+
+				// Defer pending rrsets until the key has tokens again (verifications are picked up again later)
+				if (bVerifyPass)
+					continue;
+				for (std::set<std::string>::iterator iRRSet = iDue->second.begin(); iRRSet != iDue->second.end(); iRRSet++)
+					if (iRec->setPending.count(*iRRSet) != 0)
+						cRetryScheduler.defer(&(*iRec), *iRRSet, std::max(iBudget->second.second, (tNow + std::chrono::milliseconds(RATE_WAIT_SLICE_MS))));
+				g_cMetrics.iRateDeferred++;
+			}
+		}
+
+		// Queue the due rrsets (round robin over the API keys, so every key gets its share)
+		for (size_t iRound = 0; ((!mapByKey.empty()) && (g_sigInterrupt == 0)); iRound++)
+		{
+			for (std::map<std::string, std::vector<std::list<SDomRecords>::iterator>>::iterator iKey = mapByKey.begin(); iKey != mapByKey.end();)
+			{
+				// Remove key if all of its records are submitted
+				if (iRound >= iKey->second.size())
+				{
+					iKey = mapByKey.erase(iKey);
+					continue;
+				}
+
+				// Queue update of the next record of the key
+				std::list<SDomRecords>::iterator iRec = (iKey++)->second[iRound];
+				SPendingUpdate* psPending = &(*lstPending.emplace(lstPending.end()));
+				psPending->iRec = iRec;
+				psPending->bVerifyOnly = iRec->bUpToData;
+				psPending->setRRSets = mapDue[&(*iRec)];
+				psPending->iGeneration = g_cCluster.generation();
+			}
+		}
+
+		// Run all queued updates as tasks of a single worker
+		if (!lstPending.empty())
+		{
+			// Variables
+			std::future<bool> ftrUpdates = cWorkerPool.submit([&lstPending, sConfigContents, strCurIPv4, strCurIPv6, &cHttpClient, &cZoneCache]() {
+				updateRecords(&lstPending, sConfigContents, strCurIPv4, strCurIPv6, &cHttpClient, &cZoneCache);
+				return true;
+			});
+
+
+			// Wait for them
+			waitResult(&ftrUpdates);
+		}
+
+		// Gather results in order
+		for (std::list<SPendingUpdate>::iterator iPending = lstPending.begin(); iPending != lstPending.end(); iPending++)
+		{
+			// Variables
+			std::list<SDomRecords>::iterator iRec = iPending->iRec;
+			bool bUpdated = iPending->bResult;
+			std::string strSubDomains, strLine;
+			size_t iSubDomains = 0;
+			uint32_t iRetryS = 0;
+
+
+			// Remember attempt
+			iRec->tLastAttempt = time(NULL);
+
+			// Run through subdomains (in order of definition)
+			for (std::list<SSubDomain>::iterator iSDom = iRec->lstSubDomains.begin(); iSDom != iRec->lstSubDomains.end(); iSDom++)
+			{
+				// Variables
+				bool bProcessed = false;
+
+
+				// Run through types
+				for (const char* cType : { "A", "AAAA" })
+				{
+					// Variables
+					std::string strRRSet = iSDom->strName + "\t" + cType;
+
+
+					// Skip rrsets that have not been processed
+					if (iPending->setRRSets.count(strRRSet) == 0)
+						continue;
+					bProcessed = true;
+
+					// Schedule next attempt with backoff if failed (not if canceled)
+					if (iRec->mapFailed.count(strRRSet) != 0)
+					{
+						if (!g_sigInterrupt)
+						{
+							// Variables
+							std::chrono::steady_clock::time_point tNext;
+
+
+							// Throttled rrsets wait for the rate limit without counting as failed attempt
+							if (iRec->mapFailed[strRRSet] == RATE_LIMITED_MSG)
+							{
+								g_cRateLimiter.budget(iRec->strAPIKey, &tNext);
+								tNext = cRetryScheduler.defer(&(*iRec), strRRSet, std::max(tNext, (tNow + std::chrono::seconds(RATE_DEF_RETRY_AFTER_S))));
+							}
+							// Rrsets that were not written because the owners changed are checked again right away
+							else if (iRec->mapFailed[strRRSet] == CLUSTER_MOVED_MSG)
+								tNext = cRetryScheduler.defer(&(*iRec), strRRSet, tNow);
+							else
+								tNext = cRetryScheduler.schedule(&(*iRec), strRRSet, (iRec->mapRetries[strRRSet].iAttempts + 1), tNow);
+							iRec->sMetrics.iRetries++;
+							iRec->setPending.insert(strRRSet);
+							iRetryS = std::max<uint32_t>(iRetryS, ((std::chrono::duration_cast<std::chrono::milliseconds>(tNext - tNow).count() + 999) / 1000));
+						}
+						continue;
+					}
+
+					// Remember published rrset
+					iRec->setPending.erase(strRRSet);
+					iRec->mapRetries.erase(strRRSet);
+					cStateStore.setPublished(iRec->strDomain, iSDom->strName, cType, ((cType[1] == '\0') ? strCurIPv4 : strCurIPv6), iSDom->iTTL, iRec->tLastVerified);
+					if (bJournal)
+						cJournal.done(iRec->strDomain, iSDom->strName, cType);
+
+					// Look it up at the nameservers later if enabled (not after periodic verifications)
+					if ((sConfigContents.bDNSVerify) && (!iPending->bVerifyOnly))
+					{
+						iRec->mapUnconfirmed[strRRSet] = 0;
+						iRec->tConfirm = tNow + std::chrono::seconds(sConfigContents.iDNSVerifyDelayS);
+						tNextConfirm = std::min(tNextConfirm, iRec->tConfirm);
+					}
+					iRec->sMetrics.tLastPublish = time(NULL);
+				}
+
+				// Remember subdomain for printing (limited amount)
+				if ((bProcessed) && (iSubDomains++ < LOG_MAX_SUBDOMAINS))
+					strSubDomains += (strSubDomains.empty() ? "" : ", ") + iSDom->strName;
+			}
+
+			// Update flag
+			iRec->bUpToData = iRec->setPending.empty();
+
+			// Skip verified records that did not require any change
+			if ((bUpdated) && (iPending->bVerifyOnly) && (iRec->iWritten == 0))
+				continue;
+
+			// Format string and print to console
+			if (iSubDomains > LOG_MAX_SUBDOMAINS)
+				strSubDomains += ", +" + std::to_string(iSubDomains - LOG_MAX_SUBDOMAINS) + " more";
+			strLine = timeStamp() + "[UPDATE]: Updating record/s for \'" + iRec->strDomain + "\' (" + strSubDomains + ")... ";
+			std::cout << strLine << std::flush;
+
+			// Check if nothing had to be changed
+			if ((bUpdated) && (iRec->iWritten == 0))
+			{
+				// Print to console and to logfile if enabled
+				std::cout << COLOR_GREEN << "Unchanged" << COLOR_DEFAULT << std::endl;
+				g_cLogger.log(LOG_LEVEL_UPDATE, "Updating record/s for '%s' (%s)... Unchanged", iRec->strDomain.c_str(), strSubDomains.c_str());
+			}
+			// Check if update was successful
+			else if (bUpdated)
+			{
+				// Print to console and to logfile if enabled
+				std::cout << COLOR_GREEN << "Done" << COLOR_DEFAULT << std::endl;
+				g_cLogger.log(LOG_LEVEL_UPDATE, "Updating record/s for '%s' (%s)... Done", iRec->strDomain.c_str(), strSubDomains.c_str());
+			}
+			// Check if update was canceled
+			else if (g_sigInterrupt)
+			{
+				// Print to console and to logfile if enabled
+				std::cerr << COLOR_YELLOW << "\b\bCanceled" << COLOR_DEFAULT << std::endl;
+				g_cLogger.log(LOG_LEVEL_UPDATE, "Updating record/s for '%s' (%s)... Canceled", iRec->strDomain.c_str(), strSubDomains.c_str());
+			}
+			// Updating failed
+			else
+			{
+				// Print to console and to logfile if enabled
+				std::cerr << COLOR_RED << "Failed\n" << timeStamp() << "[ERROR]: Failed to update record/s for \'" << iRec->strDomain << "\': " << iPending->strErrorMsg << ". Retrying in " << iRetryS << "s." << COLOR_DEFAULT << std::endl;
+				g_cLogger.log(LOG_LEVEL_UPDATE, "Updating record/s for '%s' (%s)... Failed", iRec->strDomain.c_str(), strSubDomains.c_str());
+				g_cLogger.log(LOG_LEVEL_ERROR, "Failed to update record/s for '%s': %s. Retrying in %us.", iRec->strDomain.c_str(), iPending->strErrorMsg.c_str(), iRetryS);
+			}
+		}
+
+		// Look up published rrsets at the authoritative nameservers if due (not while paused)
+		if ((tNow >= tNextConfirm) && (!bPaused) && (!g_sigInterrupt))
+		{
+			// Variables
+			std::vector<SDnsCheck> vecChecks;
+			std::future<bool> ftrChecks;
+
+
+			// Collect rrsets of due records (rrsets that are pending again are looked up after their next update)
+			tNextConfirm = std::chrono::steady_clock::time_point::max();
+			for (std::list<SDomRecords>::iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+			{
+				// Skip records that are not due
+				if ((!iRec->mapUnconfirmed.empty()) && (iRec->tConfirm > tNow))
+					tNextConfirm = std::min(tNextConfirm, iRec->tConfirm);
+				if ((iRec->mapUnconfirmed.empty()) || (iRec->tConfirm > tNow))
+					continue;
+
+				// Run through unconfirmed rrsets
+				for (std::map<std::string, uint16_t>::iterator iRRSet = iRec->mapUnconfirmed.begin(); iRRSet != iRec->mapUnconfirmed.end();)
+				{
+					if (iRec->setPending.count(iRRSet->first) != 0)
+					{
+						iRRSet = iRec->mapUnconfirmed.erase(iRRSet);
+						continue;
+					}
+					vecChecks.push_back({ &(*iRec), iRRSet->first, ((iRRSet->first.compare((iRRSet->first.find('\t') + 1), std::string::npos, "A") == 0) ? strCurIPv4 : strCurIPv6), false, false });
+					iRRSet++;
+				}
+			}
+
+			// Send all queries from a worker (answers arrive in parallel)
+			if (!vecChecks.empty())
+				ftrChecks = cWorkerPool.submit([&vecChecks, sConfigContents, &cHttpClient, &cDnsClient, &mapNameServers]() {
+					return confirmRecords(&vecChecks, sConfigContents, &cHttpClient, &cDnsClient, &mapNameServers);
+				});
+			if ((ftrChecks.valid()) && (waitResult(&ftrChecks)) && (!g_sigInterrupt))
+			{
+				// Run through results
+				for (std::vector<SDnsCheck>::iterator iCheck = vecChecks.begin(); iCheck != vecChecks.end(); iCheck++)
+				{
+					// Variables
+					SDomRecords* psDomRecords = iCheck->psDomRecords;
+					uint16_t* piChecks = &psDomRecords->mapUnconfirmed[iCheck->strRRSet];
+					std::string strName = iCheck->strRRSet.substr(0, iCheck->strRRSet.find('\t')) + "." + psDomRecords->strDomain + "/" + iCheck->strRRSet.substr(iCheck->strRRSet.find('\t') + 1);
+
+
+					// Forget confirmed rrsets
+					if (iCheck->bConfirmed)
+					{
+						g_cMetrics.iDNSConfirmed++;
+						psDomRecords->mapUnconfirmed.erase(iCheck->strRRSet);
+						continue;
+					}
+
+					// Look up again later with doubled delay if attempts are left
+					g_cMetrics.iDNSUnconfirmed++;
+					if (++(*piChecks) < sConfigContents.iDNSVerifyAttempts)
+					{
+						psDomRecords->tConfirm = tNow + (std::chrono::seconds(sConfigContents.iDNSVerifyDelayS) * (1 << std::min<uint16_t>(*piChecks, 10)));
+						tNextConfirm = std::min(tNextConfirm, psDomRecords->tConfirm);
+						continue;
+					}
+					psDomRecords->mapUnconfirmed.erase(iCheck->strRRSet);
+
+					// Give up if no nameserver has answered
+					if (!iCheck->bAnswered)
+					{
+						// Print to terminal and to logfile if enabled
+						std::cerr << COLOR_YELLOW << timeStamp() << "[WARNING]: Cannot verify '" << strName << "', no nameserver has answered." << COLOR_DEFAULT << std::endl;
+						g_cLogger.log(LOG_LEVEL_WARNING, "Cannot verify '%s', no nameserver has answered.", strName.c_str());
+						continue;
+					}
+
+					// Write rrset again (even if the API already has the value)
+					g_cMetrics.iDNSRequeued++;
+					psDomRecords->mapFailed[iCheck->strRRSet] = DNS_NOT_SERVED_MSG;
+					psDomRecords->setForce.insert(iCheck->strRRSet);
+					psDomRecords->setPending.insert(iCheck->strRRSet);
+					psDomRecords->bUpToData = false;
+					cRetryScheduler.schedule(psDomRecords, iCheck->strRRSet, 0, tNow);
+					if (bJournal)
+						cJournal.want(*psDomRecords, { iCheck->strRRSet }, strCurIPv4, strCurIPv6);
+
+					// Print to terminal and to logfile if enabled
+					std::cerr << COLOR_YELLOW << timeStamp() << "[WARNING]: '" << strName << "' is not served by the nameservers after " << *piChecks << " lookups. Updating it again." << COLOR_DEFAULT << std::endl;
+					g_cLogger.log(LOG_LEVEL_WARNING, "'%s' is not served by the nameservers after %u lookups. Updating it again.", strName.c_str(), *piChecks);
+				}
+			}
+		}
+
+		// Write published state if enabled and changed
+		if ((sConfigContents.bPersistState) && (!cStateStore.save(STATE_FILE_PATH)))
+		{
+			// Print to terminal and to logfile if enabled
+			std::cerr << COLOR_YELLOW << timeStamp() << "[WARNING]: Cannot write state file: " << std::strerror(errno) << "." << COLOR_DEFAULT << std::endl;
+			g_cLogger.log(LOG_LEVEL_WARNING, "Cannot write state file: %s.", std::strerror(errno));
+		}
+		if ((sConfigContents.bPersistState) && (!cPollScheduler.save(POLL_HISTORY_FILE_PATH)))
+		{
+			// Print to terminal and to logfile if enabled
+			std::cerr << COLOR_YELLOW << timeStamp() << "[WARNING]: Cannot write address history: " << std::strerror(errno) << "." << COLOR_DEFAULT << std::endl;
+			g_cLogger.log(LOG_LEVEL_WARNING, "Cannot write address history: %s.", std::strerror(errno));
+		}
+		flushJournal();
+		g_cMetrics.iJournalPending = cJournal.size();
+		g_cMetrics.iPollIntervalS = cPollScheduler.interval();
+
+		// Process events until the next poll or the next due retry
+		while (!g_sigInterrupt)
+		{
+			// Get time of next wake up
+			tWakeUp = tNextPoll;
+			if ((!bPaused) && (cRetryScheduler.nextDue(&tNow)))
+				tWakeUp = std::min(tWakeUp, tNow);
+			if (!bPaused)
+				tWakeUp = std::min(tWakeUp, tNextConfirm);
+			if (bReload)
+				tWakeUp = std::min(tWakeUp, tReload);
+
+			// Check if already due or a command or pushed address is waiting
+			if ((std::chrono::steady_clock::now() >= tWakeUp) || (cControlServer.pending()) || (bPush) || (bClusterChanged))
+				break;
+
+			// Arm timer and wait for events (a hangup forces a reload and the next poll)
+			cEventLoop.setTimer(tWakeUp);
+			if (cEventLoop.run() & EVT_HANGUP)
+			{
+				tNextPoll = tReload = std::chrono::steady_clock::now();
+				bReload = true;
+			}
+		}
+	}
+
+	// Leave cluster, so the other nodes take over right away
+	g_cCluster.stop();
+
+	// Close logfile (writes remaining lines) and print to termnial
+	g_cLogger.close();
+	std::cout << COLOR_RED << "\rterminated" << COLOR_DEFAULT << std::endl;
+
+
+	// Success
+	return 0;
+
+} // Main function
+
+
+//
+// setup
+//
+// Task: Setup everything
+//
+bool setup(SConfigContents* psConfigContents, CRecordTable* pcRecordTable, int argc, char* argv[], CEventLoop* pcEventLoop)
+{
+	// Variables
+	uint8_t iLoadRes;
+	std::string strErrorMsg;
+
+
+	// Try to create event loop (takes over the signals before any thread is started)
+	if (!pcEventLoop->init())
+	{
+		// Print to terminal
+		std::cerr << COLOR_RED << "[ERROR]: Cannot create event loop: " << std::strerror(errno) << COLOR_DEFAULT << std::endl;
+		return false;
+	}
+
+	// Initialize HTTP library
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	// Print to terminal and try to get records from command line
+	std::cout << "Reading command line... ";
+	iLoadRes = domRecordsFromCmdLine(pcRecordTable, argc, argv);
+
+	// Check if reading failed
+	if (iLoadRes != REC_ERR_NONE)
+	{
+		// Print to terminal
+		std::cout << COLOR_RED << "Failed" << std::endl;
+
+		// Print corresponding error message to terminal
+		if (iLoadRes == REC_ERR_SPECIFER)
+			std::cerr << "[ERROR]: Unknown specifier! Sytax: recUpdater -k <APIKey> -d <domain> <subdomain1> <...>" << COLOR_DEFAULT << std::endl;
+		else if (iLoadRes == REC_ERR_ARGUMENTS)
+			std::cerr << "[ERROR]: Not enough arguments! Sytax: recUpdater -k <APIKey> -d <domain> <subdomain1> <...>" << COLOR_DEFAULT << std::endl;
+		else
+			std::cerr << "[ERROR]: No API key and/or domain specified! Sytax: recUpdater -k <APIKey> -d <domain> <subdomain1> <...>" << COLOR_DEFAULT << std::endl;
+
+		// Failure
+		return false;
+	}
+
+
+	// Print to terminal  and try to load the config
+	std::cout << COLOR_GREEN << "OK" << COLOR_DEFAULT << std::endl;
+	std::cout << "Loading config... ";
+	iLoadRes = loadConfig(psConfigContents);
+
+	// Check if loading failed
+	if (iLoadRes != CFG_ERR_NONE)
+	{
+		// Print to terminal
+		std::cout << COLOR_RED << "Failed" << COLOR_DEFAULT << std::endl;
+
+		// Check if config is missing
+		if (iLoadRes == CFG_ERR_FILE)
+		{
+			// Print to terminal
+			std::cout << "Missing config. Generating new config with default settings... ";
+
+			// Try to generate new config
+			if (!generateConfig())
+			{
+				// Print to terminal
+				std::cout << COLOR_RED << "Failed" << std::endl;
+				std::cerr << "[ERROR]: Cannot create config file: " << std::strerror(errno) << "." << COLOR_DEFAULT << std::endl;
+
+				// Failure
+				return false;
+			}
+		}
+		// Check if attributes missing
+		else if (iLoadRes == CFG_ERR_ATTR_MISSING)
+		{
+			// Print to terminal and return
+			std::cerr << COLOR_RED << "[ERROR]: Missing attributes in config. Please correct it and try again." << COLOR_DEFAULT << std::endl;
+			return false;
+		}
+		// Syntax error
+		else
+		{
+			// Print to terminal and return
+			std::cerr << COLOR_RED << "[ERROR]: Syntax error in config. Please correct it and try again." << COLOR_DEFAULT << std::endl;
+			return false;
+		}
+	}
+
+
+	// Print to terminal and try to load records from the records directory
+	std::cout << COLOR_GREEN << "OK" << COLOR_DEFAULT << std::endl;
+	std::cout << "Loading records... ";
+	iLoadRes = pcRecordTable->loadDirectory(REC_DIR_PATH, &strErrorMsg);
+
+	// Check if loading failed
+	if (iLoadRes != REC_ERR_NONE)
+	{
+		// Print to terminal and return
+		std::cout << COLOR_RED << "Failed" << std::endl;
+		std::cerr << "[ERROR]: " << ((iLoadRes == REC_ERR_FILE) ? "Cannot read records: " : "Syntax error in records: ") << strErrorMsg << "." << COLOR_DEFAULT << std::endl;
+		return false;
+	}
+
+	// Check if no record has been specified at all
+	if (pcRecordTable->size() == 0)
+	{
+		// Print to terminal and return
+		std::cout << COLOR_RED << "Failed" << std::endl;
+		std::cerr << "[ERROR]: No records specified! Sytax: recUpdater -k <APIKey> -d <domain> <subdomain1> <...> or add them to " << REC_DIR_PATH << COLOR_DEFAULT << std::endl;
+		return false;
+	}
+
+	// Use TTL of the config for records without their own one and print to terminal
+	pcRecordTable->applyDefaultTTL(psConfigContents->iTTL);
+	std::cout << COLOR_GREEN << "OK" << COLOR_DEFAULT << " (" << pcRecordTable->size() << " records in " << pcRecordTable->records().size() << " zones)" << std::endl;
+	if (pcRecordTable->duplicates() != 0)
+		std::cerr << COLOR_YELLOW << "[WARNING]: Ignored " << pcRecordTable->duplicates() << " duplicate record/s." << COLOR_DEFAULT << std::endl;
+	if ((psConfigContents->bBatchUpdates) && (pcRecordTable->shared() != 0))
+		std::cerr << COLOR_YELLOW << "[WARNING]: " << pcRecordTable->shared() << " domain/s are used with several API keys. Their records are updated one by one instead of in batches." << COLOR_DEFAULT << std::endl;
+
+	// Check if logging is enabled
+	if (psConfigContents->bLogging)
+	{
+		// Print to terminal and try to open logfile (written in the background)
+		std::cout << "Opening logfile... ";
+
+		// Check if failed
+		if (!g_cLogger.open(LOG_FILE_PATH, psConfigContents->bLogJson, ((off_t)psConfigContents->iLogMaxSizeKiB * 1024), psConfigContents->iLogRotateFiles))
+		{
+			// Print to terminal and disable logging
+			std::cout << COLOR_RED << "Failed" << COLOR_DEFAULT << std::endl;
+			std::cerr << COLOR_YELLOW << "[WARNING]: Cannot open logfile: " << std::strerror(errno) << ". Logging disabled." << COLOR_DEFAULT << std::endl;
+			psConfigContents->bLogging = false;
+		}
+		// Success
+		else
+		{
+			// Print to terminal
+			std::cout << COLOR_GREEN << "OK" << COLOR_DEFAULT << std::endl;
+		}
+	}
+	// Logging disabled
+	else
+	{
+		// Print to terminal
+		std::cout << "[Config]: Logging disabled." << std::endl;
+	}
+
+	// Success
+	return true;
+
+} // setup
+
+//
+// loadSnapshot
+//
+// Task: Load config and records into new objects without printing (used for reloading)
+//
+bool loadSnapshot(SConfigContents* psConfigContents, CRecordTable* pcRecordTable, int argc, char* argv[], std::string* pstrErrorMsg)
+{
+	// Variables
+	uint8_t iLoadRes;
+	std::string strErrorMsg;
+
+
+	// Load records from command line (has been checked at startup)
+	domRecordsFromCmdLine(pcRecordTable, argc, argv);
+
+	// Load config
+	if ((iLoadRes = loadConfig(psConfigContents)) != CFG_ERR_NONE)
+	{
+		*pstrErrorMsg = (iLoadRes == CFG_ERR_FILE) ? "Cannot read config" : ((iLoadRes == CFG_ERR_ATTR_MISSING) ? "Missing attributes in config" : "Syntax error in config");
+		return false;
+	}
+
+	// Load records directory
+	if ((iLoadRes = pcRecordTable->loadDirectory(REC_DIR_PATH, &strErrorMsg)) != REC_ERR_NONE)
+	{
+		*pstrErrorMsg = ((iLoadRes == REC_ERR_FILE) ? "Cannot read records: " : "Syntax error in records: ") + strErrorMsg;
+		return false;
+	}
+
+	// Check if no record is left
+	if (pcRecordTable->size() == 0)
+	{
+		*pstrErrorMsg = "No records specified";
+		return false;
+	}
+
+	// Use TTL of the config for records without their own one
+	pcRecordTable->applyDefaultTTL(psConfigContents->iTTL);
+	return true;
+
+} // loadSnapshot
+
+//
+// reloadConfig
+//
+// Task: Reload config and records while keeping the state of unchanged records and the records added or removed at runtime (pcJournal is NULL if disabled)
+//
+void reloadConfig(SConfigContents* psConfigContents, CRecordTable* pcRecordTable, CRecordTable* pcRuntimeRecords, const std::set<std::string>& setRuntimeRemoved, CRetryScheduler* pcRetryScheduler, CPollScheduler* pcPollScheduler, CJournal* pcJournal, std::map<std::string, std::vector<SDnsServer>>* pmapNameServers, bool bIPKnown, const std::string& strIPv4, const std::string& strIPv6, std::chrono::steady_clock::time_point tNow, std::chrono::steady_clock::time_point* ptNextPoll, int argc, char* argv[])
+{
+	// Variables
+	SConfigContents sNewConfig;
+	CRecordTable cNewTable;
+	std::string strErrorMsg;
+	std::map<SDomRecords*, std::set<std::string>> mapChanged;
+	std::list<SDomRecords>& lstRecords = pcRecordTable->records();
+	size_t iChanged = 0, iRemoved = 0;
+
+
+	// Try to load a new snapshot
+	if (!loadSnapshot(&sNewConfig, &cNewTable, argc, argv, &strErrorMsg))
+	{
+		// Print to terminal and to logfile if enabled
+		std::cerr << COLOR_RED << timeStamp() << "[ERROR]: Cannot reload: " << strErrorMsg << ". Keeping current config and records." << COLOR_DEFAULT << std::endl;
+		g_cLogger.log(LOG_LEVEL_ERROR, "Cannot reload: %s. Keeping current config and records.", strErrorMsg.c_str());
+		return;
+	}
+
+	// Keep settings that are only used at startup
+	if (keepStartupSettings(&sNewConfig, *psConfigContents))
+		std::cerr << COLOR_YELLOW << timeStamp() << "[WARNING]: Changes of NetlinkEvents, WatchConfig, ControlSocket, PushPort, PushAddress, Metrics*, Log* and Cluster* settings require a restart." << COLOR_DEFAULT << std::endl;
+
+	// Keep records that have been added or removed over the control socket
+	for (std::list<SDomRecords>::iterator iRec = pcRuntimeRecords->records().begin(); iRec != pcRuntimeRecords->records().end(); iRec++)
+		for (std::list<SSubDomain>::iterator iSDom = iRec->lstSubDomains.begin(); iSDom != iRec->lstSubDomains.end(); iSDom++)
+			cNewTable.add(iRec->strAPIKey, iRec->strDomain, *iSDom);
+	for (std::set<std::string>::iterator iRemoved = setRuntimeRemoved.begin(); iRemoved != setRuntimeRemoved.end(); iRemoved++)
+		cNewTable.remove(iRemoved->substr(0, iRemoved->find('\t')), iRemoved->substr(iRemoved->find('\t') + 1), [](SDomRecords*) {});
+	cNewTable.applyDefaultTTL(sNewConfig.iTTL);
+
+	// Merge records (removed zones must not be referenced by the scheduler anymore)
+	mapChanged = pcRecordTable->merge(&cNewTable, [pcRetryScheduler](SDomRecords* psDomRecords) { pcRetryScheduler->remove(psDomRecords); }, &iRemoved);
+	if (pcJournal != NULL)
+		pcJournal->prune(lstRecords);
+
+	// All rrsets may change if IPv6 has been switched
+	if (sNewConfig.bEnableIPv6 != psConfigContents->bEnableIPv6)
+		for (std::list<SDomRecords>::iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+			for (std::list<SSubDomain>::iterator iSDom = iRec->lstSubDomains.begin(); iSDom != iRec->lstSubDomains.end(); iSDom++)
+				mapChanged[&(*iRec)].insert(iSDom->strName);
+
+	// Nameservers are looked up again
+	pmapNameServers->clear();
+
+	// Swap in new config (no lookup is running, so the lookup metrics can be extended)
+	if (sNewConfig.strIPService != psConfigContents->strIPService)
+		g_cMetrics.init(splitList(sNewConfig.strIPService, ','));
+	if (g_cCluster.enabled())
+		sNewConfig.bBatchUpdates = false;
+	pcPollScheduler->configure(sNewConfig.bAdaptivePolling, (sNewConfig.bNetlinkEvents ? sNewConfig.iSafetyPollS : sNewConfig.iUpdatePeriodS), std::min(sNewConfig.iUpdatePeriodS, sNewConfig.iPollMinS), sNewConfig.iPollMinS, sNewConfig.iPollMaxS);
+	if ((sNewConfig.iUpdatePeriodS != psConfigContents->iUpdatePeriodS) || (sNewConfig.bAdaptivePolling != psConfigContents->bAdaptivePolling) || (sNewConfig.iPollMinS != psConfigContents->iPollMinS) || (sNewConfig.iPollMaxS != psConfigContents->iPollMaxS))
+		*ptNextPoll = std::min(*ptNextPoll, (tNow + std::chrono::seconds(pcPollScheduler->next(time(NULL)))));
+	*psConfigContents = sNewConfig;
+	pcRetryScheduler->configure(psConfigContents->iRetryBaseS, psConfigContents->iRetryMaxS);
+	g_cRateLimiter.configure(psConfigContents->iAPIRateLimit, psConfigContents->iAPIBurst);
+
+	// Run through all records
+	for (std::list<SDomRecords>::iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+	{
+		// Variables
+		std::map<SDomRecords*, std::set<std::string>>::iterator iEntry = mapChanged.find(&(*iRec));
+		std::set<std::string> setRRSets = rrsetKeys(*iRec, *psConfigContents, strIPv6);
+
+
+		// Forget pending rrsets that do not exist anymore
+		for (std::set<std::string>::iterator iRRSet = iRec->setPending.begin(); iRRSet != iRec->setPending.end();)
+			iRRSet = (setRRSets.count(*iRRSet) == 0) ? iRec->setPending.erase(iRRSet) : std::next(iRRSet);
+		iRec->bUpToData = iRec->setPending.empty();
+
+		// Skip unchanged records (and all if the address is not known yet, the first poll schedules them)
+		if ((iEntry == mapChanged.end()) || (!bIPKnown))
+			continue;
+
+		// Schedule rrsets of added or changed subdomains for an immediate update
+		for (std::set<std::string>::iterator iRRSet = setRRSets.begin(); iRRSet != setRRSets.end(); iRRSet++)
+		{
+			// Skip rrsets of other subdomains
+			if (iEntry->second.count(iRRSet->substr(0, iRRSet->find('\t'))) == 0)
+				continue;
+
+			// Schedule rrset
+			iRec->setPending.insert(*iRRSet);
+			iRec->mapRetries.erase(*iRRSet);
+			iRec->bUpToData = false;
+			pcRetryScheduler->schedule(&(*iRec), *iRRSet, 0, tNow);
+		}
+		if (pcJournal != NULL)
+			pcJournal->want(*iRec, iRec->setPending, strIPv4, strIPv6);
+	}
+
+	// Count added or changed subdomains
+	for (std::map<SDomRecords*, std::set<std::string>>::iterator iEntry = mapChanged.begin(); iEntry != mapChanged.end(); iEntry++)
+		iChanged += iEntry->second.size();
+
+	// Print to terminal and to logfile if enabled
+	std::cout << timeStamp() << "[INFO]: Reloaded config and records (" << pcRecordTable->size() << " records, " << iChanged << " added or changed, " << iRemoved << " removed)." << std::endl;
+	g_cLogger.log(LOG_LEVEL_INFO, "Reloaded config and records (%zu records, %zu added or changed, %zu removed).", pcRecordTable->size(), iChanged, iRemoved);
+	if ((psConfigContents->bBatchUpdates) && (pcRecordTable->shared() != 0))
+		std::cerr << COLOR_YELLOW << timeStamp() << "[WARNING]: " << pcRecordTable->shared() << " domain/s are used with several API keys. Their records are updated one by one instead of in batches." << COLOR_DEFAULT << std::endl;
+
+} // reloadConfig
+
+//
+// keepStartupSettings
+//
+// Task: Take over the settings that are only used at startup from the running config, returns true if any of them has been changed
+//
+bool keepStartupSettings(SConfigContents* psNewConfig, const SConfigContents& sConfigContents)
+{
+	// Variables
+	bool bChanged = false;
+	auto keep = [&bChanged](auto& tNew, const auto& tRunning) { bChanged |= (tNew != tRunning); tNew = tRunning; };
+
+
+	// Take over settings
+	keep(psNewConfig->bNetlinkEvents, sConfigContents.bNetlinkEvents);
+	keep(psNewConfig->bWatchConfig, sConfigContents.bWatchConfig);
+	keep(psNewConfig->iMetricsPort, sConfigContents.iMetricsPort);
+	keep(psNewConfig->strMetricsAddress, sConfigContents.strMetricsAddress);
+	keep(psNewConfig->bLogging, sConfigContents.bLogging);
+	keep(psNewConfig->bLogJson, sConfigContents.bLogJson);
+	keep(psNewConfig->iLogMaxSizeKiB, sConfigContents.iLogMaxSizeKiB);
+	keep(psNewConfig->iLogRotateFiles, sConfigContents.iLogRotateFiles);
+	keep(psNewConfig->strControlSocket, sConfigContents.strControlSocket);
+	keep(psNewConfig->iPushPort, sConfigContents.iPushPort);
+	keep(psNewConfig->strPushAddress, sConfigContents.strPushAddress);
+	keep(psNewConfig->strClusterDir, sConfigContents.strClusterDir);
+	keep(psNewConfig->strClusterNode, sConfigContents.strClusterNode);
+	keep(psNewConfig->iClusterLeaseS, sConfigContents.iClusterLeaseS);
+	return bChanged;
+
+} // keepStartupSettings
+
+//
+// handleControlCommand
+//
+// Task: Handle a command of the control socket (records added or removed at runtime are also kept in pcRuntimeRecords/psetRuntimeRemoved, pcJournal is NULL if disabled)
+//
+std::string handleControlCommand(const std::vector<std::string>& vecArgs, const SConfigContents& sConfigContents, CRecordTable* pcRecordTable, CRecordTable* pcRuntimeRecords, std::set<std::string>* psetRuntimeRemoved, CRetryScheduler* pcRetryScheduler, const CPollScheduler& cPollScheduler, CJournal* pcJournal, bool bIPKnown, const std::string& strIPv4, const std::string& strIPv6, bool* pbPaused, std::chrono::steady_clock::time_point* ptNextPoll)
+{
+	// Variables
+	std::list<SDomRecords>& lstRecords = pcRecordTable->records();
+	std::chrono::steady_clock::time_point tNow = std::chrono::steady_clock::now();
+	std::string strResult;
+
+
+	// Check if empty
+	if (vecArgs.empty())
+		return "ERROR: No command. Commands: status, force-update [<domain>], add [-k <APIKey>] <domain> <subdomain> [TTL] [ipv4|ipv6|both], remove <domain> <subdomain>, pause, resume\n";
+
+	// Print state of all rrsets
+	if (vecArgs[0] == "status")
+	{
+		// Variables
+		char cTime[SMALL_BUFFER];
+
+
+		// General state
+		strResult = "OK\nState: " + std::string(*pbPaused ? "paused" : "running") + "\nAddress: " + (bIPKnown ? (strIPv4 + (strIPv6.empty() ? "" : (" " + strIPv6))) : "unknown") + "\n";
+		strResult += "Next poll: " + std::to_string(std::max<int64_t>(std::chrono::duration_cast<std::chrono::seconds>(*ptNextPoll - tNow).count(), 0)) + "s\n";
+		strResult += "Poll interval: " + std::to_string(cPollScheduler.interval()) + "s (" + cPollScheduler.reason() + ")\n";
+		if (pcJournal != NULL)
+			strResult += "Journal: " + std::to_string(pcJournal->size()) + " pending rrset/s\n";
+		if (g_cCluster.enabled())
+		{
+			strResult += "Cluster: node " + g_cCluster.node() + " (" + g_cCluster.state() + "), live nodes:";
+			for (const std::string& strNode : g_cCluster.nodes())
+				strResult += " " + strNode;
+			strResult += "\n";
+		}
+
+		// Run through zones and their rrsets
+		for (std::list<SDomRecords>::iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+		{
+			// Format time of last attempt
+			if (iRec->tLastAttempt != 0)
+				strftime(cTime, sizeof(cTime), "%d.%m.%Y %H:%M:%S", localtime(&iRec->tLastAttempt));
+			else
+				strcpy(cTime, "never");
+
+			// Run through rrsets
+			for (const std::string& strRRSet : rrsetKeys(*iRec, sConfigContents, strIPv6))
+			{
+				// Variables
+				std::string strType = strRRSet.substr(strRRSet.find('\t') + 1);
+				std::map<std::string, std::string>::iterator iFailed = iRec->mapFailed.find(strRRSet);
+				std::map<std::string, SRetryState>::iterator iRetry = iRec->mapRetries.find(strRRSet);
+				const std::string* pstrOwner = g_cCluster.owner(iRec->strDomain, strRRSet.substr(0, strRRSet.find('\t')));
+
+
+				// Add line
+				strResult += iRec->strDomain + " " + strRRSet.substr(0, strRRSet.find('\t')) + " " + strType + " " + (bIPKnown ? ((strType == "A") ? strIPv4 : strIPv6) : "-") + " ";
+				if ((g_cCluster.enabled()) && (!g_cCluster.owns(iRec->strDomain, strRRSet.substr(0, strRRSet.find('\t')))))
+				{
+					strResult += "owned by " + ((pstrOwner != NULL) ? *pstrOwner : std::string("nobody")) + "\n";
+					continue;
+				}
+				if (iRec->setPending.count(strRRSet) == 0)
+					strResult += (bIPKnown ? ((iRec->mapUnconfirmed.count(strRRSet) != 0) ? "published (unconfirmed)" : "published") : "waiting");
+				else if ((iFailed != iRec->mapFailed.end()) && (iRetry != iRec->mapRetries.end()))
+					strResult += "failed (attempt " + std::to_string(iRetry->second.iAttempts) + ", retry in " + std::to_string(std::max<int64_t>(std::chrono::duration_cast<std::chrono::seconds>(iRetry->second.tNextAttempt - tNow).count(), 0)) + "s)";
+				else
+					strResult += "pending";
+				strResult += ", last attempt " + std::string(cTime);
+				if ((iFailed != iRec->mapFailed.end()) && (iRec->setPending.count(strRRSet) != 0))
+					strResult += ", error: " + iFailed->second;
+				strResult += "\n";
+			}
+		}
+		return strResult;
+	}
+
+	// Force an update of all or one domain (after reading the address again)
+	if (vecArgs[0] == "force-update")
+	{
+		// Variables
+		size_t iScheduled = 0;
+
+
+		// Check if domain exists
+		if ((vecArgs.size() >= 2) && (pcRecordTable->findZone(vecArgs[1]) == NULL))
+			return "ERROR: Unknown domain '" + vecArgs[1] + "'\n";
+
+		// Run through matching zones and schedule all their rrsets
+		*ptNextPoll = tNow;
+		for (std::list<SDomRecords>::iterator iRec = lstRecords.begin(); ((iRec != lstRecords.end()) && (bIPKnown)); iRec++)
+		{
+			// Skip other domains
+			if ((vecArgs.size() >= 2) && (iRec->strDomain != vecArgs[1]))
+				continue;
+
+			// Schedule rrsets
+			iRec->mapRetries.clear();
+			iRec->setPending = rrsetKeys(*iRec, sConfigContents, strIPv6);
+			iRec->bUpToData = false;
+			if (pcJournal != NULL)
+				pcJournal->want(*iRec, iRec->setPending, strIPv4, strIPv6);
+			for (std::set<std::string>::iterator iRRSet = iRec->setPending.begin(); iRRSet != iRec->setPending.end(); iRRSet++, iScheduled++)
+				pcRetryScheduler->schedule(&(*iRec), *iRRSet, 0, tNow);
+		}
+		return "OK\nScheduled " + std::to_string(iScheduled) + " rrset/s" + std::string(*pbPaused ? " (paused)" : "") + ".\n";
+	}
+
+	// Add a record
+	if (vecArgs[0] == "add")
+	{
+		// Variables
+		std::vector<std::string> vecFields(vecArgs.begin() + 1, vecArgs.end());
+		std::string strAPIKey, strErrorMsg;
+		SSubDomain sSubDomain;
+		SDomRecords* psDomRecords;
+
+
+		// Get API key (required for new domains only)
+		if ((vecFields.size() >= 2) && (vecFields[0] == "-k"))
+		{
+			strAPIKey = vecFields[1];
+			vecFields.erase(vecFields.begin(), (vecFields.begin() + 2));
+		}
+		if ((vecFields.size() < 2) || (!CRecordTable::parseSubDomain(vecFields, &sSubDomain, &strErrorMsg)))
+			return "ERROR: " + ((vecFields.size() < 2) ? std::string("Syntax: add [-k <APIKey>] <domain> <subdomain> [TTL] [ipv4|ipv6|both]") : strErrorMsg) + "\n";
+		if ((strAPIKey.empty()) && ((psDomRecords = pcRecordTable->findZone(vecFields[0])) != NULL))
+			strAPIKey = psDomRecords->strAPIKey;
+		if (strAPIKey.empty())
+			return "ERROR: Unknown domain '" + vecFields[0] + "', an API key is required (-k <APIKey>)\n";
+
+		// Add record (kept on reload)
+		if (pcRecordTable->find(vecFields[0], sSubDomain.strName) != NULL)
+			return "ERROR: Record already exists\n";
+		pcRuntimeRecords->add(strAPIKey, vecFields[0], sSubDomain);
+		psetRuntimeRemoved->erase(vecFields[0] + "\t" + sSubDomain.strName);
+		if (sSubDomain.iTTL == 0)
+			sSubDomain.iTTL = sConfigContents.iTTL;
+		pcRecordTable->add(strAPIKey, vecFields[0], sSubDomain);
+
+		// Schedule its rrsets
+		psDomRecords = pcRecordTable->findZone(vecFields[0]);
+		for (const std::string& strRRSet : rrsetKeys(*psDomRecords, sConfigContents, strIPv6))
+		{
+			if ((!bIPKnown) || (strRRSet.compare(0, strRRSet.find('\t'), sSubDomain.strName) != 0))
+				continue;
+			psDomRecords->setPending.insert(strRRSet);
+			psDomRecords->bUpToData = false;
+			pcRetryScheduler->schedule(psDomRecords, strRRSet, 0, tNow);
+			if (pcJournal != NULL)
+				pcJournal->want(*psDomRecords, { strRRSet }, strIPv4, strIPv6);
+		}
+		return "OK\nAdded " + sSubDomain.strName + "." + vecFields[0] + ".\n";
+	}
+
+	// Remove a record (stops updating it, the DNS record itself is kept)
+	if (vecArgs[0] == "remove")
+	{
+		// Check syntax and remove record
+		if (vecArgs.size() != 3)
+			return "ERROR: Syntax: remove <domain> <subdomain>\n";
+		if (!pcRecordTable->remove(vecArgs[1], vecArgs[2], [pcRetryScheduler](SDomRecords* psDomRecords) { pcRetryScheduler->remove(psDomRecords); }))
+			return "ERROR: Unknown record\n";
+
+		// Remember removal (kept on reload)
+		if (!pcRuntimeRecords->remove(vecArgs[1], vecArgs[2], [](SDomRecords*) {}))
+			psetRuntimeRemoved->insert(vecArgs[1] + "\t" + vecArgs[2]);
+		if (pcJournal != NULL)
+			pcJournal->prune(lstRecords);
+		return "OK\nRemoved " + vecArgs[2] + "." + vecArgs[1] + ".\n";
+	}
+
+	// Pause or resume updates (the address is still checked)
+	if ((vecArgs[0] == "pause") || (vecArgs[0] == "resume"))
+	{
+		*pbPaused = (vecArgs[0] == "pause");
+		return std::string("OK\nUpdates ") + (*pbPaused ? "paused" : "resumed") + ".\n";
+	}
+
+	// Unknown command
+	return "ERROR: Unknown command '" + vecArgs[0] + "'\n";
+
+} // handleControlCommand
+
+//
+// handlePushRequest
+//
+// Task: Check a dyndns update of a router and hand its addresses over to the main loop (*pbPush is set), returns the HTTP status
+//
+int handlePushRequest(const std::string& strRequest, const SConfigContents& sConfigContents, const std::string& strLastIPv4, const std::string& strLastIPv6, std::string* pstrPushIPv4, std::string* pstrPushIPv6, bool* pbPush, std::string* pstrHeaders, std::string* pstrBody)
+{
+	// Variables
+	std::map<std::string, std::string> mapQuery;
+	std::string strIPv4, strIPv6;
+	unsigned char cAddr[sizeof(struct in6_addr)];
+
+
+	// Check path and authentication (Basic auth or token in the query)
+	*pstrHeaders = "Content-Type: text/plain\r\n";
+	if (!parsePushRequest(strRequest, &mapQuery))
+	{
+		*pstrBody = "badrequest\n";
+		return 404;
+	}
+	if ((!tokenMatches(mapQuery["token"], sConfigContents.strPushToken)) && (!tokenMatches(mapQuery["password"], sConfigContents.strPushToken)) && (!tokenMatches(mapQuery["\tbasic"], sConfigContents.strPushToken)))
+	{
+		*pstrHeaders += "WWW-Authenticate: Basic realm=\"recUpdater\"\r\n";
+		*pstrBody = "badauth\n";
+		return 401;
+	}
+
+	// Get addresses (myip may contain both families separated by a comma)
+	for (const std::string& strValue : splitList((mapQuery["myip"] + "," + mapQuery["ip"] + "," + mapQuery["myipv6"] + "," + mapQuery["ipv6"]), ','))
+	{
+		if ((strIPv4.empty()) && (inet_pton(AF_INET, strValue.c_str(), cAddr) == 1))
+			strIPv4 = strValue;
+		else if ((strIPv6.empty()) && (inet_pton(AF_INET6, strValue.c_str(), cAddr) == 1))
+			strIPv6 = strValue;
+		else if ((!strValue.empty()) && (inet_pton(AF_INET, strValue.c_str(), cAddr) != 1) && (inet_pton(AF_INET6, strValue.c_str(), cAddr) != 1))
+		{
+			*pstrBody = "badip\n";
+			return 400;
+		}
+	}
+	if (!sConfigContents.bEnableIPv6)
+		strIPv6.clear();
+	if ((strIPv4.empty()) && (strIPv6.empty()))
+	{
+		*pstrBody = "badip\n";
+		return 400;
+	}
+
+	// Hand addresses over to the main loop and answer like dyndns
+	*pstrPushIPv4 = strIPv4;
+	*pstrPushIPv6 = strIPv6;
+	*pbPush = true;
+	*pstrBody = (((strIPv4.empty()) || (strIPv4 == strLastIPv4)) && ((strIPv6.empty()) || (strIPv6 == strLastIPv6)) ? "nochg " : "good ") + (strIPv4.empty() ? strIPv6 : strIPv4) + "\n";
+	return 200;
+
+} // handlePushRequest
+
+//
+// dropForeign
+//
+// Task: Forget the rrsets of subdomains that are owned by other nodes of the cluster (also removed from a set of due rrsets if given, pcJournal is NULL if disabled)
+//
+void dropForeign(SDomRecords* psDomRecords, std::set<std::string>* psetRRSets, CJournal* pcJournal)
+{
+	// Run through subdomains that are not owned
+	for (std::list<SSubDomain>::iterator iSDom = psDomRecords->lstSubDomains.begin(); iSDom != psDomRecords->lstSubDomains.end(); iSDom++)
+	{
+		// Skip owned subdomains
+		if ((iSDom->bOwned = g_cCluster.owns(psDomRecords->strDomain, iSDom->strName)))
+			continue;
+
+		// Run through types
+		for (const char* cType : { "A", "AAAA" })
+		{
+			// Variables
+			std::string strRRSet = iSDom->strName + "\t" + cType;
+
+
+			// Forget rrset (the owner writes it)
+			if (psetRRSets != NULL)
+				psetRRSets->erase(strRRSet);
+			if ((psDomRecords->setPending.erase(strRRSet) != 0) && (pcJournal != NULL))
+				pcJournal->done(psDomRecords->strDomain, iSDom->strName, cType);
+			psDomRecords->mapRetries.erase(strRRSet);
+			psDomRecords->mapFailed.erase(strRRSet);
+			psDomRecords->mapUnconfirmed.erase(strRRSet);
+			psDomRecords->setForce.erase(strRRSet);
+		}
+	}
+	psDomRecords->bUpToData = psDomRecords->setPending.empty();
+
+} // dropForeign
+
+//
+// applyOwners
+//
+// Task: Take over subdomains that are owned now and hand over the others after the owners of the cluster changed (pcJournal is NULL if disabled)
+//
+void applyOwners(std::list<SDomRecords>* plstRecords, const SConfigContents& sConfigContents, CRetryScheduler* pcRetryScheduler, CJournal* pcJournal, bool bIPKnown, const std::string& strIPv4, const std::string& strIPv6, std::chrono::steady_clock::time_point tNow)
+{
+	// Variables
+	std::list<SDomRecords>& lstRecords = *plstRecords;
+	size_t iOwned = 0, iSubDomains = 0;
+
+
+	// Run through all records
+	for (std::list<SDomRecords>::iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+	{
+		// Variables
+		std::set<std::string> setManaged = rrsetKeys(*iRec, sConfigContents, strIPv6);
+
+
+		// Schedule all rrsets of subdomains that are owned now (only differing ones are written if ReadBeforeWrite is enabled)
+		for (std::list<SSubDomain>::iterator iSDom = iRec->lstSubDomains.begin(); iSDom != iRec->lstSubDomains.end(); iSDom++)
+		{
+			// Count subdomain and skip it unless it has been taken over
+			iSubDomains++;
+			if (!g_cCluster.owns(iRec->strDomain, iSDom->strName))
+				continue;
+			iOwned++;
+			if (iSDom->bOwned)
+				continue;
+			iSDom->bOwned = true;
+
+			// Schedule rrsets if the address is known (they are scheduled with it otherwise)
+			for (const char* cType : { "A", "AAAA" })
+			{
+				// Variables
+				std::string strRRSet = iSDom->strName + "\t" + cType;
+
+
+				// Schedule managed rrset
+				if ((!bIPKnown) || (setManaged.count(strRRSet) == 0))
+					continue;
+				iRec->setPending.insert(strRRSet);
+				iRec->bUpToData = false;
+				if (pcJournal != NULL)
+					pcJournal->want(*iRec, { strRRSet }, strIPv4, strIPv6);
+				pcRetryScheduler->schedule(&(*iRec), strRRSet, 0, tNow);
+			}
+		}
+
+		// Forget rrsets of subdomains that have been handed over
+		dropForeign(&(*iRec), NULL, pcJournal);
+	}
+	g_cMetrics.iClusterNodes = g_cCluster.nodes().size();
+	g_cMetrics.iClusterOwned = iOwned;
+
+	// Print to terminal and to logfile if enabled
+	std::cout << timeStamp() << "[INFO]: Cluster has " << g_cCluster.nodes().size() << " live node/s, this node (" << g_cCluster.state() << ") writes " << iOwned << " of " << iSubDomains << " subdomain/s." << std::endl;
+	g_cLogger.log(LOG_LEVEL_INFO, "Cluster has %zu live node/s, this node (%s) writes %zu of %zu subdomain/s.", g_cCluster.nodes().size(), g_cCluster.state(), iOwned, iSubDomains);
+
+} // applyOwners
+
+//
+// domRecordsFromCmdLine
+//
+// Task: Get records from command line
+//
+uint8_t domRecordsFromCmdLine(CRecordTable* pcRecordTable, int argc, char* argv[])
+{
+	// Variables
+	std::string strAPIKey, strDomain;
+
+
+	// No records on the command line (records directory only)
+	if (argc == 1)
+		return REC_ERR_NONE;
+
+	// Check if not enough start parameters have been passed
+	if (argc < 6)
+		return REC_ERR_ARGUMENTS;
+
+	// Run through all start parameters
+	for (int i = 1; i < argc; i++)
+	{
+		// Check whether it is a signal sign
+		if (argv[i][0] == '-')
+		{
+			// Increase iterator
+			i++;
+
+			// Check whether there are not enough parameters
+			if (argc < (i + 2))
+				return REC_ERR_ARGUMENTS;
+
+			switch (argv[i - 1][1])
+			{
+				// API key
+				case 'K':
+				case 'k':
+					// Clear domain and assign API key
+					strDomain.clear();
+					strAPIKey = argv[i];
+					break;
+
+				// Domain
+				case 'D':
+				case 'd':
+					// Assign domain
+					strDomain = argv[i];
+					break;
+
+				// Error
+				default:
+					return REC_ERR_SPECIFER;
+			}
+		}
+		// No signal sign
+		else
+		{
+			// Check if record is valid
+			if ((strAPIKey.length() == 0) || (strDomain.length() == 0))
+				return REC_ERR_APIDOM;
+
+			// Add subdomain to table
+			pcRecordTable->add(strAPIKey, strDomain, SSubDomain(argv[i]));
+		}
+	}
+
+	// Success
+	return REC_ERR_NONE;
+
+} // domRecordsFromCmdLine
+
+//
+// timeStamp
+//
+// Task: Get timastemp (formatted once per second and thread)
+//
+std::string timeStamp()
+{
+	// Variables
+	static thread_local time_t tCached = -1;
+	static thread_local char cTimeStamp[SMALL_BUFFER];
+	time_t tTime = time(NULL);
+	tm sCurTime;
+
+
+	// Format string if the second changed and return result
+	if (tTime != tCached)
+	{
+		localtime_r(&tTime, &sCurTime);
+		snprintf(cTimeStamp, sizeof(cTimeStamp), "[%.2i.%.2i.%i | %.2i:%.2i] ", sCurTime.tm_mday, (sCurTime.tm_mon + 1), (sCurTime.tm_year + 1900), sCurTime.tm_hour, sCurTime.tm_min);
+		tCached = tTime;
+	}
+	return cTimeStamp;
+
+} // timeStamp
+
+//
+// readIPAddress
+//
+// Task: Get IP address of system (both families and all services are raced against each other, a family whose pointer is NULL is skipped)
+//
+bool readIPAddress(std::string *pstrIPv4, std::string *pstrIPv6, SConfigContents sConfigContens, CHttpClient* pcHttpClient, CIPServiceStats* pcIPServiceStats)
+{
+	// Variables
+	std::vector<std::string> vecServices = splitList(sConfigContens.strIPService, ',');
+	long iFamilies[2] = { CURL_IPRESOLVE_V4, CURL_IPRESOLVE_V6 };
+	std::string* pstrResults[2] = { pstrIPv4, pstrIPv6 };
+	bool bDecided[2] = { (pstrIPv4 == NULL), ((pstrIPv6 == NULL) || (!sConfigContens.bEnableIPv6)) };
+	std::map<std::string, uint16_t> mapVotes[2];
+	size_t iPending[2] = { 0, 0 };
+	uint16_t iQuorum = std::min<size_t>(sConfigContens.iIPServiceQuorum, vecServices.size());
+	std::vector<SHttpRequest> vecRequests;
+	std::vector<SHttpResponse> vecResponses;
+	std::vector<uint8_t> vecFamilies;
+
+
+	// Clear results
+	for (uint8_t iFamily = 0; iFamily < 2; iFamily++)
+		if (pstrResults[iFamily] != NULL)
+			pstrResults[iFamily]->clear();
+
+	// Build requests of all families (best ranked services first, the others start staggered)
+	for (uint8_t iFamily = 0; iFamily < 2; iFamily++)
+	{
+		// Skip if not required
+		if (bDecided[iFamily])
+			continue;
+
+		// Run through ranked services
+		std::vector<std::string> vecRanked = pcIPServiceStats->rank(vecServices, iFamilies[iFamily]);
+		for (size_t i = 0; i < vecRanked.size(); i++)
+		{
+			SHttpRequest sRequest;
+			sRequest.strURL = vecRanked[i];
+			sRequest.iTimeoutS = sConfigContens.iCurlTimeout;
+			sRequest.iIPResolve = iFamilies[iFamily];
+			sRequest.iDelayMs = (i < iQuorum) ? 0 : ((i - iQuorum + 1) * IP_RACE_STAGGER_MS);
+			vecRequests.push_back(sRequest);
+			vecFamilies.push_back(iFamily);
+			iPending[iFamily]++;
+		}
+	}
+
+	// Race requests until every family is decided (requests of decided families are canceled)
+	pcHttpClient->race(vecRequests, &vecResponses, [&](size_t iRequest) {
+		// Variables
+		uint8_t iFamily = vecFamilies[iRequest];
+		std::string strIP = vecResponses[iRequest].strBody;
+		unsigned char cAddr[sizeof(struct in6_addr)];
+		bool bValid;
+
+
+		// Remove whitespace and check if the answer is a valid address
+		while ((strIP.length() > 0) && (isspace(strIP.back())))
+			strIP.pop_back();
+		while ((strIP.length() > 0) && (isspace(strIP.front())))
+			strIP.erase(0, 1);
+		bValid = ((vecResponses[iRequest].iStatus == 200) && (inet_pton((iFamily == 0) ? AF_INET : AF_INET6, strIP.c_str(), cAddr) == 1));
+
+		// Update statistics of service
+		pcIPServiceStats->record(vecRequests[iRequest].strURL, iFamilies[iFamily], vecResponses[iRequest].dTimeMs, bValid);
+		g_cMetrics.countLookup(vecRequests[iRequest].strURL, iFamilies[iFamily], vecResponses[iRequest].dTimeMs, bValid, false);
+
+		// Count vote and check if quorum is reached
+		if ((bValid) && (!bDecided[iFamily]) && (++mapVotes[iFamily][strIP] >= iQuorum))
+		{
+			*pstrResults[iFamily] = strIP;
+			bDecided[iFamily] = true;
+		}
+
+		// Give up family if all of its services have answered
+		if (--iPending[iFamily] == 0)
+			bDecided[iFamily] = true;
+	}, [&](size_t iRequest) { return !bDecided[vecFamilies[iRequest]]; });
+
+	// Update statistics of canceled services (they have been slower than the winner)
+	for (size_t i = 0; i < vecResponses.size(); i++)
+	{
+		if ((vecResponses[i].bCanceled) && (vecResponses[i].dTimeMs > 0))
+			pcIPServiceStats->record(vecRequests[i].strURL, vecRequests[i].iIPResolve, vecResponses[i].dTimeMs, true, true);
+		if (vecResponses[i].bCanceled)
+			g_cMetrics.countLookup(vecRequests[i].strURL, vecRequests[i].iIPResolve, vecResponses[i].dTimeMs, false, true);
+	}
+
+	// Check if the IP address could not be loaded
+	if (((pstrIPv4 == NULL) || (pstrIPv4->empty())) && ((pstrIPv6 == NULL) || (pstrIPv6->empty())))
+		return false;
+
+	// Success
+	return true;
+
+} // readIPAddress
+
+//
+// resolveIPAddress
+//
+// Task: Ask the configured sources in order, later sources only fill missing families (or cross-check the found ones)
+//
+bool resolveIPAddress(const std::map<std::string, CIPProvider*>& mapProviders, const SConfigContents& sConfigContents, bool bCrossCheck, std::string* pstrIPv4, std::string* pstrIPv6)
+{
+	// Variables
+	std::vector<std::string> vecSources = splitList(sConfigContents.strIPSource, ',');
+	std::string* pstrResults[2] = { pstrIPv4, pstrIPv6 };
+	std::string strFound[2], strSource[2];
+
+
+	// Run through sources
+	for (size_t i = 0; i < vecSources.size(); i++)
+	{
+		// Variables
+		std::map<std::string, CIPProvider*>::const_iterator iProvider = mapProviders.find(vecSources[i]);
+		bool bMissing[2] = { strFound[0].empty(), ((strFound[1].empty()) && (sConfigContents.bEnableIPv6)) };
+		std::string strRead[2];
+
+
+		// Skip if all families are known and no cross-check is due
+		if ((iProvider == mapProviders.end()) || ((!bMissing[0]) && (!bMissing[1]) && (!bCrossCheck)))
+			continue;
+
+		// Read families (all of them for a cross-check)
+		if (!iProvider->second->read(sConfigContents, ((bMissing[0] || bCrossCheck) ? &strRead[0] : NULL), ((bMissing[1] || (bCrossCheck && sConfigContents.bEnableIPv6)) ? &strRead[1] : NULL)))
+			continue;
+
+		// Take over missing families and compare the known ones
+		for (uint8_t iFamily = 0; iFamily < 2; iFamily++)
+		{
+			if (strRead[iFamily].empty())
+				continue;
+			if (strFound[iFamily].empty())
+			{
+				strFound[iFamily] = strRead[iFamily];
+				strSource[iFamily] = vecSources[i];
+			}
+			else if (strFound[iFamily] != strRead[iFamily])
+			{
+				// Count mismatch and print to terminal and to logfile if enabled (the first source wins)
+				g_cMetrics.iCrossCheckMismatches++;
+				std::cerr << COLOR_YELLOW << timeStamp() << "[WARNING]: Cross-check failed: " << strSource[iFamily] << " reports " << strFound[iFamily] << ", " << vecSources[i] << " reports " << strRead[iFamily] << "." << COLOR_DEFAULT << std::endl;
+				g_cLogger.log(LOG_LEVEL_WARNING, "Cross-check failed: %s reports %s, %s reports %s.", strSource[iFamily].c_str(), strFound[iFamily].c_str(), vecSources[i].c_str(), strRead[iFamily].c_str());
+			}
+		}
+	}
+
+	// Check if failed (the last known addresses are kept)
+	if ((strFound[0].empty()) && (strFound[1].empty()))
+		return false;
+
+	// Return results
+	*pstrResults[0] = strFound[0];
+	*pstrResults[1] = strFound[1];
+	return true;
+
+} // resolveIPAddress
+
+//
+// splitList
+//
+// Task: Split a separated list and trim its elements
+//
+std::vector<std::string> splitList(const std::string& strList, char cSeparator)
+{
+	// Variables
+	std::vector<std::string> vecResult;
+	size_t iStart = 0, iEnd;
+
+
+	// Run through elements
+	while (iStart <= strList.length())
+	{
+		// Find end of element
+		if ((iEnd = strList.find(cSeparator, iStart)) == std::string::npos)
+			iEnd = strList.length();
+
+		// Trim element and add it if not empty
+		std::string strElement = strList.substr(iStart, (iEnd - iStart));
+		while ((strElement.length() > 0) && (isspace(strElement.back())))
+			strElement.pop_back();
+		while ((strElement.length() > 0) && (isspace(strElement.front())))
+			strElement.erase(0, 1);
+		if (strElement.length() > 0)
+			vecResult.push_back(strElement);
+
+		// Next element
+		iStart = iEnd + 1;
+	}
+
+	// Return result
+	return vecResult;
+
+} // splitList
+
+//
+// updateRecords
+//
+// Task: Update the records of the given updates as tasks on the calling thread (at most MaxParallelUpdates records at once)
+//
+void updateRecords(std::list<SPendingUpdate>* plstPending, const SConfigContents& sConfigContents, const std::string& strIPv4, const std::string& strIPv6, CHttpClient* pcHttpClient, CZoneCache* pcZoneCache, std::function<void(SPendingUpdate*)> fnDone)
+{
+	// Variables
+	CTaskGroup cTasks(pcHttpClient);
+	std::list<SPendingUpdate>::iterator iNext = plstPending->begin();
+	size_t iRunning = 0, iMaxRunning = std::max<size_t>(sConfigContents.iMaxParallelUpdates, 1);
+	bool bStarting = false;
+	std::function<void()> fnStart;
+	std::function<void(SPendingUpdate*)> fnFinished;
+
+
+	// Start further updates as long as the limit allows (not nested, updates that finish right away are refilled by the outer call)
+	fnStart = [&]() {
+		// Skip if already starting
+		if (bStarting)
+			return;
+		bStarting = true;
+
+		// Start updates
+		while ((iNext != plstPending->end()) && (iRunning < iMaxRunning))
+		{
+			// Variables
+			SPendingUpdate* psPending = &(*(iNext++));
+
+
+			// Assign context of the task and start it
+			psPending->psConfigContents = &sConfigContents;
+			psPending->pstrIPs[0] = &strIPv4;
+			psPending->pstrIPs[1] = &strIPv6;
+			psPending->pcTasks = &cTasks;
+			psPending->pcZoneCache = pcZoneCache;
+			psPending->pfnDone = &fnFinished;
+			iRunning++;
+			updateRecord(psPending);
+		}
+		bStarting = false;
+	};
+
+	// Report finished updates and refill
+	fnFinished = [&](SPendingUpdate* psPending) {
+		iRunning--;
+		if (fnDone)
+			fnDone(psPending);
+		fnStart();
+	};
+
+	// Start first updates and run until all are done
+	fnStart();
+	cTasks.run();
+
+} // updateRecords
+
+//
+// updateRecord
+//
+// Task: Update the given rrsets of a record (failed ones are collected, the others are still processed)
+//
+void updateRecord(SPendingUpdate* psPending)
+{
+	// Variables
+	SDomRecords* psDomRecords = &(*psPending->iRec);
+
+
+	// Reset results
+	psDomRecords->iWritten = 0;
+	psDomRecords->mapFailed.clear();
+	psPending->bResult = false;
+	psPending->strErrorMsg.clear();
+
+	// Compile requests of the record if required, all answers are taken by the task (captures a single pointer, so no allocation is required)
+	compileTemplate(psDomRecords, *psPending->psConfigContents);
+	psDomRecords->sTemplate.sTransfer.fnDone = [psPending](bool bSent) { answerRecord(psPending, bSent); };
+
+	// Try to update all subdomains with a single request if enabled (reads the current records of the zone first, the request replaces the whole zone, so not for a domain used with several API keys)
+	if ((!psPending->psConfigContents->bBatchUpdates) || (psDomRecords->bShared))
+	{
+		updateSingle(psPending);
+		return;
+	}
+	psPending->eStage = SPendingUpdate::STAGE_BATCH_READ;
+	psPending->pcZoneCache->prepareRead(psDomRecords, &psDomRecords->sTemplate.sTransfer.sRequest);
+	sendRequest(psPending);
+
+} // updateRecord
+
+//
+// updateSingle
+//
+// Task: Update the rrsets of a record one by one (reading the current rrsets first if enabled, unconditional updates if not available)
+//
+void updateSingle(SPendingUpdate* psPending)
+{
+	// Variables
+	SDomRecords* psDomRecords = &(*psPending->iRec);
+
+
+	// Give up if canceled
+	if (psPending->pcTasks->canceled())
+	{
+		(*psPending->pfnDone)(psPending);
+		return;
+	}
+
+	// Write rrsets right away if the zone is not read
+	if (!psPending->psConfigContents->bReadBeforeWrite)
+	{
+		writeRecord(psPending, false);
+		return;
+	}
+
+	// Read zone
+	psPending->eStage = SPendingUpdate::STAGE_READ;
+	psPending->pcZoneCache->prepareRead(psDomRecords, &psDomRecords->sTemplate.sTransfer.sRequest);
+	sendRequest(psPending);
+
+} // updateSingle
+
+//
+// answerRecord
+//
+// Task: Learn from the answer to a request of a record and continue its update
+//
+void answerRecord(SPendingUpdate* psPending, bool bSent)
+{
+	// Variables
+	SDomRecords* psDomRecords = &(*psPending->iRec);
+	SHttpTransfer* psTransfer = &psDomRecords->sTemplate.sTransfer;
+
+
+	// Learn from the answer
+	g_cRateLimiter.update(psDomRecords->strAPIKey, psTransfer->sResponse);
+	g_cMetrics.countRequest(psDomRecords, psTransfer->sResponse);
+
+	// Continue update
+	stepRecord(psPending, bSent);
+
+} // answerRecord
+
+//
+// stepRecord
+//
+// Task: Continue the update of a record with the result of its current request
+//
+void stepRecord(SPendingUpdate* psPending, bool bSent)
+{
+	// Variables
+	SDomRecords* psDomRecords = &(*psPending->iRec);
+	const SHttpResponse& sResponse = psDomRecords->sTemplate.sTransfer.sResponse;
+
+
+	// Check stage
+	switch (psPending->eStage)
+	{
+		// Zone read for a batch update: replace it if required, fall back to single updates if not available
+		case SPendingUpdate::STAGE_BATCH_READ:
+			if (psPending->pcZoneCache->readResult(psDomRecords, bSent, sResponse, &psPending->sZone, &psPending->strErrorMsg))
+				writeZone(psPending);
+			else
+				updateSingle(psPending);
+			break;
+
+		// Zone replaced: remember amount of written rrsets, fall back to single updates if failed
+		case SPendingUpdate::STAGE_BATCH_WRITE:
+			if ((!bSent) || (sResponse.iStatus < 200) || (sResponse.iStatus > 299))
+			{
+				psPending->strErrorMsg = (sResponse.strError.length() > 0) ? sResponse.strError : ((sResponse.iStatus == 429) ? RATE_LIMITED_MSG : ("HTTP status " + std::to_string(sResponse.iStatus)));
+				updateSingle(psPending);
+				break;
+			}
+			psDomRecords->iWritten = psPending->iManaged;
+			psDomRecords->setForce.clear();
+			psDomRecords->tLastVerified = time(NULL);
+			psPending->bResult = true;
+			(*psPending->pfnDone)(psPending);
+			break;
+
+		// Zone read for single updates: write the rrsets that differ (all if not available)
+		case SPendingUpdate::STAGE_READ:
+			writeRecord(psPending, psPending->pcZoneCache->readResult(psDomRecords, bSent, sResponse, &psPending->sZone, NULL));
+			break;
+
+		// Rrset written: collect failure and write the next one
+		case SPendingUpdate::STAGE_WRITE:
+			checkWrite(psPending, bSent);
+			writeNext(psPending);
+			break;
+	}
+
+} // stepRecord
+
+//
+// writeRecord
+//
+// Task: Write all requested rrsets of a record that differ from the zone
+//
+void writeRecord(SPendingUpdate* psPending, bool bZone)
+{
+	// Variables
+	const char* cTypes[2] = { "A", "AAAA" };
+	SDomRecords* psDomRecords = &(*psPending->iRec);
+	std::unordered_map<std::string, const SJsonValue*> mapZone;
+
+
+	// Index current rrsets if available
+	if (bZone)
+		mapZone = indexZone(psPending->sZone);
+
+	// Collect rrsets that are requested and differ or have to be written again (keys are built in a reused buffer)
+	psPending->vecWrites.clear();
+	psPending->iNextWrite = 0;
+	for (std::list<SSubDomain>::iterator iSDom = psDomRecords->lstSubDomains.begin(); iSDom != psDomRecords->lstSubDomains.end(); iSDom++)
+	{
+		for (uint8_t iType = 0; iType < 2; iType++)
+		{
+			psPending->strKey.assign(iSDom->strName).append(1, '\t').append(cTypes[iType]);
+			if ((psPending->setRRSets.count(psPending->strKey) != 0) && ((!bZone) || (psDomRecords->setForce.count(psPending->strKey) != 0) || (!rrsetMatches(mapZone, iSDom->strName, cTypes[iType], *psPending->pstrIPs[iType], iSDom->iTTL))))
+				psPending->vecWrites.push_back(std::make_pair(&(*iSDom), cTypes[iType]));
+		}
+	}
+
+	// Write them one after another
+	writeNext(psPending);
+
+} // writeRecord
+
+//
+// writeNext
+//
+// Task: Write the next collected rrset of a record (the update is finished after the last one or if canceled)
+//
+void writeNext(SPendingUpdate* psPending)
+{
+	// Variables
+	SDomRecords* psDomRecords = &(*psPending->iRec);
+	SHttpRequest* psRequest = &psDomRecords->sTemplate.sTransfer.sRequest;
+	const SSubDomain* psSubDomain;
+	uint8_t iType;
+	char cBody[BIG_BUFFER];
+	int iLength;
+
+
+	// Finish update if all rrsets are written
+	if ((psPending->iNextWrite >= psPending->vecWrites.size()) || (psPending->pcTasks->canceled()))
+	{
+		finishRecord(psPending);
+		(*psPending->pfnDone)(psPending);
+		return;
+	}
+
+	// Splice value and TTL into the precompiled request of the rrset (all buffers keep their capacity)
+	psSubDomain = psPending->vecWrites[psPending->iNextWrite].first;
+	iType = (psPending->vecWrites[psPending->iNextWrite++].second[1] == '\0') ? 0 : 1;
+	iLength = snprintf(cBody, sizeof(cBody), "{\"rrset_ttl\": %i, \"rrset_values\": [\"%s\"]}", psSubDomain->iTTL, psPending->pstrIPs[iType]->c_str());
+	psRequest->strMethod.assign("PUT");
+	psRequest->strURL.assign(psSubDomain->strURLs[iType]);
+	psRequest->strBody.assign(cBody, std::min<size_t>(std::max(iLength, 0), (sizeof(cBody) - 1)));
+	psRequest->lstHeaders.clear();
+	psRequest->pHeaders = psDomRecords->sTemplate.pHeaders.get();
+
+	// Send request
+	psPending->eStage = SPendingUpdate::STAGE_WRITE;
+	sendRequest(psPending);
+
+} // writeNext
+
+//
+// checkWrite
+//
+// Task: Check the answer to a written rrset (the message of the API is only copied if it failed)
+//
+void checkWrite(SPendingUpdate* psPending, bool bSent)
+{
+	// Variables
+	SDomRecords* psDomRecords = &(*psPending->iRec);
+	const SHttpResponse& sResponse = psDomRecords->sTemplate.sTransfer.sResponse;
+	const std::pair<const SSubDomain*, const char*>& sWrite = psPending->vecWrites[psPending->iNextWrite - 1];
+	const std::string& strSuccessMsg = psPending->psConfigContents->strSuccessMsg;
+	size_t iMsgStart, iMsgLength;
+	bool bMessage;
+
+
+	// Build key of the rrset
+	psPending->strKey.assign(sWrite.first->strName).append(1, '\t').append(sWrite.second);
+
+	// Check if not sent or throttled
+	if (!bSent)
+	{
+		psDomRecords->mapFailed[psPending->strKey] = sResponse.strError;
+		return;
+	}
+	if (sResponse.iStatus == 429)
+	{
+		psDomRecords->mapFailed[psPending->strKey] = RATE_LIMITED_MSG;
+		return;
+	}
+
+	// Check if execution was successfull (message of the API if available, otherwise the whole answer)
+	bMessage = scanJsonString(sResponse.strBody, "message", &iMsgStart, &iMsgLength);
+	if (!(bMessage ? containsNoCase(sResponse.strBody.data() + iMsgStart, iMsgLength, strSuccessMsg) : containsNoCase(sResponse.strBody.data(), sResponse.strBody.length(), strSuccessMsg)))
+	{
+		psDomRecords->mapFailed[psPending->strKey] = bMessage ? sResponse.strBody.substr(iMsgStart, iMsgLength) : "Unknown error";
+		return;
+	}
+
+	// Success
+	if (!psDomRecords->setForce.empty())
+		psDomRecords->setForce.erase(psPending->strKey);
+	psDomRecords->iWritten++;
+
+} // checkWrite
+
+//
+// finishRecord
+//
+// Task: Set the result of an update whose rrsets have all been answered
+//
+void finishRecord(SPendingUpdate* psPending)
+{
+	// Variables
+	SDomRecords* psDomRecords = &(*psPending->iRec);
+
+
+	// Check if canceled
+	if (g_sigInterrupt)
+		return;
+
+	// Check if any rrset failed
+	if (!psDomRecords->mapFailed.empty())
+	{
+		// Assign error message
+		psPending->strErrorMsg.clear();
+		for (std::map<std::string, std::string>::iterator iFailed = psDomRecords->mapFailed.begin(); iFailed != psDomRecords->mapFailed.end(); iFailed++)
+			psPending->strErrorMsg += (psPending->strErrorMsg.empty() ? "" : ", ") + iFailed->first.substr(0, iFailed->first.find('\t')) + "/" + iFailed->first.substr(iFailed->first.find('\t') + 1) + ": " + iFailed->second;
+		return;
+	}
+
+	// Set verification time and result
+	psDomRecords->tLastVerified = time(NULL);
+	psPending->bResult = true;
+
+} // finishRecord
+
+//
+// compileTemplate
+//
+// Task: Build the URLs and headers of the requests of a record once (again if the API changed, subdomains that were added later are built on demand)
+//
+void compileTemplate(SDomRecords* psDomRecords, const SConfigContents& sConfigContents)
+{
+	// Variables
+	const char* cTypes[2] = { "A", "AAAA" };
+	SRequestTemplate* psTemplate = &psDomRecords->sTemplate;
+
+
+	// Build record wide parts if missing or the API changed (URLs of all subdomains are outdated then)
+	if ((psTemplate->pHeaders == nullptr) || (psTemplate->strAPI != sConfigContents.strAPI))
+	{
+		// Variables
+		struct curl_slist* pHeaders = curl_slist_append(NULL, ("X-Api-Key: " + psDomRecords->strAPIKey).c_str());
+
+
+		// Build header list (shared by copies of the record) and zone URL
+		pHeaders = curl_slist_append(pHeaders, "Content-Type: application/json");
+		psTemplate->pHeaders = std::shared_ptr<struct curl_slist>(pHeaders, curl_slist_free_all);
+		psTemplate->strAPI = sConfigContents.strAPI;
+		psTemplate->strZoneURL = sConfigContents.strAPI + "/domains/" + psDomRecords->strDomain + "/records";
+		for (std::list<SSubDomain>::iterator iSDom = psDomRecords->lstSubDomains.begin(); iSDom != psDomRecords->lstSubDomains.end(); iSDom++)
+		{
+			iSDom->strURLs[0].clear();
+			iSDom->strURLs[1].clear();
+		}
+	}
+
+	// Build rrset URLs of subdomains that have none yet
+	for (std::list<SSubDomain>::iterator iSDom = psDomRecords->lstSubDomains.begin(); iSDom != psDomRecords->lstSubDomains.end(); iSDom++)
+		for (uint8_t iType = 0; iType < 2; iType++)
+			if (iSDom->strURLs[iType].empty())
+				iSDom->strURLs[iType] = psTemplate->strZoneURL + "/" + iSDom->strName + "/" + cTypes[iType];
+
+} // compileTemplate
+
+//
+// rrsetKeys
+//
+// Task: Get the keys (subdomain and type) of all rrsets of a record (depending on the families of each subdomain)
+//
+std::set<std::string> rrsetKeys(const SDomRecords& sDomRecords, const SConfigContents& sConfigContents, const std::string& strIPv6)
+{
+	// Variables
+	std::set<std::string> setResult;
+
+
+	// Run through subdomains
+	for (std::list<SSubDomain>::const_iterator iSDom = sDomRecords.lstSubDomains.begin(); iSDom != sDomRecords.lstSubDomains.end(); iSDom++)
+	{
+		// Add IPv4 rrset if enabled and IPv6 rrset if enabled and valid
+		if (iSDom->bIPv4)
+			setResult.insert(iSDom->strName + "\tA");
+		if ((iSDom->bIPv6) && (sConfigContents.bEnableIPv6) && (strIPv6.length() != 0))
+			setResult.insert(iSDom->strName + "\tAAAA");
+	}
+
+	// Return result
+	return setResult;
+
+} // rrsetKeys
+
+//
+// writeZone
+//
+// Task: Replace the rrsets of a zone whose current records are read (if any managed rrset differs)
+//
+void writeZone(SPendingUpdate* psPending)
+{
+	// Variables
+	SDomRecords* psDomRecords = &(*psPending->iRec);
+	SHttpRequest* psRequest = &psDomRecords->sTemplate.sTransfer.sRequest;
+	const SJsonValue& sZone = psPending->sZone;
+	const std::string& strIPv4 = *psPending->pstrIPs[0];
+	const std::string& strIPv6 = *psPending->pstrIPs[1];
+	std::set<std::string> setManaged = rrsetKeys(*psDomRecords, *psPending->psConfigContents, strIPv6);
+	std::unordered_map<std::string, const SJsonValue*> mapZone;
+	std::string* pstrBody = &psRequest->strBody;
+	bool bFirst = true, bChanged = false;
+
+
+	// Check if any managed rrset differs or has to be written again
+	mapZone = indexZone(sZone);
+	bChanged = !psDomRecords->setForce.empty();
+	for (std::list<SSubDomain>::iterator iSDom = psDomRecords->lstSubDomains.begin(); ((iSDom != psDomRecords->lstSubDomains.end()) && (!bChanged)); iSDom++)
+		if (((setManaged.count(iSDom->strName + "\tA") != 0) && (!rrsetMatches(mapZone, iSDom->strName, "A", strIPv4, iSDom->iTTL))) || ((setManaged.count(iSDom->strName + "\tAAAA") != 0) && (!rrsetMatches(mapZone, iSDom->strName, "AAAA", strIPv6, iSDom->iTTL))))
+			bChanged = true;
+
+	// Nothing to do if the zone is up to date
+	if (!bChanged)
+	{
+		psDomRecords->tLastVerified = time(NULL);
+		psPending->bResult = true;
+		(*psPending->pfnDone)(psPending);
+		return;
+	}
+
+	// Keep all rrsets that are not managed by this record
+	pstrBody->assign("{\"items\": [");
+	for (size_t i = 0; i < sZone.vecItems.size(); i++)
+	{
+		// Variables
+		const SJsonValue* psName = sZone.vecItems[i].member("rrset_name");
+		const SJsonValue* psType = sZone.vecItems[i].member("rrset_type");
+		const SJsonValue* psTTL = sZone.vecItems[i].member("rrset_ttl");
+		const SJsonValue* psValues = sZone.vecItems[i].member("rrset_values");
+
+
+		// Skip invalid rrsets
+		if ((psName == NULL) || (psType == NULL) || (psValues == NULL) || (psValues->eType != SJsonValue::JSON_ARRAY))
+			continue;
+
+		// Skip managed rrsets
+		if (setManaged.count(psName->strValue + "\t" + psType->strValue) != 0)
+			continue;
+
+		// Append rrset
+		*pstrBody += std::string(bFirst ? "" : ", ") + "{\"rrset_name\": \"" + jsonEscape(psName->strValue) + "\", \"rrset_type\": \"" + jsonEscape(psType->strValue) + "\", ";
+		if (psTTL != NULL)
+			*pstrBody += "\"rrset_ttl\": " + psTTL->strValue + ", ";
+		*pstrBody += "\"rrset_values\": [";
+		for (size_t j = 0; j < psValues->vecItems.size(); j++)
+			*pstrBody += std::string(j ? ", " : "") + "\"" + jsonEscape(psValues->vecItems[j].strValue) + "\"";
+		*pstrBody += "]}";
+		bFirst = false;
+	}
+
+	// Append managed rrsets of all subdomains
+	for (std::list<SSubDomain>::iterator iSDom = psDomRecords->lstSubDomains.begin(); iSDom != psDomRecords->lstSubDomains.end(); iSDom++)
+	{
+		// IPv4 if enabled
+		if (setManaged.count(iSDom->strName + "\tA") != 0)
+		{
+			*pstrBody += std::string(bFirst ? "" : ", ") + "{\"rrset_name\": \"" + jsonEscape(iSDom->strName) + "\", \"rrset_type\": \"A\", \"rrset_ttl\": " + std::to_string(iSDom->iTTL) + ", \"rrset_values\": [\"" + jsonEscape(strIPv4) + "\"]}";
+			bFirst = false;
+		}
+
+		// IPv6 if enabled and valid
+		if (setManaged.count(iSDom->strName + "\tAAAA") != 0)
+		{
+			*pstrBody += std::string(bFirst ? "" : ", ") + "{\"rrset_name\": \"" + jsonEscape(iSDom->strName) + "\", \"rrset_type\": \"AAAA\", \"rrset_ttl\": " + std::to_string(iSDom->iTTL) + ", \"rrset_values\": [\"" + jsonEscape(strIPv6) + "\"]}";
+			bFirst = false;
+		}
+	}
+	*pstrBody += "]}";
+
+	// Replace zone records
+	psRequest->strMethod.assign("PUT");
+	psRequest->strURL.assign(psDomRecords->sTemplate.strZoneURL);
+	psRequest->lstHeaders.clear();
+	psRequest->pHeaders = psDomRecords->sTemplate.pHeaders.get();
+	psPending->iManaged = setManaged.size();
+	psPending->eStage = SPendingUpdate::STAGE_BATCH_WRITE;
+	sendRequest(psPending);
+
+} // writeZone
+
+//
+// indexZone
+//
+// Task: Index the rrsets of a zone by name and type
+//
+std::unordered_map<std::string, const SJsonValue*> indexZone(const SJsonValue& sZone)
+{
+	// Variables
+	std::unordered_map<std::string, const SJsonValue*> mapResult;
+
+
+	// Run through rrsets
+	mapResult.reserve(sZone.vecItems.size());
+	for (size_t i = 0; i < sZone.vecItems.size(); i++)
+	{
+		// Variables
+		const SJsonValue* psName = sZone.vecItems[i].member("rrset_name");
+		const SJsonValue* psType = sZone.vecItems[i].member("rrset_type");
+
+
+		// Add valid rrsets
+		if ((psName != NULL) && (psType != NULL))
+			mapResult[psName->strValue + "\t" + psType->strValue] = &sZone.vecItems[i];
+	}
+
+	// Return result
+	return mapResult;
+
+} // indexZone
+
+//
+// rrsetMatches
+//
+// Task: Check if an indexed zone contains an rrset with exactly the given value and TTL
+//
+bool rrsetMatches(const std::unordered_map<std::string, const SJsonValue*>& mapZone, const std::string& strName, const char* cType, const std::string& strValue, uint16_t iTTL)
+{
+	// Variables
+	std::unordered_map<std::string, const SJsonValue*>::const_iterator iRRSet = mapZone.find(strName + "\t" + cType);
+	const SJsonValue* psTTL;
+	const SJsonValue* psValues;
+
+
+	// Rrset missing
+	if (iRRSet == mapZone.end())
+		return false;
+
+	// Compare value and TTL
+	psTTL = iRRSet->second->member("rrset_ttl");
+	psValues = iRRSet->second->member("rrset_values");
+	return ((psValues != NULL) && (psValues->vecItems.size() == 1) && (psValues->vecItems[0].strValue == strValue) && (psTTL != NULL) && (atoi(psTTL->strValue.c_str()) == iTTL));
+
+} // rrsetMatches
+
+//
+// CZoneCache::prepareRead
+//
+// Task: Prepare the request for the current rrsets of a domain (conditional request if the zone is cached)
+//
+void CZoneCache::prepareRead(const SDomRecords* psDomRecords, SHttpRequest* psRequest)
+{
+	// Lock zones
+	std::lock_guard<std::mutex> lockZones(m_mtxZones);
+
+
+	// Variables
+	std::map<std::string, SZoneCacheEntry>::iterator iZone = m_mapZones.find(psDomRecords->strDomain);
+
+
+	// Build request
+	psRequest->strMethod.assign("GET");
+	psRequest->strURL.assign(psDomRecords->sTemplate.strZoneURL);
+	psRequest->strBody.clear();
+	psRequest->pHeaders = NULL;
+	psRequest->lstHeaders.assign(1, "X-Api-Key: " + psDomRecords->strAPIKey);
+
+	// Add entity tag of cached zone if available
+	if ((iZone != m_mapZones.end()) && (iZone->second.strETag.length() > 0))
+		psRequest->lstHeaders.push_back("If-None-Match: " + iZone->second.strETag);
+
+} // CZoneCache::prepareRead
+
+//
+// CZoneCache::readResult
+//
+// Task: Get the current rrsets of a domain from the answer to its request (unchanged zones are taken from the cache)
+//
+bool CZoneCache::readResult(const SDomRecords* psDomRecords, bool bSent, const SHttpResponse& sResponse, SJsonValue* psZone, std::string* pstrErrorMsg)
+{
+	// Check if not sent
+	if (!bSent)
+	{
+		// Assign error message if required and return
+		if (pstrErrorMsg != NULL)
+			*pstrErrorMsg = sResponse.strError;
+		return false;
+	}
+
+	// Zone unchanged
+	if (sResponse.iStatus == 304)
+	{
+		std::lock_guard<std::mutex> lockZones(m_mtxZones);
+		std::map<std::string, SZoneCacheEntry>::iterator iZone = m_mapZones.find(psDomRecords->strDomain);
+		if (iZone != m_mapZones.end())
+		{
+			*psZone = iZone->second.sZone;
+			return true;
+		}
+	}
+
+	// Check for failure
+	if ((sResponse.iStatus != 200) || (!parseJson(sResponse.strBody, psZone)) || (psZone->eType != SJsonValue::JSON_ARRAY))
+	{
+		// Assign error message if required and return
+		if (pstrErrorMsg != NULL)
+			*pstrErrorMsg = "Cannot read zone (HTTP status " + std::to_string(sResponse.iStatus) + ")";
+		return false;
+	}
+
+	// Update cache if an entity tag is available
+	if (sResponse.strETag.length() > 0)
+	{
+		std::lock_guard<std::mutex> lockZones(m_mtxZones);
+		m_mapZones[psDomRecords->strDomain].strETag = sResponse.strETag;
+		m_mapZones[psDomRecords->strDomain].sZone = *psZone;
+	}
+
+	// Success
+	return true;
+
+} // CZoneCache::readResult
+
+//
+// apiRequest
+//
+// Task: Send a request to the API once the rate limit of the API key allows it
+//
+bool apiRequest(const SDomRecords* psDomRecords, const char* cMethod, const std::string& strURL, const std::list<std::string>& lstHeaders, const std::string& strBody, const SConfigContents& sConfigContents, CHttpClient* pcHttpClient, SHttpResponse* psResponse)
+{
+	// Variables
+	SHttpRequest sRequest;
+	bool bSent;
+
+
+	// Wait for the rate limit (only fails if canceled)
+	if (!g_cRateLimiter.acquire(psDomRecords->strAPIKey))
+	{
+		psResponse->strError = "Canceled";
+		return false;
+	}
+
+	// Build request, send it and learn from the answer
+	sRequest.strMethod = cMethod;
+	sRequest.strURL = strURL;
+	sRequest.lstHeaders = lstHeaders;
+	sRequest.strBody = strBody;
+	sRequest.iTimeoutS = sConfigContents.iCurlTimeout;
+	sRequest.iHttpVersion = sConfigContents.iHttpVersion;
+	bSent = pcHttpClient->request(sRequest, psResponse);
+	g_cRateLimiter.update(psDomRecords->strAPIKey, *psResponse);
+	g_cMetrics.countRequest(psDomRecords, *psResponse);
+	return bSent;
+
+} // apiRequest
+
+//
+// sendRequest
+//
+// Task: Send the prepared request of a record once the rate limit of its API key allows it (waits as a timer of the task group)
+//
+void sendRequest(SPendingUpdate* psPending)
+{
+	// Variables
+	SDomRecords* psDomRecords = &(*psPending->iRec);
+	SHttpTransfer* psTransfer = &psDomRecords->sTemplate.sTransfer;
+	std::chrono::steady_clock::time_point tReady;
+
+
+	// Give up if canceled
+	if (psPending->pcTasks->canceled())
+	{
+		psTransfer->sResponse.reset();
+		psTransfer->sResponse.bCanceled = true;
+		psTransfer->sResponse.strError = "Canceled";
+		stepRecord(psPending, false);
+		return;
+	}
+
+	// Do not write if the owners of the cluster changed since the update was queued (another node may own the rrsets now)
+	if (((psPending->eStage == SPendingUpdate::STAGE_WRITE) || (psPending->eStage == SPendingUpdate::STAGE_BATCH_WRITE)) && (psPending->iGeneration != g_cCluster.generation()))
+	{
+		psTransfer->sResponse.reset();
+		psTransfer->sResponse.strError = CLUSTER_MOVED_MSG;
+		stepRecord(psPending, false);
+		return;
+	}
+
+	// Try again once the rate limit allows it
+	if (!g_cRateLimiter.tryAcquire(psDomRecords->strAPIKey, &tReady))
+	{
+		psPending->pcTasks->after(tReady, [psPending]() { sendRequest(psPending); });
+		return;
+	}
+
+	// Send request (the answer is taken by answerRecord)
+	psTransfer->sRequest.iTimeoutS = psPending->psConfigContents->iCurlTimeout;
+	psTransfer->sRequest.iHttpVersion = psPending->psConfigContents->iHttpVersion;
+	psPending->pcTasks->request(psTransfer);
+
+} // sendRequest
+
+//
+// lookupNameServers
+//
+// Task: Get the addresses of the nameservers of a domain (from the config or the API)
+//
+bool lookupNameServers(const SDomRecords* psDomRecords, const SConfigContents& sConfigContents, CHttpClient* pcHttpClient, std::vector<SDnsServer>* pvecServers, std::string* pstrErrorMsg)
+{
+	// Variables
+	std::vector<std::string> vecNames = splitList(sConfigContents.strDNSServers, ',');
+	SHttpResponse sResponse;
+	SJsonValue sList;
+
+
+	// Ask the API if no nameservers are configured
+	if (vecNames.empty())
+	{
+		// Send request
+		if (!apiRequest(psDomRecords, "GET", sConfigContents.strAPI + "/domains/" + psDomRecords->strDomain + "/nameservers", { "X-Api-Key: " + psDomRecords->strAPIKey }, "", sConfigContents, pcHttpClient, &sResponse))
+		{
+			*pstrErrorMsg = sResponse.strError;
+			return false;
+		}
+
+		// Check for failure
+		if ((sResponse.iStatus != 200) || (!parseJson(sResponse.strBody, &sList)) || (sList.eType != SJsonValue::JSON_ARRAY))
+		{
+			*pstrErrorMsg = "Cannot read nameservers (HTTP status " + std::to_string(sResponse.iStatus) + ")";
+			return false;
+		}
+
+		// Take over names
+		for (size_t i = 0; i < sList.vecItems.size(); i++)
+			vecNames.push_back(sList.vecItems[i].strValue);
+	}
+
+	// Resolve names (unresolvable ones are skipped)
+	pvecServers->clear();
+	for (size_t i = 0; i < vecNames.size(); i++)
+	{
+		// Variables
+		SDnsServer sServer;
+
+
+		// Resolve name
+		if (CDnsClient::parseServer(vecNames[i], &sServer))
+			pvecServers->push_back(sServer);
+	}
+
+	// Check if none is left
+	if (pvecServers->empty())
+	{
+		*pstrErrorMsg = "No usable nameserver";
+		return false;
+	}
+
+	// Success
+	return true;
+
+} // lookupNameServers
+
+//
+// confirmRecords
+//
+// Task: Check if the authoritative nameservers serve the published values (all servers that answered must agree)
+//
+bool confirmRecords(std::vector<SDnsCheck>* pvecChecks, const SConfigContents& sConfigContents, CHttpClient* pcHttpClient, CDnsClient* pcDnsClient, std::map<std::string, std::vector<SDnsServer>>* pmapNameServers)
+{
+	// Variables
+	std::vector<SDnsQuery> vecQueries;
+	std::vector<std::pair<size_t, size_t>> vecRanges;
+	std::map<std::string, std::vector<SDnsServer>> mapFailed;
+
+
+	// Run through checks
+	for (size_t i = 0; i < pvecChecks->size(); i++)
+	{
+		// Variables
+		SDnsCheck* psCheck = &(*pvecChecks)[i];
+		std::map<std::string, std::vector<SDnsServer>>::iterator iServers = pmapNameServers->find(psCheck->psDomRecords->strDomain);
+		std::string strSubDomain = psCheck->strRRSet.substr(0, psCheck->strRRSet.find('\t')), strErrorMsg;
+
+
+		// Look up nameservers of the domain once (failed lookups are tried again with the next checks)
+		if ((iServers == pmapNameServers->end()) && ((iServers = mapFailed.find(psCheck->psDomRecords->strDomain)) == mapFailed.end()))
+		{
+			// Variables
+			std::vector<SDnsServer> vecServers;
+
+
+			// Try to look up
+			if (!lookupNameServers(psCheck->psDomRecords, sConfigContents, pcHttpClient, &vecServers, &strErrorMsg))
+			{
+				// Print to terminal and to logfile if enabled
+				std::cerr << COLOR_YELLOW << timeStamp() << "[WARNING]: Cannot get nameservers of '" << psCheck->psDomRecords->strDomain << "': " << strErrorMsg << "." << COLOR_DEFAULT << std::endl;
+				g_cLogger.log(LOG_LEVEL_WARNING, "Cannot get nameservers of '%s': %s.", psCheck->psDomRecords->strDomain.c_str(), strErrorMsg.c_str());
+				iServers = mapFailed.emplace(psCheck->psDomRecords->strDomain, vecServers).first;
+			}
+			else
+				iServers = pmapNameServers->emplace(psCheck->psDomRecords->strDomain, vecServers).first;
+		}
+
+		// Add a query per nameserver
+		vecRanges.push_back(std::make_pair(vecQueries.size(), iServers->second.size()));
+		for (size_t j = 0; j < iServers->second.size(); j++)
+		{
+			// Variables
+			SDnsQuery sQuery;
+
+
+			// Add query
+			sQuery.strName = (strSubDomain == "@") ? psCheck->psDomRecords->strDomain : (strSubDomain + "." + psCheck->psDomRecords->strDomain);
+			sQuery.iType = (psCheck->strRRSet.compare((psCheck->strRRSet.find('\t') + 1), std::string::npos, "A") == 0) ? DNS_TYPE_A : DNS_TYPE_AAAA;
+			sQuery.psServer = &iServers->second[j];
+			sQuery.bAnswered = false;
+			vecQueries.push_back(sQuery);
+		}
+	}
+
+	// Send all queries at once
+	if (!pcDnsClient->resolve(&vecQueries, sConfigContents.iDNSTimeoutMs))
+		return false;
+
+	// Evaluate answers of every check
+	for (size_t i = 0; i < pvecChecks->size(); i++)
+	{
+		// Variables
+		SDnsCheck* psCheck = &(*pvecChecks)[i];
+		size_t iAnswered = 0;
+
+
+		// Run through queries of the check (every answer must contain only the published value)
+		psCheck->bConfirmed = true;
+		for (size_t j = vecRanges[i].first; j < (vecRanges[i].first + vecRanges[i].second); j++)
+		{
+			if (!vecQueries[j].bAnswered)
+				continue;
+			iAnswered++;
+			psCheck->bConfirmed &= ((vecQueries[j].vecAnswers.size() == 1) && (vecQueries[j].vecAnswers[0] == psCheck->strValue));
+		}
+		psCheck->bAnswered = (iAnswered != 0);
+		psCheck->bConfirmed &= psCheck->bAnswered;
+	}
+
+	// Success
+	return true;
+
+} // confirmRecords
+
+//
+// CDnsClient::resolve
+//
+// Task: Send all queries over UDP with a limited amount in flight and collect their answers (unanswered queries are sent again after the timeout)
+//
+bool CDnsClient::resolve(std::vector<SDnsQuery>* pvecQueries, uint32_t iTimeoutMs)
+{
+	// Variables
+	std::unordered_map<uint16_t, size_t> mapInFlight;
+	std::vector<std::chrono::steady_clock::time_point> vecDeadlines(pvecQueries->size());
+	std::vector<uint8_t> vecTries(pvecQueries->size(), 0);
+	std::deque<size_t> deqWaiting;
+	unsigned char cPacket[DNS_MAX_PACKET];
+	size_t iDone = 0;
+
+
+	// Queue all queries
+	for (size_t i = 0; i < pvecQueries->size(); i++)
+		deqWaiting.push_back(i);
+
+	// Run until every query is answered or has used up its tries
+	while ((iDone < pvecQueries->size()) && (!g_sigInterrupt))
+	{
+		// Variables
+		std::chrono::steady_clock::time_point tNow = std::chrono::steady_clock::now(), tWakeUp = tNow + std::chrono::milliseconds(iTimeoutMs);
+		struct pollfd sPoll[2];
+		nfds_t iPolls = 0;
+
+
+		// Send waiting queries while the window has room
+		while ((!deqWaiting.empty()) && (mapInFlight.size() < DNS_MAX_IN_FLIGHT))
+		{
+			// Variables
+			size_t i = deqWaiting.front();
+			SDnsQuery* psQuery = &(*pvecQueries)[i];
+			uint8_t iFamily = (psQuery->psServer->sAddr.ss_family == AF_INET6);
+			std::string strPacket;
+			uint16_t iID;
+
+
+			// Open socket of the family if required
+			deqWaiting.pop_front();
+			if ((m_iSocket[iFamily] == -1) && ((m_iSocket[iFamily] = socket(psQuery->psServer->sAddr.ss_family, (SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC), 0)) == -1))
+			{
+				iDone++;
+				continue;
+			}
+
+			// Pick an unused random ID and send query
+			while (mapInFlight.count(iID = (m_cRandom() & 0xFFFF)) != 0);
+			strPacket = encodeQuery(iID, psQuery->strName, psQuery->iType);
+			vecTries[i]++;
+			if (sendto(m_iSocket[iFamily], strPacket.data(), strPacket.length(), 0, (const struct sockaddr*)&psQuery->psServer->sAddr, psQuery->psServer->iAddrLen) != (ssize_t)strPacket.length())
+			{
+				if (vecTries[i] < DNS_TRIES)
+					deqWaiting.push_back(i);
+				else
+					iDone++;
+				continue;
+			}
+			mapInFlight[iID] = i;
+			vecDeadlines[i] = tNow + std::chrono::milliseconds(iTimeoutMs);
+		}
+
+		// Wait for answers until the next query times out
+		for (std::unordered_map<uint16_t, size_t>::iterator iQuery = mapInFlight.begin(); iQuery != mapInFlight.end(); iQuery++)
+			tWakeUp = std::min(tWakeUp, vecDeadlines[iQuery->second]);
+		for (int iSocket : m_iSocket)
+			if (iSocket != -1)
+				sPoll[iPolls++] = { iSocket, POLLIN, 0 };
+		if ((!mapInFlight.empty()) && (poll(sPoll, iPolls, std::max<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(tWakeUp - tNow).count(), 1)) < 0) && (errno != EINTR))
+			return false;
+
+		// Read all received answers
+		for (nfds_t iPoll = 0; iPoll < iPolls; iPoll++)
+		{
+			// Variables
+			struct sockaddr_storage sFrom;
+			socklen_t iFromLen = sizeof(sFrom);
+			ssize_t iLength;
+
+
+			// Run through datagrams
+			while ((iLength = recvfrom(sPoll[iPoll].fd, cPacket, sizeof(cPacket), 0, (struct sockaddr*)&sFrom, &iFromLen)) >= 0)
+			{
+				// Variables
+				std::unordered_map<uint16_t, size_t>::iterator iQuery;
+				std::vector<std::string> vecAnswers;
+				std::string strName;
+				uint16_t iID, iType;
+				SDnsQuery* psQuery;
+
+
+				// Skip invalid answers and answers that do not belong to a query in flight (sender, name and type must match)
+				iFromLen = sizeof(sFrom);
+				if ((!decodeResponse(cPacket, iLength, &iID, &strName, &iType, &vecAnswers)) || ((iQuery = mapInFlight.find(iID)) == mapInFlight.end()))
+					continue;
+				psQuery = &(*pvecQueries)[iQuery->second];
+				if ((iType != psQuery->iType) || (strcasecmp(strName.c_str(), psQuery->strName.c_str()) != 0) || (sFrom.ss_family != psQuery->psServer->sAddr.ss_family) ||
+					((sFrom.ss_family == AF_INET) && (memcmp(&((struct sockaddr_in*)&sFrom)->sin_addr, &((const struct sockaddr_in*)&psQuery->psServer->sAddr)->sin_addr, sizeof(struct in_addr)) != 0)) ||
+					((sFrom.ss_family == AF_INET6) && (memcmp(&((struct sockaddr_in6*)&sFrom)->sin6_addr, &((const struct sockaddr_in6*)&psQuery->psServer->sAddr)->sin6_addr, sizeof(struct in6_addr)) != 0)))
+					continue;
+
+				// Take over answers
+				psQuery->vecAnswers = vecAnswers;
+				psQuery->bAnswered = true;
+				mapInFlight.erase(iQuery);
+				iDone++;
+			}
+		}
+
+		// Send timed out queries again or give up
+		tNow = std::chrono::steady_clock::now();
+		for (std::unordered_map<uint16_t, size_t>::iterator iQuery = mapInFlight.begin(); iQuery != mapInFlight.end();)
+		{
+			// Skip queries that have time left
+			if (vecDeadlines[iQuery->second] > tNow)
+			{
+				iQuery++;
+				continue;
+			}
+
+			// Queue again if tries are left
+			if (vecTries[iQuery->second] < DNS_TRIES)
+				deqWaiting.push_back(iQuery->second);
+			else
+				iDone++;
+			iQuery = mapInFlight.erase(iQuery);
+		}
+	}
+
+	// Success if not canceled
+	return (!g_sigInterrupt);
+
+} // CDnsClient::resolve
+
+//
+// CDnsClient::parseServer
+//
+// Task: Resolve a nameserver given as host[:port] ("[address]:port" for IPv6)
+//
+bool CDnsClient::parseServer(const std::string& strServer, SDnsServer* psServer)
+{
+	// Variables
+	std::string strHost = strServer, strPort = DNS_DEF_PORT;
+	struct addrinfo sHints, *psResult;
+	size_t iPos;
+
+
+	// Split host and port
+	if ((strHost.length() > 0) && (strHost[0] == '[') && ((iPos = strHost.find(']')) != std::string::npos))
+	{
+		if ((strHost.length() > (iPos + 2)) && (strHost[iPos + 1] == ':'))
+			strPort = strHost.substr(iPos + 2);
+		strHost = strHost.substr(1, (iPos - 1));
+	}
+	else if (((iPos = strHost.find(':')) != std::string::npos) && (strHost.find(':', (iPos + 1)) == std::string::npos))
+	{
+		strPort = strHost.substr(iPos + 1);
+		strHost.erase(iPos);
+	}
+
+	// Resolve host (the first address is used)
+	memset(&sHints, 0, sizeof(sHints));
+	sHints.ai_family = AF_UNSPEC;
+	sHints.ai_socktype = SOCK_DGRAM;
+	if ((strHost.empty()) || (getaddrinfo(strHost.c_str(), strPort.c_str(), &sHints, &psResult) != 0))
+		return false;
+	memcpy(&psServer->sAddr, psResult->ai_addr, psResult->ai_addrlen);
+	psServer->iAddrLen = psResult->ai_addrlen;
+	freeaddrinfo(psResult);
+	return true;
+
+} // CDnsClient::parseServer
+
+//
+// CDnsClient::encodeQuery
+//
+// Task: Build a query packet for a name and type (without recursion, only authoritative data is wanted)
+//
+std::string CDnsClient::encodeQuery(uint16_t iID, const std::string& strName, uint16_t iType)
+{
+	// Variables
+	std::string strPacket;
+	size_t iStart = 0, iEnd;
+
+
+	// Header (ID, no flags, one question)
+	strPacket.reserve(strName.length() + 18);
+	strPacket += (char)(iID >> 8);
+	strPacket += (char)(iID & 0xFF);
+	strPacket.append("\0\0\0\1\0\0\0\0\0\0", 10);
+
+	// Question name (a label per part)
+	while (iStart < strName.length())
+	{
+		if ((iEnd = strName.find('.', iStart)) == std::string::npos)
+			iEnd = strName.length();
+		strPacket += (char)std::min<size_t>((iEnd - iStart), 63);
+		strPacket.append(strName, iStart, std::min<size_t>((iEnd - iStart), 63));
+		iStart = iEnd + 1;
+	}
+	strPacket += '\0';
+
+	// Question type and class
+	strPacket += (char)(iType >> 8);
+	strPacket += (char)(iType & 0xFF);
+	strPacket += (char)(DNS_CLASS_IN >> 8);
+	strPacket += (char)(DNS_CLASS_IN & 0xFF);
+	return strPacket;
+
+} // CDnsClient::encodeQuery
+
+//
+// CDnsClient::decodeResponse
+//
+// Task: Get ID, question and the A/AAAA values of the answer section of a response
+//
+bool CDnsClient::decodeResponse(const unsigned char* cPacket, size_t iLength, uint16_t* piID, std::string* pstrName, uint16_t* piType, std::vector<std::string>* pvecAnswers)
+{
+	// Variables
+	size_t iPos = 12;
+	uint16_t iQuestions, iAnswers;
+	char cAddress[INET6_ADDRSTRLEN];
+
+
+	// Check header (must be a response with exactly one question)
+	if ((iLength < 12) || ((cPacket[2] & 0x80) == 0))
+		return false;
+	*piID = (cPacket[0] << 8) | cPacket[1];
+	iQuestions = (cPacket[4] << 8) | cPacket[5];
+	iAnswers = (cPacket[6] << 8) | cPacket[7];
+	if ((iQuestions != 1) || (!readName(cPacket, iLength, &iPos, pstrName)) || ((iPos + 4) > iLength))
+		return false;
+	*piType = (cPacket[iPos] << 8) | cPacket[iPos + 1];
+	iPos += 4;
+
+	// A failed lookup (e.g. NXDOMAIN) is an answer without values
+	if ((cPacket[3] & 0x0F) != 0)
+		return true;
+
+	// Run through answers
+	for (uint16_t i = 0; i < iAnswers; i++)
+	{
+		// Variables
+		std::string strOwner;
+		uint16_t iType, iClass, iDataLen;
+
+
+		// Read owner, type, class, TTL and length of data
+		if ((!readName(cPacket, iLength, &iPos, &strOwner)) || ((iPos + 10) > iLength))
+			return false;
+		iType = (cPacket[iPos] << 8) | cPacket[iPos + 1];
+		iClass = (cPacket[iPos + 2] << 8) | cPacket[iPos + 3];
+		iDataLen = (cPacket[iPos + 8] << 8) | cPacket[iPos + 9];
+		iPos += 10;
+		if ((iPos + iDataLen) > iLength)
+			return false;
+
+		// Take over addresses of the asked type (e.g. not the CNAME that leads to them)
+		if ((iClass == DNS_CLASS_IN) && (iType == *piType) && (((iType == DNS_TYPE_A) && (iDataLen == 4)) || ((iType == DNS_TYPE_AAAA) && (iDataLen == 16))))
+			if (inet_ntop(((iType == DNS_TYPE_A) ? AF_INET : AF_INET6), (cPacket + iPos), cAddress, sizeof(cAddress)) != NULL)
+				pvecAnswers->push_back(cAddress);
+		iPos += iDataLen;
+	}
+
+	// Success
+	return true;
+
+} // CDnsClient::decodeResponse
+
+//
+// CDnsClient::readName
+//
+// Task: Read a (compressed) name and move behind it
+//
+bool CDnsClient::readName(const unsigned char* cPacket, size_t iLength, size_t* piPos, std::string* pstrName)
+{
+	// Variables
+	size_t iPos = *piPos;
+	uint8_t iPointers = 0;
+
+
+	// Run through labels
+	pstrName->clear();
+	while (iPos < iLength)
+	{
+		// End of name
+		if (cPacket[iPos] == 0)
+		{
+			if (iPointers == 0)
+				*piPos = iPos + 1;
+			return true;
+		}
+
+		// Pointer to a previous name (the position moves only behind the first one)
+		if ((cPacket[iPos] & 0xC0) == 0xC0)
+		{
+			if (((iPos + 1) >= iLength) || (++iPointers > DNS_MAX_POINTERS))
+				return false;
+			if (iPointers == 1)
+				*piPos = iPos + 2;
+			iPos = ((cPacket[iPos] & 0x3F) << 8) | cPacket[iPos + 1];
+			continue;
+		}
+
+		// Label
+		if ((iPos + 1 + cPacket[iPos]) > iLength)
+			return false;
+		pstrName->append((pstrName->empty() ? "" : "."));
+		pstrName->append((const char*)(cPacket + iPos + 1), cPacket[iPos]);
+		iPos += 1 + cPacket[iPos];
+	}
+
+	// Truncated
+	return false;
+
+} // CDnsClient::readName
+
+//
+// scanJsonString
+//
+// Task: Find a string member of the top-level object of a JSON document in place (raw value without quotes, nothing is parsed or copied)
+//
+bool scanJsonString(const std::string& strText, const char* cKey, size_t* piStart, size_t* piLength)
+{
+	// Variables
+	size_t iKeyLength = strlen(cKey);
+	size_t iDepth = 0, iStart, iEnd, iPos;
+
+
+	// Run through document
+	for (size_t i = 0; i < strText.length(); i++)
+	{
+		// Track nesting
+		if ((strText[i] == '{') || (strText[i] == '['))
+			iDepth++;
+		else if ((strText[i] == '}') || (strText[i] == ']'))
+		{
+			if (iDepth == 0)
+				return false;
+			iDepth--;
+		}
+		else if (strText[i] == '"')
+		{
+			// Find end of string (escaped characters are skipped)
+			for (iStart = iEnd = (i + 1); ((iEnd < strText.length()) && (strText[iEnd] != '"')); iEnd += ((strText[iEnd] == '\\') ? 2 : 1));
+			if (iEnd >= strText.length())
+				return false;
+			i = iEnd;
+
+			// Skip strings that are not the wanted key of the top-level object
+			if ((iDepth != 1) || ((iEnd - iStart) != iKeyLength) || (strText.compare(iStart, iKeyLength, cKey) != 0))
+				continue;
+			for (iPos = (iEnd + 1); ((iPos < strText.length()) && (isspace(strText[iPos]))); iPos++);
+			if ((iPos >= strText.length()) || (strText[iPos] != ':'))
+				continue;
+
+			// Get value (must be a string)
+			for (iPos++; ((iPos < strText.length()) && (isspace(strText[iPos]))); iPos++);
+			if ((iPos >= strText.length()) || (strText[iPos] != '"'))
+				return false;
+			for (iStart = iEnd = (iPos + 1); ((iEnd < strText.length()) && (strText[iEnd] != '"')); iEnd += ((strText[iEnd] == '\\') ? 2 : 1));
+			if (iEnd >= strText.length())
+				return false;
+			*piStart = iStart;
+			*piLength = iEnd - iStart;
+			return true;
+		}
+	}
+
+	// Member not found
+	return false;
+
+} // scanJsonString
+
+//
+// containsNoCase
+//
+// Task: Check if a text contains a word (case insensitive, the text is not copied)
+//
+bool containsNoCase(const char* cText, size_t iLength, const std::string& strWord)
+{
+	// Run through all positions the word fits into
+	for (size_t i = 0; (i + strWord.length()) <= iLength; i++)
+		if (strncasecmp((cText + i), strWord.c_str(), strWord.length()) == 0)
+			return true;
+
+	// Not found
+	return false;
+
+} // containsNoCase
+
+
+//
+// parseJson
+//
+// Task: Parse a JSON document
+//
+bool parseJson(const std::string& strText, SJsonValue* psValue)
+{
+	// Variables
+	size_t iPos = 0;
+
+
+	// Parse value and make sure only whitespace follows
+	if (!parseJsonValue(strText, &iPos, psValue, 0))
+		return false;
+	while ((iPos < strText.length()) && (isspace(strText[iPos])))
+		iPos++;
+
+	// Return result
+	return (iPos == strText.length());
+
+} // parseJson
+
+//
+// parseJsonValue
+//
+// Task: Parse a single JSON value starting at the given position
+//
+bool parseJsonValue(const std::string& strText, size_t* piPos, SJsonValue* psValue, uint8_t iDepth)
+{
+	// Variables
+	size_t iPos = *piPos;
+
+
+	// Check nesting depth and skip whitespace
+	if (iDepth > JSON_MAX_DEPTH)
+		return false;
+	while ((iPos < strText.length()) && (isspace(strText[iPos])))
+		iPos++;
+	if (iPos >= strText.length())
+		return false;
+
+	// Reset value
+	*psValue = SJsonValue();
+
+	// String
+	if (strText[iPos] == '"')
+	{
+		psValue->eType = SJsonValue::JSON_STRING;
+		for (iPos++; ((iPos < strText.length()) && (strText[iPos] != '"')); iPos++)
+		{
+			// Unescape character
+			if ((strText[iPos] == '\\') && ((iPos + 1) < strText.length()))
+			{
+				switch (strText[++iPos])
+				{
+					case 'n': psValue->strValue += '\n'; break;
+					case 't': psValue->strValue += '\t'; break;
+					case 'r': psValue->strValue += '\r'; break;
+					case 'b': psValue->strValue += '\b'; break;
+					case 'f': psValue->strValue += '\f'; break;
+					case 'u': if (!decodeJsonUnicode(strText, &iPos, &psValue->strValue)) return false; break;
+					default: psValue->strValue += strText[iPos]; break;
+				}
+			}
+			else
+				psValue->strValue += strText[iPos];
+		}
+
+		// Check if string is terminated
+		if (iPos >= strText.length())
+			return false;
+		iPos++;
+	}
+	// Array or object
+	else if ((strText[iPos] == '[') || (strText[iPos] == '{'))
+	{
+		// Variables
+		bool bObject = (strText[iPos] == '{');
+		char cClose = bObject ? '}' : ']';
+		SJsonValue sKey, sItem;
+
+
+		// Run through elements
+		psValue->eType = bObject ? SJsonValue::JSON_OBJECT : SJsonValue::JSON_ARRAY;
+		for (iPos++; ; )
+		{
+			// Skip whitespace and check for end
+			while ((iPos < strText.length()) && (isspace(strText[iPos])))
+				iPos++;
+			if (iPos >= strText.length())
+				return false;
+			if ((strText[iPos] == cClose) && (psValue->vecItems.empty()))
+			{
+				iPos++;
+				break;
+			}
+
+			// Parse key
+			if (bObject)
+			{
+				if ((!parseJsonValue(strText, &iPos, &sKey, (iDepth + 1))) || (sKey.eType != SJsonValue::JSON_STRING))
+					return false;
+				while ((iPos < strText.length()) && (isspace(strText[iPos])))
+					iPos++;
+				if ((iPos >= strText.length()) || (strText[iPos++] != ':'))
+					return false;
+				psValue->vecKeys.push_back(sKey.strValue);
+			}
+
+			// Parse item
+			if (!parseJsonValue(strText, &iPos, &sItem, (iDepth + 1)))
+				return false;
+			psValue->vecItems.push_back(sItem);
+
+			// Check for separator or end
+			while ((iPos < strText.length()) && (isspace(strText[iPos])))
+				iPos++;
+			if (iPos >= strText.length())
+				return false;
+			if (strText[iPos++] == cClose)
+				break;
+			if (strText[iPos - 1] != ',')
+				return false;
+		}
+	}
+	// Number, boolean or null
+	else
+	{
+		// Read token
+		size_t iStart = iPos;
+		while ((iPos < strText.length()) && ((isalnum(strText[iPos])) || (strText[iPos] == '-') || (strText[iPos] == '+') || (strText[iPos] == '.')))
+			iPos++;
+		psValue->strValue = strText.substr(iStart, (iPos - iStart));
+
+		// Assign type
+		if ((psValue->strValue == "true") || (psValue->strValue == "false"))
+			psValue->eType = SJsonValue::JSON_BOOL;
+		else if (psValue->strValue == "null")
+			psValue->eType = SJsonValue::JSON_NULL;
+		else if ((psValue->strValue.length() > 0) && ((isdigit(psValue->strValue[0])) || (psValue->strValue[0] == '-')))
+			psValue->eType = SJsonValue::JSON_NUMBER;
+		else
+			return false;
+	}
+
+	// Success
+	*piPos = iPos;
+	return true;
+
+} // parseJsonValue
+
+//
+// decodeJsonUnicode
+//
+// Task: Decode an unicode escape sequence (position at the 'u') and append it as UTF-8
+//
+bool decodeJsonUnicode(const std::string& strText, size_t* piPos, std::string* pstrResult)
+{
+	// Variables
+	uint32_t iCodePoint, iLow;
+
+
+	// Read code unit
+	if (((*piPos + 4) >= strText.length()) || (sscanf(strText.substr((*piPos + 1), 4).c_str(), "%4x", &iCodePoint) != 1))
+		return false;
+	*piPos += 4;
+
+	// Combine surrogate pair if required
+	if ((iCodePoint >= 0xD800) && (iCodePoint <= 0xDBFF) && ((*piPos + 6) < strText.length()) && (strText[*piPos + 1] == '\\') && (strText[*piPos + 2] == 'u') && (sscanf(strText.substr((*piPos + 3), 4).c_str(), "%4x", &iLow) == 1) && (iLow >= 0xDC00) && (iLow <= 0xDFFF))
+	{
+		iCodePoint = 0x10000 + ((iCodePoint - 0xD800) << 10) + (iLow - 0xDC00);
+		*piPos += 6;
+	}
+
+	// Encode as UTF-8
+	if (iCodePoint < 0x80)
+		*pstrResult += (char)iCodePoint;
+	else if (iCodePoint < 0x800)
+	{
+		*pstrResult += (char)(0xC0 | (iCodePoint >> 6));
+		*pstrResult += (char)(0x80 | (iCodePoint & 0x3F));
+	}
+	else if (iCodePoint < 0x10000)
+	{
+		*pstrResult += (char)(0xE0 | (iCodePoint >> 12));
+		*pstrResult += (char)(0x80 | ((iCodePoint >> 6) & 0x3F));
+		*pstrResult += (char)(0x80 | (iCodePoint & 0x3F));
+	}
+	else
+	{
+		*pstrResult += (char)(0xF0 | (iCodePoint >> 18));
+		*pstrResult += (char)(0x80 | ((iCodePoint >> 12) & 0x3F));
+		*pstrResult += (char)(0x80 | ((iCodePoint >> 6) & 0x3F));
+		*pstrResult += (char)(0x80 | (iCodePoint & 0x3F));
+	}
+
+	// Success
+	return true;
+
+} // decodeJsonUnicode
+
+//
+// jsonEscape
+//
+// Task: Escape a string for use in a JSON document
+//
+std::string jsonEscape(const std::string& strText)
+{
+	// Variables
+	std::string strResult;
+	char cEscape[8];
+
+
+	// Run through characters and escape them if required
+	strResult.reserve(strText.length());
+	for (size_t i = 0; i < strText.length(); i++)
+	{
+		if ((strText[i] == '"') || (strText[i] == '\\'))
+		{
+			strResult += '\\';
+			strResult += strText[i];
+		}
+		else if ((unsigned char)strText[i] < 0x20)
+		{
+			snprintf(cEscape, sizeof(cEscape), "\\u%.4x", strText[i]);
+			strResult += cEscape;
+		}
+		else
+			strResult += strText[i];
+	}
+
+	// Return result
+	return strResult;
+
+} // jsonEscape
+
+//
+// parsePushRequest
+//
+// Task: Parse the query of a dyndns style update request ("\tbasic" holds the Basic auth password)
+//
+bool parsePushRequest(const std::string& strRequest, std::map<std::string, std::string>* pmapQuery)
+{
+	// Variables
+	std::string strTarget, strHead = strRequest.substr(0, strRequest.find("\r\n\r\n"));
+	size_t iPos;
+
+
+	// Check method and path (/nic/update like dyndns or /update)
+	if (strRequest.compare(0, 4, "GET ") != 0)
+		return false;
+	strTarget = strRequest.substr(4, (strRequest.find(' ', 4) - 4));
+	if ((strTarget.compare(0, strTarget.find('?'), "/nic/update") != 0) && (strTarget.compare(0, strTarget.find('?'), "/update") != 0))
+		return false;
+
+	// Split query into decoded parameters
+	if ((iPos = strTarget.find('?')) != std::string::npos)
+		for (const std::string& strParam : splitList(strTarget.substr(iPos + 1), '&'))
+			(*pmapQuery)[urlDecode(strParam.substr(0, strParam.find('=')))] = (strParam.find('=') != std::string::npos) ? urlDecode(strParam.substr(strParam.find('=') + 1)) : "";
+
+	// Get password of Basic auth (the user name is ignored)
+	std::transform(strHead.begin(), strHead.end(), strHead.begin(), ::tolower);
+	if ((iPos = strHead.find("\nauthorization: basic ")) != std::string::npos)
+	{
+		std::string strCredentials = base64Decode(strRequest.substr((iPos + 22), (strHead.find_first_of("\r\n", (iPos + 22)) - (iPos + 22))));
+		if (strCredentials.find(':') != std::string::npos)
+			(*pmapQuery)["\tbasic"] = strCredentials.substr(strCredentials.find(':') + 1);
+	}
+
+	// Success
+	return true;
+
+} // parsePushRequest
+
+//
+// urlDecode
+//
+// Task: Decode a percent encoded URL component
+//
+std::string urlDecode(const std::string& strText)
+{
+	// Variables
+	std::string strResult;
+
+
+	// Run through characters
+	for (size_t i = 0; i < strText.length(); i++)
+	{
+		if ((strText[i] == '%') && ((i + 2) < strText.length()) && (isxdigit(strText[i + 1])) && (isxdigit(strText[i + 2])))
+		{
+			strResult += (char)strtol(strText.substr((i + 1), 2).c_str(), NULL, 16);
+			i += 2;
+		}
+		else
+			strResult += (strText[i] == '+') ? ' ' : strText[i];
+	}
+
+	// Return result
+	return strResult;
+
+} // urlDecode
+
+//
+// base64Decode
+//
+// Task: Decode a base64 string (invalid characters are skipped)
+//
+std::string base64Decode(const std::string& strText)
+{
+	// Variables
+	static const std::string c_strAlphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::string strResult;
+	uint32_t iBits = 0;
+	int iCount = 0;
+
+
+	// Run through characters and collect 6 bits each
+	for (size_t i = 0; i < strText.length(); i++)
+	{
+		size_t iValue = c_strAlphabet.find(strText[i]);
+		if (iValue == std::string::npos)
+			continue;
+		iBits = (iBits << 6) | iValue;
+		if ((iCount += 6) >= 8)
+		{
+			iCount -= 8;
+			strResult += (char)((iBits >> iCount) & 0xFF);
+		}
+	}
+
+	// Return result
+	return strResult;
+
+} // base64Decode
+
+//
+// tokenMatches
+//
+// Task: Compare a token in constant time (empty tokens never match)
+//
+bool tokenMatches(const std::string& strGiven, const std::string& strToken)
+{
+	// Variables
+	unsigned char cDiff = (strGiven.length() != strToken.length());
+
+
+	// Compare all characters
+	if (strGiven.empty() || strToken.empty())
+		return false;
+	for (size_t i = 0; i < strGiven.length(); i++)
+		cDiff |= strGiven[i] ^ strToken[i % strToken.length()];
+
+	// Return result
+	return (cDiff == 0);
+
+} // tokenMatches
+
+
+//
+// CHttpClient::~CHttpClient
+//
+// Task: Release all pooled handles and their connections
+//
+CHttpClient::~CHttpClient()
+{
+	// Run through all pools and clean up handles
+	for (std::map<std::string, std::vector<CURL*>>::iterator iPool = m_mapPool.begin(); iPool != m_mapPool.end(); iPool++)
+		for (size_t i = 0; i < iPool->second.size(); i++)
+			curl_easy_cleanup(iPool->second[i]);
+
+	// Clean up shared caches
+	if (m_pShare != NULL)
+		curl_share_cleanup(m_pShare);
+
+} // CHttpClient::~CHttpClient
+
+//
+// CHttpClient::request
+//
+// Task: Perform a HTTP(S) request on a pooled keep-alive connection
+//
+bool CHttpClient::request(const char* cMethod, const std::string& strURL, const std::list<std::string>& lstHeaders, const std::string& strBody, uint16_t iTimeoutS, SHttpResponse* psResponse, long iIPResolve)
+{
+	// Variables
+	SHttpRequest sRequest;
+
+
+	// Build request and perform it
+	sRequest.strMethod = cMethod;
+	sRequest.strURL = strURL;
+	sRequest.lstHeaders = lstHeaders;
+	sRequest.strBody = strBody;
+	sRequest.iTimeoutS = iTimeoutS;
+	sRequest.iIPResolve = iIPResolve;
+	return request(sRequest, psResponse);
+
+} // CHttpClient::request
+
+//
+// CHttpClient::request
+//
+// Task: Perform a HTTP(S) request on a pooled keep-alive connection
+//
+bool CHttpClient::request(const SHttpRequest& sRequest, SHttpResponse* psResponse)
+{
+	// Variables
+	std::string strPoolKey;
+	CURL* pCurl;
+	struct curl_slist* pHeaders;
+	CURLcode iRes;
+
+
+	// Check for failure
+	poolKey(sRequest.strURL, sRequest.iIPResolve, &strPoolKey);
+	psResponse->reset();
+	if ((pCurl = acquireHandle(strPoolKey)) == NULL)
+	{
+		psResponse->strError = "Cannot create HTTP handle";
+		return false;
+	}
+
+	// Set request options and perform request
+	pHeaders = prepareHandle(pCurl, sRequest, psResponse);
+	iRes = curl_easy_perform(pCurl);
+	curl_easy_getinfo(pCurl, CURLINFO_NUM_CONNECTS, &psResponse->iConnects);
+	if (iRes == CURLE_OK)
+	{
+		curl_easy_getinfo(pCurl, CURLINFO_RESPONSE_CODE, &psResponse->iStatus);
+		curl_easy_getinfo(pCurl, CURLINFO_HTTP_VERSION, &psResponse->iHttpVersion);
+		curl_easy_getinfo(pCurl, CURLINFO_TOTAL_TIME, &psResponse->dTimeMs);
+		psResponse->dTimeMs *= 1000;
+	}
+	else
+		psResponse->strError = curl_easy_strerror(iRes);
+
+	// Detach header list, free it and give handle back to the pool
+	curl_easy_setopt(pCurl, CURLOPT_HTTPHEADER, NULL);
+	curl_slist_free_all(pHeaders);
+	releaseHandle(strPoolKey, pCurl);
+
+	// Return result
+	return (iRes == CURLE_OK);
+
+} // CHttpClient::request
+
+//
+// CHttpClient::race
+//
+// Task: Perform requests concurrently (delayed ones start later), requests that are not required anymore are canceled
+//
+void CHttpClient::race(const std::vector<SHttpRequest>& vecRequests, std::vector<SHttpResponse>* pvecResponses, std::function<void(size_t)> fnDone, std::function<bool(size_t)> fnRequired)
+{
+	// Variables
+	CURLM* pMulti = curl_multi_init();
+	std::vector<CURL*> vecHandles(vecRequests.size(), NULL);
+	std::vector<struct curl_slist*> vecHeaders(vecRequests.size(), NULL);
+	std::vector<std::string> vecPoolKeys(vecRequests.size());
+	std::vector<bool> vecStarted(vecRequests.size(), false), vecFinished(vecRequests.size(), false);
+	std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+	size_t iRemaining = vecRequests.size();
+	int iRunning;
+	CURLMsg* psMsg;
+
+
+	// Prepare responses
+	pvecResponses->assign(vecRequests.size(), SHttpResponse());
+
+	// Race loop
+	while ((iRemaining > 0) && (!g_sigInterrupt) && (pMulti != NULL))
+	{
+		// Variables
+		uint32_t iElapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - tStart).count();
+		uint32_t iWaitMs = HTTP_POLL_TIMEOUT_MS;
+
+
+		// Cancel requests that are not required anymore
+		for (size_t i = 0; i < vecRequests.size(); i++)
+		{
+			// Skip finished and required requests
+			if ((vecFinished[i]) || (fnRequired(i)))
+				continue;
+
+			// Mark as canceled
+			(*pvecResponses)[i].bCanceled = true;
+			(*pvecResponses)[i].strError = "Canceled";
+			vecFinished[i] = true;
+			iRemaining--;
+
+			// Remove running handle (its connection is dropped)
+			if (vecHandles[i] != NULL)
+			{
+				(*pvecResponses)[i].dTimeMs = (double)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - tStart).count() - vecRequests[i].iDelayMs;
+				curl_multi_remove_handle(pMulti, vecHandles[i]);
+				curl_easy_cleanup(vecHandles[i]);
+				curl_slist_free_all(vecHeaders[i]);
+				vecHandles[i] = NULL;
+			}
+		}
+
+		// Start due requests
+		for (size_t i = 0; i < vecRequests.size(); i++)
+		{
+			// Skip started and not yet due requests
+			if ((vecStarted[i]) || (vecFinished[i]))
+				continue;
+			if (vecRequests[i].iDelayMs > iElapsedMs)
+			{
+				iWaitMs = std::min(iWaitMs, (vecRequests[i].iDelayMs - iElapsedMs));
+				continue;
+			}
+
+			// Try to get handle
+			vecStarted[i] = true;
+			poolKey(vecRequests[i].strURL, vecRequests[i].iIPResolve, &vecPoolKeys[i]);
+			if ((vecHandles[i] = acquireHandle(vecPoolKeys[i])) == NULL)
+			{
+				(*pvecResponses)[i].strError = "Cannot create HTTP handle";
+				vecFinished[i] = true;
+				iRemaining--;
+				fnDone(i);
+				continue;
+			}
+
+			// Prepare handle and add it
+			vecHeaders[i] = prepareHandle(vecHandles[i], vecRequests[i], &(*pvecResponses)[i]);
+			curl_easy_setopt(vecHandles[i], CURLOPT_PRIVATE, (void*)i);
+			curl_multi_add_handle(pMulti, vecHandles[i]);
+		}
+
+		// Perform transfers and process finished ones
+		curl_multi_perform(pMulti, &iRunning);
+		while ((psMsg = curl_multi_info_read(pMulti, &iRunning)) != NULL)
+		{
+			// Variables
+			size_t iRequest;
+			char* pPrivate;
+
+
+			// Skip other messages
+			if (psMsg->msg != CURLMSG_DONE)
+				continue;
+
+			// Get response
+			curl_easy_getinfo(psMsg->easy_handle, CURLINFO_PRIVATE, &pPrivate);
+			iRequest = (size_t)pPrivate;
+			SHttpResponse* psResponse = &(*pvecResponses)[iRequest];
+			if (psMsg->data.result == CURLE_OK)
+			{
+				curl_easy_getinfo(psMsg->easy_handle, CURLINFO_RESPONSE_CODE, &psResponse->iStatus);
+				curl_easy_getinfo(psMsg->easy_handle, CURLINFO_TOTAL_TIME, &psResponse->dTimeMs);
+				psResponse->dTimeMs *= 1000;
+			}
+			else
+			{
+				psResponse->strError = curl_easy_strerror(psMsg->data.result);
+				psResponse->dTimeMs = (double)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - tStart).count() - vecRequests[iRequest].iDelayMs;
+			}
+
+			// Remove handle and give it back to the pool
+			curl_multi_remove_handle(pMulti, vecHandles[iRequest]);
+			curl_easy_setopt(vecHandles[iRequest], CURLOPT_HTTPHEADER, NULL);
+			curl_slist_free_all(vecHeaders[iRequest]);
+			releaseHandle(vecPoolKeys[iRequest], vecHandles[iRequest]);
+			vecHandles[iRequest] = NULL;
+			vecHeaders[iRequest] = NULL;
+
+			// Report result
+			vecFinished[iRequest] = true;
+			iRemaining--;
+			fnDone(iRequest);
+
+			// Recheck which requests are required
+			iWaitMs = 0;
+		}
+
+		// Wait for activity or next start
+		if (iWaitMs > 0)
+			curl_multi_poll(pMulti, NULL, 0, iWaitMs, NULL);
+	}
+
+	// Cancel remaining requests on interrupt (their connections are dropped)
+	for (size_t i = 0; i < vecRequests.size(); i++)
+	{
+		// Skip finished requests
+		if (vecFinished[i])
+			continue;
+
+		// Mark as canceled
+		(*pvecResponses)[i].bCanceled = true;
+		(*pvecResponses)[i].strError = "Canceled";
+
+		// Remove running handle
+		if (vecHandles[i] != NULL)
+		{
+			(*pvecResponses)[i].dTimeMs = (double)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - tStart).count() - vecRequests[i].iDelayMs;
+			curl_multi_remove_handle(pMulti, vecHandles[i]);
+			curl_easy_cleanup(vecHandles[i]);
+			curl_slist_free_all(vecHeaders[i]);
+		}
+	}
+
+	// Clean up
+	if (pMulti != NULL)
+		curl_multi_cleanup(pMulti);
+
+} // CHttpClient::race
+
+//
+// CHttpClient::prepareHandle
+//
+// Task: Set the options of a request and return the header list that has to be freed afterwards (none if the request has a precompiled one)
+//
+struct curl_slist* CHttpClient::prepareHandle(CURL* pCurl, const SHttpRequest& sRequest, SHttpResponse* psResponse)
+{
+	// Variables
+	struct curl_slist* pHeaders = NULL;
+
+
+	// Build header list
+	for (std::list<std::string>::const_iterator iHeader = sRequest.lstHeaders.begin(); ((iHeader != sRequest.lstHeaders.end()) && (sRequest.pHeaders == NULL)); iHeader++)
+		pHeaders = curl_slist_append(pHeaders, iHeader->c_str());
+
+	// Set request options (connection cache of the handle is kept)
+	curl_easy_setopt(pCurl, CURLOPT_URL, sRequest.strURL.c_str());
+	curl_easy_setopt(pCurl, CURLOPT_HTTPHEADER, ((sRequest.pHeaders != NULL) ? sRequest.pHeaders : pHeaders));
+	curl_easy_setopt(pCurl, CURLOPT_IPRESOLVE, sRequest.iIPResolve);
+	curl_easy_setopt(pCurl, CURLOPT_HTTP_VERSION, sRequest.iHttpVersion);
+	curl_easy_setopt(pCurl, CURLOPT_TIMEOUT, (long)sRequest.iTimeoutS);
+	curl_easy_setopt(pCurl, CURLOPT_WRITEDATA, &psResponse->strBody);
+	curl_easy_setopt(pCurl, CURLOPT_HEADERDATA, psResponse);
+	if (sRequest.strBody.length() > 0)
+	{
+		curl_easy_setopt(pCurl, CURLOPT_POSTFIELDS, sRequest.strBody.c_str());
+		curl_easy_setopt(pCurl, CURLOPT_POSTFIELDSIZE, (long)sRequest.strBody.length());
+		curl_easy_setopt(pCurl, CURLOPT_CUSTOMREQUEST, sRequest.strMethod.c_str());
+	}
+	else
+	{
+		curl_easy_setopt(pCurl, CURLOPT_POSTFIELDS, NULL);
+		curl_easy_setopt(pCurl, CURLOPT_HTTPGET, 1L);
+		curl_easy_setopt(pCurl, CURLOPT_CUSTOMREQUEST, (sRequest.strMethod == "GET") ? NULL : sRequest.strMethod.c_str());
+	}
+
+	// Return header list
+	return pHeaders;
+
+} // CHttpClient::prepareHandle
+
+//
+// CHttpClient::acquireHandle
+//
+// Task: Take an idle handle (with warm connection) from the pool of the host or create a new one
+//
+CURL* CHttpClient::acquireHandle(const std::string& strPoolKey)
+{
+	// Variables
+	CURL* pCurl = NULL;
+
+
+	// Try to take idle handle from pool
+	{
+		std::lock_guard<std::mutex> lockPool(m_mtxPool);
+		std::vector<CURL*>* pvecIdle = &m_mapPool[strPoolKey];
+
+		if (!pvecIdle->empty())
+		{
+			pCurl = pvecIdle->back();
+			pvecIdle->pop_back();
+			return pCurl;
+		}
+	}
+
+	// Create new handle
+	if ((pCurl = curl_easy_init()) == NULL)
+		return NULL;
+
+	// Create shared connection, DNS and TLS session cache on first use (also used by concurrent transfers)
+	{
+		std::lock_guard<std::mutex> lockPool(m_mtxPool);
+		if ((m_pShare == NULL) && ((m_pShare = curl_share_init()) != NULL))
+		{
+			curl_share_setopt(m_pShare, CURLSHOPT_LOCKFUNC, lockCallback);
+			curl_share_setopt(m_pShare, CURLSHOPT_UNLOCKFUNC, unlockCallback);
+			curl_share_setopt(m_pShare, CURLSHOPT_USERDATA, this);
+			curl_share_setopt(m_pShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+			curl_share_setopt(m_pShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+			curl_share_setopt(m_pShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+		}
+	}
+
+	// Set persistent options
+	curl_easy_setopt(pCurl, CURLOPT_SHARE, m_pShare);
+	curl_easy_setopt(pCurl, CURLOPT_NOSIGNAL, 1L);
+	curl_easy_setopt(pCurl, CURLOPT_TCP_KEEPALIVE, 1L);
+	curl_easy_setopt(pCurl, CURLOPT_USERAGENT, HTTP_USER_AGENT);
+	curl_easy_setopt(pCurl, CURLOPT_WRITEFUNCTION, writeCallback);
+	curl_easy_setopt(pCurl, CURLOPT_HEADERFUNCTION, headerCallback);
+	curl_easy_setopt(pCurl, CURLOPT_XFERINFOFUNCTION, progressCallback);
+	curl_easy_setopt(pCurl, CURLOPT_NOPROGRESS, 0L);
+
+	// Return handle
+	return pCurl;
+
+} // CHttpClient::acquireHandle
+
+//
+// CHttpClient::releaseHandle
+//
+// Task: Give a handle back to the pool of the host
+//
+void CHttpClient::releaseHandle(const std::string& strPoolKey, CURL* pCurl)
+{
+	// Lock pool
+	std::lock_guard<std::mutex> lockPool(m_mtxPool);
+	std::vector<CURL*>* pvecIdle = &m_mapPool[strPoolKey];
+
+	// Keep handle if the pool is not full, otherwise free it (the most recently used one is taken first)
+	if (pvecIdle->size() < m_iMaxIdleHandles)
+		pvecIdle->push_back(pCurl);
+	else
+		curl_easy_cleanup(pCurl);
+
+} // CHttpClient::releaseHandle
+
+//
+// CHttpClient::poolKey
+//
+// Task: Get the pool key (scheme, host, port and address family) of an URL (the buffer of the key is reused)
+//
+void CHttpClient::poolKey(const std::string& strURL, long iIPResolve, std::string* pstrKey)
+{
+	// Variables
+	size_t iHostStart = strURL.find("://");
+	size_t iHostEnd;
+
+
+	// Cut path from URL
+	iHostStart = (iHostStart == std::string::npos) ? 0 : (iHostStart + 3);
+	iHostEnd = strURL.find('/', iHostStart);
+
+	// Assign origin followed by the address family
+	pstrKey->assign(strURL, 0, iHostEnd).append(1, '|').append(std::to_string(iIPResolve));
+
+} // CHttpClient::poolKey
+
+//
+// CHttpClient::writeCallback
+//
+// Task: Append received data to the response body
+//
+size_t CHttpClient::writeCallback(char* cData, size_t iSize, size_t iCount, void* pUserData)
+{
+	// Append data and return amount of processed bytes
+	((std::string*)pUserData)->append(cData, (iSize * iCount));
+	return (iSize * iCount);
+
+} // CHttpClient::writeCallback
+
+//
+// CHttpClient::headerCallback
+//
+// Task: Store the received headers the client uses (names are case insensitive, the buffers of the response are reused)
+//
+size_t CHttpClient::headerCallback(char* cData, size_t iSize, size_t iCount, void* pUserData)
+{
+	// Variables
+	SHttpResponse* psResponse = (SHttpResponse*)pUserData;
+	const char* cEnd = cData + (iSize * iCount);
+	const char* cSep = (const char*)memchr(cData, ':', (iSize * iCount));
+	const char* cValue;
+	std::string* pstrValue = NULL;
+
+
+	// Check if line is a header
+	if (cSep == NULL)
+		return (iSize * iCount);
+
+	// Find buffer of header
+	if (((cSep - cData) == 4) && (strncasecmp(cData, "etag", 4) == 0))
+		pstrValue = &psResponse->strETag;
+	else if (((cSep - cData) == 11) && (strncasecmp(cData, "retry-after", 11) == 0))
+		pstrValue = &psResponse->strRetryAfter;
+	else if (((cSep - cData) == 21) && (strncasecmp(cData, "x-ratelimit-remaining", 21) == 0))
+		pstrValue = &psResponse->strRateRemaining;
+	else if (((cSep - cData) == 17) && (strncasecmp(cData, "x-ratelimit-reset", 17) == 0))
+		pstrValue = &psResponse->strRateReset;
+	else
+		return (iSize * iCount);
+
+	// Trim and store value, return amount of processed bytes
+	for (cValue = (cSep + 1); ((cValue < cEnd) && (isspace(*cValue))); cValue++);
+	while ((cEnd > cValue) && (isspace(*(cEnd - 1))))
+		cEnd--;
+	pstrValue->assign(cValue, (cEnd - cValue));
+	return (iSize * iCount);
+
+} // CHttpClient::headerCallback
+
+//
+// CHttpClient::progressCallback
+//
+// Task: Abort running transfers on interrupt
+//
+int CHttpClient::progressCallback(void*, curl_off_t, curl_off_t, curl_off_t, curl_off_t)
+{
+	// Abort if interrupted
+	return g_sigInterrupt ? 1 : 0;
+
+} // CHttpClient::progressCallback
+
+
+//
+// CHttpClient::lockCallback
+//
+// Task: Lock shared cache data
+//
+void CHttpClient::lockCallback(CURL*, curl_lock_data iData, curl_lock_access, void* pUserData)
+{
+	// Lock corresponding mutex
+	((CHttpClient*)pUserData)->m_mtxShare[iData].lock();
+
+} // CHttpClient::lockCallback
+
+//
+// CHttpClient::unlockCallback
+//
+// Task: Unlock shared cache data
+//
+void CHttpClient::unlockCallback(CURL*, curl_lock_data iData, void* pUserData)
+{
+	// Unlock corresponding mutex
+	((CHttpClient*)pUserData)->m_mtxShare[iData].unlock();
+
+} // CHttpClient::unlockCallback
+
+//
+// CTaskGroup::CTaskGroup
+//
+// Task: Create the multi handle that drives the requests of the group
+//
+CTaskGroup::CTaskGroup(CHttpClient* pcHttpClient)
+{
+	// Assign client and create multi handle (requests to the same host share one connection as HTTP/2 streams if possible)
+	m_pcHttpClient = pcHttpClient;
+	m_pMulti = curl_multi_init();
+	m_psTransfers = NULL;
+	m_iRunning = 0;
+	m_bCanceled = false;
+	if (m_pMulti != NULL)
+	{
+		curl_multi_setopt(m_pMulti, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+		curl_multi_setopt(m_pMulti, CURLMOPT_MAX_CONCURRENT_STREAMS, (long)HTTP_MAX_STREAMS);
+	}
+
+} // CTaskGroup::CTaskGroup
+
+//
+// CTaskGroup::~CTaskGroup
+//
+// Task: Drop requests that are still running and clean up the multi handle
+//
+CTaskGroup::~CTaskGroup()
+{
+	// Remove running handles (their connections are dropped)
+	while (m_psTransfers != NULL)
+	{
+		// Variables
+		SHttpTransfer* psTransfer = m_psTransfers;
+
+
+		// Unlink transfer and free its handle
+		unlink(psTransfer);
+		curl_multi_remove_handle(m_pMulti, psTransfer->pCurl);
+		curl_easy_cleanup(psTransfer->pCurl);
+		curl_slist_free_all(psTransfer->pHeaders);
+		psTransfer->pCurl = NULL;
+		psTransfer->pHeaders = NULL;
+	}
+
+	// Clean up
+	if (m_pMulti != NULL)
+		curl_multi_cleanup(m_pMulti);
+
+} // CTaskGroup::~CTaskGroup
+
+//
+// CTaskGroup::request
+//
+// Task: Start the request of a transfer on a pooled handle, its callback is called once it is finished, failed or canceled
+//
+void CTaskGroup::request(SHttpTransfer* psTransfer)
+{
+	// Variables
+	CURL* pCurl = NULL;
+
+
+	// Get pool key into the buffer of the transfer and clear its response
+	CHttpClient::poolKey(psTransfer->sRequest.strURL, psTransfer->sRequest.iIPResolve, &psTransfer->strPoolKey);
+	psTransfer->sResponse.reset();
+
+	// Report failure from the loop if canceled or no handle is available (callbacks are never nested into the caller)
+	if ((m_bCanceled) || (m_pMulti == NULL) || ((pCurl = m_pcHttpClient->acquireHandle(psTransfer->strPoolKey)) == NULL))
+	{
+		psTransfer->sResponse.bCanceled = m_bCanceled;
+		psTransfer->sResponse.strError = (m_bCanceled ? "Canceled" : "Cannot create HTTP handle");
+		after(std::chrono::steady_clock::now(), [psTransfer]() { psTransfer->fnDone(false); });
+		return;
+	}
+
+	// Link transfer into the running ones (its request and response stay in place until it is finished)
+	psTransfer->pCurl = pCurl;
+	psTransfer->psPrev = NULL;
+	psTransfer->psNext = m_psTransfers;
+	if (m_psTransfers != NULL)
+		m_psTransfers->psPrev = psTransfer;
+	m_psTransfers = psTransfer;
+	m_iRunning++;
+
+	// Prepare handle and add it (waits for a connection that is still being set up rather than opening another one, it may offer HTTP/2)
+	psTransfer->pHeaders = m_pcHttpClient->prepareHandle(pCurl, psTransfer->sRequest, &psTransfer->sResponse);
+	curl_easy_setopt(pCurl, CURLOPT_PRIVATE, psTransfer);
+	curl_easy_setopt(pCurl, CURLOPT_PIPEWAIT, 1L);
+	curl_multi_add_handle(m_pMulti, pCurl);
+
+} // CTaskGroup::request
+
+//
+// CTaskGroup::after
+//
+// Task: Run a task once the given time is reached (right away if the group is canceled)
+//
+void CTaskGroup::after(std::chrono::steady_clock::time_point tWhen, std::function<void()> fnTask)
+{
+	// Add timer
+	m_mapTimers.emplace(tWhen, fnTask);
+
+} // CTaskGroup::after
+
+//
+// CTaskGroup::run
+//
+// Task: Drive all requests and timers of the group until none is left (an interrupt cancels the group)
+//
+void CTaskGroup::run()
+{
+	// Loop until all tasks are done
+	while ((m_psTransfers != NULL) || (!m_mapTimers.empty()))
+	{
+		// Variables
+		std::chrono::steady_clock::time_point tNow;
+		int64_t iWaitMs = HTTP_POLL_TIMEOUT_MS;
+		bool bProgress = false;
+		int iRunning;
+		CURLMsg* psMsg;
+
+
+		// Cancel everything on interrupt
+		if ((g_sigInterrupt) && (!m_bCanceled))
+			cancel();
+
+		// Run due timers (all of them if canceled, so waiting tasks give up)
+		tNow = std::chrono::steady_clock::now();
+		while ((!m_mapTimers.empty()) && ((m_bCanceled) || (m_mapTimers.begin()->first <= tNow)))
+		{
+			// Variables
+			std::function<void()> fnTask = std::move(m_mapTimers.begin()->second);
+
+
+			// Remove timer before running it (it may add new ones)
+			m_mapTimers.erase(m_mapTimers.begin());
+			fnTask();
+			bProgress = true;
+		}
+
+		// Perform transfers and process finished ones
+		if (m_pMulti != NULL)
+		{
+			curl_multi_perform(m_pMulti, &iRunning);
+			while ((psMsg = curl_multi_info_read(m_pMulti, &iRunning)) != NULL)
+			{
+				if (psMsg->msg == CURLMSG_DONE)
+				{
+					finish(psMsg->easy_handle, psMsg->data.result);
+					bProgress = true;
+				}
+			}
+		}
+
+		// Check again right away if callbacks may have added work
+		if (bProgress)
+			continue;
+
+		// Wait for activity or the next timer
+		if (!m_mapTimers.empty())
+			iWaitMs = std::min<int64_t>(iWaitMs, ((std::chrono::duration_cast<std::chrono::microseconds>(m_mapTimers.begin()->first - tNow).count() + 999) / 1000));
+		if ((iWaitMs > 0) && (m_pMulti != NULL))
+			curl_multi_poll(m_pMulti, NULL, 0, (int)iWaitMs, NULL);
+		else if (iWaitMs > 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(iWaitMs));
+	}
+
+	// Ready for further tasks
+	m_bCanceled = false;
+
+} // CTaskGroup::run
+
+//
+// CTaskGroup::cancel
+//
+// Task: Abort all running requests of the group, further requests fail right away until run() returns
+//
+void CTaskGroup::cancel()
+{
+	// Remove running handles (their connections are dropped) and report them
+	m_bCanceled = true;
+	while (m_psTransfers != NULL)
+	{
+		// Variables
+		SHttpTransfer* psTransfer = m_psTransfers;
+
+
+		// Unlink transfer and free its handle
+		unlink(psTransfer);
+		curl_multi_remove_handle(m_pMulti, psTransfer->pCurl);
+		curl_easy_cleanup(psTransfer->pCurl);
+		curl_slist_free_all(psTransfer->pHeaders);
+		psTransfer->pCurl = NULL;
+		psTransfer->pHeaders = NULL;
+
+		// Report canceled request (further requests of the callback fail from the loop)
+		psTransfer->sResponse.bCanceled = true;
+		psTransfer->sResponse.strError = "Canceled";
+		psTransfer->fnDone(false);
+	}
+
+} // CTaskGroup::cancel
+
+//
+// CTaskGroup::finish
+//
+// Task: Take over the result of a finished request, give its handle back to the pool and report it
+//
+void CTaskGroup::finish(CURL* pCurl, CURLcode iRes)
+{
+	// Variables
+	SHttpTransfer* psTransfer = NULL;
+
+
+	// Skip unknown handles
+	curl_easy_getinfo(pCurl, CURLINFO_PRIVATE, (char**)&psTransfer);
+	if ((psTransfer == NULL) || (psTransfer->pCurl != pCurl))
+		return;
+
+	// Get result
+	curl_easy_getinfo(pCurl, CURLINFO_NUM_CONNECTS, &psTransfer->sResponse.iConnects);
+	if (iRes == CURLE_OK)
+	{
+		curl_easy_getinfo(pCurl, CURLINFO_RESPONSE_CODE, &psTransfer->sResponse.iStatus);
+		curl_easy_getinfo(pCurl, CURLINFO_HTTP_VERSION, &psTransfer->sResponse.iHttpVersion);
+		curl_easy_getinfo(pCurl, CURLINFO_TOTAL_TIME, &psTransfer->sResponse.dTimeMs);
+		psTransfer->sResponse.dTimeMs *= 1000;
+	}
+	else
+		psTransfer->sResponse.strError = curl_easy_strerror(iRes);
+
+	// Remove handle, free its header list and give it back to the pool
+	unlink(psTransfer);
+	curl_multi_remove_handle(m_pMulti, pCurl);
+	curl_easy_setopt(pCurl, CURLOPT_HTTPHEADER, NULL);
+	curl_easy_setopt(pCurl, CURLOPT_PRIVATE, NULL);
+	curl_slist_free_all(psTransfer->pHeaders);
+	m_pcHttpClient->releaseHandle(psTransfer->strPoolKey, pCurl);
+	psTransfer->pCurl = NULL;
+	psTransfer->pHeaders = NULL;
+
+	// Report result (the callback may start the next request of the transfer)
+	psTransfer->fnDone(iRes == CURLE_OK);
+
+} // CTaskGroup::finish
+
+//
+// CTaskGroup::unlink
+//
+// Task: Remove a transfer from the running ones
+//
+void CTaskGroup::unlink(SHttpTransfer* psTransfer)
+{
+	// Link neighbours
+	if (psTransfer->psPrev != NULL)
+		psTransfer->psPrev->psNext = psTransfer->psNext;
+	else
+		m_psTransfers = psTransfer->psNext;
+	if (psTransfer->psNext != NULL)
+		psTransfer->psNext->psPrev = psTransfer->psPrev;
+	psTransfer->psPrev = NULL;
+	psTransfer->psNext = NULL;
+	m_iRunning--;
+
+} // CTaskGroup::unlink
+
+//
+// CIPServiceStats::rank
+//
+// Task: Order services by their observed latency and failure rate (unknown services first)
+//
+std::vector<std::string> CIPServiceStats::rank(const std::vector<std::string>& vecServices, long iIPResolve)
+{
+	// Variables
+	std::vector<std::pair<double, std::string>> vecScores;
+	std::vector<std::string> vecResult;
+
+
+	// Calculate scores
+	{
+		std::lock_guard<std::mutex> lockStats(m_mtxStats);
+		for (size_t i = 0; i < vecServices.size(); i++)
+		{
+			SIPServiceStats* psStats = &m_mapStats[vecServices[i] + "|" + std::to_string(iIPResolve)];
+			vecScores.emplace_back((psStats->dLatencyMs + (psStats->dFailureRate * IP_STATS_FAILURE_PENALTY_MS)), vecServices[i]);
+		}
+	}
+
+	// Sort services (keeps config order on equal scores)
+	std::stable_sort(vecScores.begin(), vecScores.end(), [](const std::pair<double, std::string>& sA, const std::pair<double, std::string>& sB) { return (sA.first < sB.first); });
+	for (size_t i = 0; i < vecScores.size(); i++)
+		vecResult.push_back(vecScores[i].second);
+
+	// Return result
+	return vecResult;
+
+} // CIPServiceStats::rank
+
+//
+// CIPServiceStats::record
+//
+// Task: Add the result of a request to the statistics of a service
+//
+void CIPServiceStats::record(const std::string& strService, long iIPResolve, double dTimeMs, bool bSuccess, bool bCanceled)
+{
+	// Lock statistics
+	std::lock_guard<std::mutex> lockStats(m_mtxStats);
+	SIPServiceStats* psStats = &m_mapStats[strService + "|" + std::to_string(iIPResolve)];
+
+
+	// Update moving averages (canceled requests only tell that the service has been slower)
+	psStats->dLatencyMs = (psStats->iRequests == 0) ? dTimeMs : (((1.0 - IP_STATS_WEIGHT) * psStats->dLatencyMs) + (IP_STATS_WEIGHT * (bCanceled ? std::max(dTimeMs, psStats->dLatencyMs) : dTimeMs)));
+	psStats->dFailureRate = ((1.0 - IP_STATS_WEIGHT) * psStats->dFailureRate) + (IP_STATS_WEIGHT * (bSuccess ? 0.0 : 1.0));
+
+	// Update counters
+	psStats->iRequests++;
+	if (!bSuccess)
+		psStats->iFailures++;
+
+} // CIPServiceStats::record
+
+//
+// CIPServiceStats::snapshot
+//
+// Task: Get a copy of all statistics
+//
+std::map<std::string, SIPServiceStats> CIPServiceStats::snapshot()
+{
+	// Lock statistics and return copy
+	std::lock_guard<std::mutex> lockStats(m_mtxStats);
+	return m_mapStats;
+
+} // CIPServiceStats::snapshot
+
+
+//
+// CWorkerPool::CWorkerPool
+//
+// Task: Start the worker threads
+//
+CWorkerPool::CWorkerPool(size_t iWorkers, std::function<void()> fnNotify)
+{
+	// Start at least one worker
+	m_fnNotify = fnNotify;
+	m_bStop = false;
+	for (size_t i = 0; i < std::max<size_t>(iWorkers, 1); i++)
+		m_vecWorkers.emplace_back(&CWorkerPool::run, this);
+
+} // CWorkerPool::CWorkerPool
+
+//
+// CWorkerPool::~CWorkerPool
+//
+// Task: Finish queued tasks and join the worker threads
+//
+CWorkerPool::~CWorkerPool()
+{
+	// Set stop flag and wake up all workers
+	{
+		std::lock_guard<std::mutex> lockQueue(m_mtxQueue);
+		m_bStop = true;
+	}
+	m_condQueue.notify_all();
+
+	// Join workers
+	for (size_t i = 0; i < m_vecWorkers.size(); i++)
+		m_vecWorkers[i].join();
+
+} // CWorkerPool::~CWorkerPool
+
+//
+// CWorkerPool::submit
+//
+// Task: Queue a task and return the future of its result
+//
+std::future<bool> CWorkerPool::submit(std::function<bool()> fnTask)
+{
+	// Variables
+	std::packaged_task<bool()> tskTask(fnTask);
+	std::future<bool> ftrResult = tskTask.get_future();
+
+
+	// Queue task and wake up one worker
+	{
+		std::lock_guard<std::mutex> lockQueue(m_mtxQueue);
+		m_queTasks.push(std::move(tskTask));
+	}
+	m_condQueue.notify_one();
+
+	// Return future
+	return ftrResult;
+
+} // CWorkerPool::submit
+
+//
+// CWorkerPool::run
+//
+// Task: Process queued tasks until the pool is stopped
+//
+void CWorkerPool::run()
+{
+	// Variables
+	std::packaged_task<bool()> tskTask;
+
+
+	// Worker loop
+	while (true)
+	{
+		// Wait for next task
+		{
+			std::unique_lock<std::mutex> lockQueue(m_mtxQueue);
+			m_condQueue.wait(lockQueue, [this] { return (m_bStop || !m_queTasks.empty()); });
+
+			// Check if stopped and nothing left to do
+			if (m_queTasks.empty())
+				return;
+
+			// Take task from queue
+			tskTask = std::move(m_queTasks.front());
+			m_queTasks.pop();
+		}
+
+		// Execute task and notify about its result
+		tskTask();
+		if (m_fnNotify)
+			m_fnNotify();
+	}
+
+} // CWorkerPool::run
+
+
+//
+// CNetlinkWatcher::~CNetlinkWatcher
+//
+// Task: Close the socket
+//
+CNetlinkWatcher::~CNetlinkWatcher()
+{
+	// Close socket
+	if (m_iSocket >= 0)
+		close(m_iSocket);
+
+} // CNetlinkWatcher::~CNetlinkWatcher
+
+//
+// CNetlinkWatcher::start
+//
+// Task: Subscribe to address and route changes
+//
+bool CNetlinkWatcher::start()
+{
+	// Variables
+	struct sockaddr_nl sAddr;
+
+
+	// Try to open netlink socket
+	if ((m_iSocket = socket(AF_NETLINK, (SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK), NETLINK_ROUTE)) < 0)
+		return false;
+
+	// Subscribe to address and route groups
+	memset(&sAddr, 0, sizeof(sAddr));
+	sAddr.nl_family = AF_NETLINK;
+	sAddr.nl_groups = (RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR | RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE);
+	if (bind(m_iSocket, (struct sockaddr*)&sAddr, sizeof(sAddr)) < 0)
+	{
+		close(m_iSocket);
+		m_iSocket = -1;
+		return false;
+	}
+
+	// Success
+	return true;
+
+} // CNetlinkWatcher::start
+
+//
+// CNetlinkWatcher::process
+//
+// Task: Read all queued netlink messages and check if any of them is relevant
+//
+bool CNetlinkWatcher::process()
+{
+	// Variables
+	char cBuffer[NL_BUFFER];
+	ssize_t iLength;
+	bool bRelevant = false;
+
+
+	// Read messages until the socket is drained
+	while ((iLength = recv(m_iSocket, cBuffer, sizeof(cBuffer), 0)) > 0)
+		bRelevant |= isRelevant(cBuffer, iLength);
+
+	// Return result (lost messages due to an overrun are treated as relevant)
+	return (bRelevant || ((iLength < 0) && (errno == ENOBUFS)));
+
+} // CNetlinkWatcher::process
+
+//
+// CNetlinkWatcher::isRelevant
+//
+// Task: Check if messages contain a change of a global address or a default route
+//
+bool CNetlinkWatcher::isRelevant(const char* cBuffer, ssize_t iLength)
+{
+	// Run through messages
+	for (const struct nlmsghdr* psHeader = (const struct nlmsghdr*)cBuffer; NLMSG_OK(psHeader, iLength); psHeader = NLMSG_NEXT(psHeader, iLength))
+	{
+		// Global addresses
+		if ((psHeader->nlmsg_type == RTM_NEWADDR) || (psHeader->nlmsg_type == RTM_DELADDR))
+		{
+			if (((const struct ifaddrmsg*)NLMSG_DATA(psHeader))->ifa_scope == RT_SCOPE_UNIVERSE)
+				return true;
+		}
+		// Default routes of the main table
+		else if ((psHeader->nlmsg_type == RTM_NEWROUTE) || (psHeader->nlmsg_type == RTM_DELROUTE))
+		{
+			const struct rtmsg* psRoute = (const struct rtmsg*)NLMSG_DATA(psHeader);
+			if ((psRoute->rtm_dst_len == 0) && (psRoute->rtm_table == RT_TABLE_MAIN))
+				return true;
+		}
+	}
+
+	// Nothing relevant
+	return false;
+
+} // CNetlinkWatcher::isRelevant
+
+//
+// CHttpIPProvider::read
+//
+// Task: Race the configured IP services
+//
+bool CHttpIPProvider::read(const SConfigContents& sConfigContents, std::string* pstrIPv4, std::string* pstrIPv6)
+{
+	// Read address from the services
+	return readIPAddress(pstrIPv4, pstrIPv6, sConfigContents, m_pcHttpClient, m_pcIPServiceStats);
+
+} // CHttpIPProvider::read
+
+//
+// CInterfaceIPProvider::read
+//
+// Task: Pick the stable global address of the local interfaces (no network traffic)
+//
+bool CInterfaceIPProvider::read(const SConfigContents& sConfigContents, std::string* pstrIPv4, std::string* pstrIPv6)
+{
+	// Variables
+	struct { struct nlmsghdr sHeader; struct ifaddrmsg sMessage; } sRequest;
+	std::vector<std::string> vecInterfaces = splitList(sConfigContents.strIPInterfaces, ',');
+	std::string* pstrResults[2] = { pstrIPv4, pstrIPv6 };
+	std::string strBest[2];
+	uint64_t iBestScore[2] = { 0, 0 };
+	char cBuffer[NL_BUFFER], cName[IF_NAMESIZE];
+	ssize_t iLength;
+	bool bDone = false;
+	int iSocket;
+
+
+	// Request all addresses
+	if ((iSocket = socket(AF_NETLINK, (SOCK_RAW | SOCK_CLOEXEC), NETLINK_ROUTE)) < 0)
+		return false;
+	memset(&sRequest, 0, sizeof(sRequest));
+	sRequest.sHeader.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+	sRequest.sHeader.nlmsg_type = RTM_GETADDR;
+	sRequest.sHeader.nlmsg_flags = (NLM_F_REQUEST | NLM_F_DUMP);
+	sRequest.sHeader.nlmsg_seq = 1;
+	sRequest.sMessage.ifa_family = (pstrIPv6 == NULL) ? AF_INET : ((pstrIPv4 == NULL) ? AF_INET6 : AF_UNSPEC);
+	if (send(iSocket, &sRequest, sRequest.sHeader.nlmsg_len, 0) < 0)
+	{
+		close(iSocket);
+		return false;
+	}
+
+	// Read the dump
+	while ((!bDone) && ((iLength = recv(iSocket, cBuffer, sizeof(cBuffer), 0)) > 0))
+	{
+		for (const struct nlmsghdr* psHeader = (const struct nlmsghdr*)cBuffer; NLMSG_OK(psHeader, iLength); psHeader = NLMSG_NEXT(psHeader, iLength))
+		{
+			// Variables
+			const struct ifaddrmsg* psAddr = (const struct ifaddrmsg*)NLMSG_DATA(psHeader);
+			int iAttrLength = IFA_PAYLOAD(psHeader);
+			const unsigned char* cAddr = NULL;
+			uint32_t iFlags = psAddr->ifa_flags, iPreferred = 0;
+			uint8_t iFamily = (psAddr->ifa_family == AF_INET) ? 0 : 1;
+			uint64_t iScore;
+			char cText[INET6_ADDRSTRLEN];
+
+
+			// Check for end of dump
+			if ((psHeader->nlmsg_type == NLMSG_DONE) || (psHeader->nlmsg_type == NLMSG_ERROR))
+			{
+				bDone = true;
+				break;
+			}
+			if ((psHeader->nlmsg_type != RTM_NEWADDR) || ((psAddr->ifa_family != AF_INET) && (psAddr->ifa_family != AF_INET6)) || (pstrResults[iFamily] == NULL))
+				continue;
+
+			// Get address, flags and lifetime (the local address of point-to-point links is IFA_LOCAL)
+			for (const struct rtattr* psAttr = IFA_RTA(psAddr); RTA_OK(psAttr, iAttrLength); psAttr = RTA_NEXT(psAttr, iAttrLength))
+			{
+				if ((psAttr->rta_type == IFA_LOCAL) || ((psAttr->rta_type == IFA_ADDRESS) && (cAddr == NULL)))
+					cAddr = (const unsigned char*)RTA_DATA(psAttr);
+				else if (psAttr->rta_type == IFA_FLAGS)
+					iFlags = *(const uint32_t*)RTA_DATA(psAttr);
+				else if (psAttr->rta_type == IFA_CACHEINFO)
+					iPreferred = ((const struct ifa_cacheinfo*)RTA_DATA(psAttr))->ifa_prefered;
+			}
+
+			// Skip filtered addresses and interfaces
+			if ((cAddr == NULL) || (psAddr->ifa_scope == RT_SCOPE_HOST) || (isExcluded(iFamily, cAddr, iFlags, sConfigContents.iIPExclude)))
+				continue;
+			if ((!vecInterfaces.empty()) && ((if_indextoname(psAddr->ifa_index, cName) == NULL) || (std::find(vecInterfaces.begin(), vecInterfaces.end(), cName) == vecInterfaces.end())))
+				continue;
+
+			// Rate address (static before dynamic, then the last picked one, then the longest preferred lifetime)
+			inet_ntop(psAddr->ifa_family, cAddr, cText, sizeof(cText));
+			iScore = ((uint64_t)((iFlags & IFA_F_PERMANENT) ? 2 : 1) << 33) | ((uint64_t)(m_strLast[iFamily] == cText) << 32) | iPreferred;
+			if (iScore > iBestScore[iFamily])
+			{
+				iBestScore[iFamily] = iScore;
+				strBest[iFamily] = cText;
+			}
+		}
+	}
+	close(iSocket);
+
+	// Return results
+	for (uint8_t iFamily = 0; iFamily < 2; iFamily++)
+		if (pstrResults[iFamily] != NULL)
+			*pstrResults[iFamily] = m_strLast[iFamily] = strBest[iFamily];
+	return ((!strBest[0].empty()) || (!strBest[1].empty()));
+
+} // CInterfaceIPProvider::read
+
+//
+// CInterfaceIPProvider::isExcluded
+//
+// Task: Check if an interface address is filtered (loopback, unspecified and not usable addresses always are)
+//
+bool CInterfaceIPProvider::isExcluded(uint8_t iFamily, const unsigned char* cAddr, uint32_t iFlags, uint8_t iExclude)
+{
+	// Addresses that are not usable yet or anymore
+	if (iFlags & (IFA_F_TENTATIVE | IFA_F_DADFAILED | IFA_F_DEPRECATED))
+		return true;
+
+	// IPv4
+	if (iFamily == 0)
+	{
+		if ((cAddr[0] == 0) || (cAddr[0] == 127) || (cAddr[0] >= 224))
+			return true;
+		if ((iExclude & IP_EXCLUDE_PRIVATE) && ((cAddr[0] == 10) || ((cAddr[0] == 172) && ((cAddr[1] & 0xF0) == 16)) || ((cAddr[0] == 192) && (cAddr[1] == 168)) || ((cAddr[0] == 100) && ((cAddr[1] & 0xC0) == 64))))
+			return true;
+		return ((iExclude & IP_EXCLUDE_LINK_LOCAL) && (cAddr[0] == 169) && (cAddr[1] == 254));
+	}
+
+	// IPv6 (unspecified, loopback, multicast and IPv4 mapped)
+	static const unsigned char c_cMapped[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF };
+	if ((memcmp(cAddr, &in6addr_any, 16) == 0) || (memcmp(cAddr, &in6addr_loopback, 16) == 0) || (cAddr[0] == 0xFF) || (memcmp(cAddr, c_cMapped, 12) == 0))
+		return true;
+	if ((iExclude & IP_EXCLUDE_LINK_LOCAL) && (cAddr[0] == 0xFE) && ((cAddr[1] & 0xC0) == 0x80))
+		return true;
+	if ((iExclude & IP_EXCLUDE_ULA) && ((cAddr[0] & 0xFE) == 0xFC))
+		return true;
+	return ((iExclude & IP_EXCLUDE_TEMPORARY) && (iFlags & IFA_F_TEMPORARY));
+
+} // CInterfaceIPProvider::isExcluded
+
+
+//
+// CConfigWatcher::~CConfigWatcher
+//
+// Task: Close the inotify descriptor (removes all watches)
+//
+CConfigWatcher::~CConfigWatcher()
+{
+	// Close descriptor
+	if (m_iFd >= 0)
+		close(m_iFd);
+
+} // CConfigWatcher::~CConfigWatcher
+
+//
+// CConfigWatcher::start
+//
+// Task: Watch the config directory and the records directory (if it exists)
+//
+bool CConfigWatcher::start()
+{
+	// Try to create inotify descriptor and watch the config directory (editors often replace files by renaming)
+	if ((m_iFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0)
+		return false;
+	if ((m_iConfigDir = inotify_add_watch(m_iFd, std::filesystem::path(CFG_FILE_PATH).parent_path().c_str(), (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE))) < 0)
+	{
+		close(m_iFd);
+		m_iFd = -1;
+		return false;
+	}
+
+	// Watch records directory (added later if it is created)
+	m_iRecordsDir = inotify_add_watch(m_iFd, REC_DIR_PATH, (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ONLYDIR));
+	return true;
+
+} // CConfigWatcher::start
+
+//
+// CConfigWatcher::process
+//
+// Task: Read all queued events and check if the config or a records file changed
+//
+bool CConfigWatcher::process()
+{
+	// Variables
+	alignas(struct inotify_event) char cBuffer[RELOAD_BUFFER];
+	std::string strConfigName = std::filesystem::path(CFG_FILE_PATH).filename();
+	std::string strRecordsName = std::filesystem::path(REC_DIR_PATH).filename();
+	ssize_t iLength;
+	bool bRelevant = false;
+
+
+	// Read events until the descriptor is drained
+	while ((iLength = read(m_iFd, cBuffer, sizeof(cBuffer))) > 0)
+	{
+		// Run through events
+		for (ssize_t iPos = 0; iPos < iLength;)
+		{
+			// Variables
+			const struct inotify_event* psEvent = (const struct inotify_event*)(cBuffer + iPos);
+			std::string strName = (psEvent->len != 0) ? psEvent->name : "";
+
+
+			// Check if events have been lost
+			if (psEvent->mask & IN_Q_OVERFLOW)
+				bRelevant = true;
+			// Check if config file or records directory changed
+			else if (psEvent->wd == m_iConfigDir)
+			{
+				if (strName == strConfigName)
+					bRelevant = true;
+				else if (strName == strRecordsName)
+				{
+					m_iRecordsDir = inotify_add_watch(m_iFd, REC_DIR_PATH, (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ONLYDIR));
+					bRelevant = true;
+				}
+			}
+			// Check if a records file changed
+			else if ((psEvent->wd == m_iRecordsDir) && (strName.length() > strlen(REC_FILE_EXTENSION)) && (strName.compare((strName.length() - strlen(REC_FILE_EXTENSION)), std::string::npos, REC_FILE_EXTENSION) == 0))
+				bRelevant = true;
+
+			// Next event
+			iPos += sizeof(struct inotify_event) + psEvent->len;
+		}
+	}
+
+	// Return result (lost events due to an overflow are treated as relevant)
+	return bRelevant;
+
+} // CConfigWatcher::process
+
+
+//
+// CEventLoop::~CEventLoop
+//
+// Task: Close all descriptors of the event loop
+//
+CEventLoop::~CEventLoop()
+{
+	// Close descriptors
+	if (m_iWake >= 0)
+		close(m_iWake);
+	if (m_iSignal >= 0)
+		close(m_iSignal);
+	if (m_iTimer >= 0)
+		close(m_iTimer);
+	if (m_iEpoll >= 0)
+		close(m_iEpoll);
+
+} // CEventLoop::~CEventLoop
+
+//
+// CEventLoop::init
+//
+// Task: Block the handled signals and create the epoll, timer, signal and wake descriptors
+//
+bool CEventLoop::init()
+{
+	// Variables
+	sigset_t sSignals;
+	int iFds[3];
+
+
+	// Block handled signals (inherited by all threads started afterwards)
+	sigemptyset(&sSignals);
+	sigaddset(&sSignals, SIGINT);
+	sigaddset(&sSignals, SIGTERM);
+	sigaddset(&sSignals, SIGHUP);
+	if (pthread_sigmask(SIG_BLOCK, &sSignals, NULL) != 0)
+		return false;
+
+	// Try to create descriptors
+	if (((m_iEpoll = epoll_create1(EPOLL_CLOEXEC)) < 0) || ((m_iTimer = timerfd_create(CLOCK_MONOTONIC, (TFD_NONBLOCK | TFD_CLOEXEC))) < 0) || ((m_iSignal = signalfd(-1, &sSignals, (SFD_NONBLOCK | SFD_CLOEXEC))) < 0) || ((m_iWake = eventfd(0, (EFD_NONBLOCK | EFD_CLOEXEC))) < 0))
+		return false;
+
+	// Add descriptors to epoll
+	iFds[0] = m_iTimer;
+	iFds[1] = m_iSignal;
+	iFds[2] = m_iWake;
+	for (uint8_t i = 0; i < 3; i++)
+		if (!watch(iFds[i], nullptr))
+			return false;
+
+	// Success
+	return true;
+
+} // CEventLoop::init
+
+//
+// CEventLoop::watch
+//
+// Task: Call the given function whenever the descriptor becomes readable
+//
+bool CEventLoop::watch(int iFd, std::function<void()> fnReadable)
+{
+	// Variables
+	struct epoll_event sEvent;
+
+
+	// Try to add descriptor
+	memset(&sEvent, 0, sizeof(sEvent));
+	sEvent.events = EPOLLIN;
+	sEvent.data.fd = iFd;
+	if (epoll_ctl(m_iEpoll, EPOLL_CTL_ADD, iFd, &sEvent) < 0)
+		return false;
+
+	// Remember handler
+	m_mapWatches[iFd] = fnReadable;
+	return true;
+
+} // CEventLoop::watch
+
+//
+// CEventLoop::watchWritable
+//
+// Task: Call the handler of a watched descriptor once it becomes writable instead of readable
+//
+bool CEventLoop::watchWritable(int iFd)
+{
+	// Variables
+	struct epoll_event sEvent;
+
+
+	// Try to change events of descriptor
+	memset(&sEvent, 0, sizeof(sEvent));
+	sEvent.events = EPOLLOUT;
+	sEvent.data.fd = iFd;
+	return (epoll_ctl(m_iEpoll, EPOLL_CTL_MOD, iFd, &sEvent) == 0);
+
+} // CEventLoop::watchWritable
+
+//
+// CEventLoop::setTimer
+//
+// Task: Arm the timer for the given point in time
+//
+void CEventLoop::setTimer(std::chrono::steady_clock::time_point tExpire)
+{
+	// Variables
+	struct itimerspec sTimer;
+	int64_t iExpireNs = std::chrono::duration_cast<std::chrono::nanoseconds>(tExpire.time_since_epoch()).count();
+
+
+	// Set absolute expiration time (steady clock uses the monotonic clock, a zero value would disarm the timer)
+	memset(&sTimer, 0, sizeof(sTimer));
+	sTimer.it_value.tv_sec = (iExpireNs / 1000000000);
+	sTimer.it_value.tv_nsec = std::max<int64_t>((iExpireNs % 1000000000), ((iExpireNs < 1000000000) ? 1 : 0));
+	timerfd_settime(m_iTimer, TFD_TIMER_ABSTIME, &sTimer, NULL);
+
+} // CEventLoop::setTimer
+
+//
+// CEventLoop::wake
+//
+// Task: Wake up the event loop (may be called from any thread)
+//
+void CEventLoop::wake()
+{
+	// Variables
+	uint64_t iValue = 1;
+
+
+	// Increment counter (only fails if it would overflow, in which case a wake up is pending anyway)
+	if (write(m_iWake, &iValue, sizeof(iValue)) < 0)
+		return;
+
+} // CEventLoop::wake
+
+//
+// CEventLoop::run
+//
+// Task: Wait for the next events and process them
+//
+uint8_t CEventLoop::run()
+{
+	// Variables
+	struct epoll_event sEvents[EVT_MAX_EVENTS];
+	struct signalfd_siginfo sSignal;
+	uint64_t iValue;
+	uint8_t iResult = EVT_NONE;
+	int iCount;
+
+
+	// Wait for events
+	if ((iCount = epoll_wait(m_iEpoll, sEvents, EVT_MAX_EVENTS, -1)) < 0)
+		return EVT_NONE;
+
+	// Run through events
+	for (int i = 0; i < iCount; i++)
+	{
+		// Signals
+		if (sEvents[i].data.fd == m_iSignal)
+		{
+			while (read(m_iSignal, &sSignal, sizeof(sSignal)) == sizeof(sSignal))
+			{
+				// Set interrupt flag (cancels running requests) or report hangup
+				if (sSignal.ssi_signo == SIGHUP)
+					iResult |= EVT_HANGUP;
+				else
+				{
+					g_sigInterrupt = 1;
+					iResult |= EVT_TERMINATE;
+				}
+			}
+		}
+		// Timer
+		else if (sEvents[i].data.fd == m_iTimer)
+		{
+			if (read(m_iTimer, &iValue, sizeof(iValue)) == sizeof(iValue))
+				iResult |= EVT_TIMER;
+		}
+		// Wake up
+		else if (sEvents[i].data.fd == m_iWake)
+		{
+			if (read(m_iWake, &iValue, sizeof(iValue)) == sizeof(iValue))
+				iResult |= EVT_WAKE;
+		}
+		// Watched descriptors (handler is copied, it may remove itself)
+		else if (m_mapWatches.count(sEvents[i].data.fd) != 0)
+		{
+			std::function<void()> fnReadable = m_mapWatches[sEvents[i].data.fd];
+			if (fnReadable)
+				fnReadable();
+		}
+	}
+
+	// Return processed events
+	return iResult;
+
+} // CEventLoop::run
+
+//
+// CEventLoop::unwatch
+//
+// Task: Stop watching a descriptor
+//
+void CEventLoop::unwatch(int iFd)
+{
+	// Remove descriptor and handler
+	epoll_ctl(m_iEpoll, EPOLL_CTL_DEL, iFd, NULL);
+	m_mapWatches.erase(iFd);
+
+} // CEventLoop::unwatch
+
+
+//
+// CMetrics::init
+//
+// Task: Create the lookup metrics of all IP services (unlocked, so only called at startup and on reload, while no lookup of the workers is running)
+//
+void CMetrics::init(const std::vector<std::string>& vecServices)
+{
+	// Run through services and families
+	for (size_t i = 0; i < vecServices.size(); i++)
+	{
+		if (m_mapLookups[vecServices[i] + "\tipv4"] == nullptr)
+			m_mapLookups[vecServices[i] + "\tipv4"].reset(new SLookupMetrics());
+		if (m_mapLookups[vecServices[i] + "\tipv6"] == nullptr)
+			m_mapLookups[vecServices[i] + "\tipv6"].reset(new SLookupMetrics());
+	}
+
+} // CMetrics::init
+
+//
+// CMetrics::countLookup
+//
+// Task: Count the result of an IP service request
+//
+void CMetrics::countLookup(const std::string& strService, long iIPResolve, double dTimeMs, bool bSuccess, bool bCanceled)
+{
+	// Variables
+	std::map<std::string, std::unique_ptr<SLookupMetrics>>::iterator iLookup = m_mapLookups.find(strService + ((iIPResolve == CURL_IPRESOLVE_V6) ? "\tipv6" : "\tipv4"));
+
+
+	// Skip unknown services
+	if (iLookup == m_mapLookups.end())
+		return;
+
+	// Count result and latency (canceled requests did not finish)
+	if (bCanceled)
+		iLookup->second->iCanceled.fetch_add(1, std::memory_order_relaxed);
+	else
+	{
+		(bSuccess ? iLookup->second->iSuccess : iLookup->second->iFailure).fetch_add(1, std::memory_order_relaxed);
+		iLookup->second->sLatency.observe(dTimeMs);
+	}
+
+} // CMetrics::countLookup
+
+//
+// CMetrics::countRequest
+//
+// Task: Count an API request of a record by status class
+//
+void CMetrics::countRequest(const SDomRecords* psDomRecords, const SHttpResponse& sResponse)
+{
+	// Count status class (0 for transport errors) and latency
+	psDomRecords->sMetrics.iRequests[((sResponse.iStatus >= 100) && (sResponse.iStatus < 600)) ? (sResponse.iStatus / 100) : 0].fetch_add(1, std::memory_order_relaxed);
+	m_sRequestLatency.observe(sResponse.dTimeMs);
+
+	// Count HTTP/2 answers and new connections (streams of a multiplexed connection open none)
+	if (sResponse.iHttpVersion == CURL_HTTP_VERSION_2_0)
+		iHttp2Requests.fetch_add(1, std::memory_order_relaxed);
+	iConnections.fetch_add(sResponse.iConnects, std::memory_order_relaxed);
+
+} // CMetrics::countRequest
+
+//
+// CMetrics::render
+//
+// Task: Render all metrics in the Prometheus text format (called by the main thread, which owns the record state)
+//
+std::string CMetrics::render(const std::list<SDomRecords>& lstRecords)
+{
+	// Variables
+	const char* cClasses[METRICS_STATUS_CLASSES] = { "error", "1xx", "2xx", "3xx", "4xx", "5xx" };
+	time_t tNow = time(NULL);
+	std::string strResult, strBackoff, strAttempts;
+	size_t iSubDomains = 0;
+
+
+	// Polls
+	strResult += "# HELP recupdater_ip_polls_total Checks of the IP address.\n# TYPE recupdater_ip_polls_total counter\n";
+	strResult += "recupdater_ip_polls_total " + std::to_string(iPolls.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_ip_poll_failures_total Checks of the IP address without any valid answer.\n# TYPE recupdater_ip_poll_failures_total counter\n";
+	strResult += "recupdater_ip_poll_failures_total " + std::to_string(iPollFailures.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_ip_changes_total Changes of the IP address.\n# TYPE recupdater_ip_changes_total counter\n";
+	strResult += "recupdater_ip_changes_total " + std::to_string(iAddressChanges.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_ip_poll_interval_seconds Interval until the next check of the IP address.\n# TYPE recupdater_ip_poll_interval_seconds gauge\n";
+	strResult += "recupdater_ip_poll_interval_seconds " + std::to_string(iPollIntervalS.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_cluster_nodes Live nodes of the cluster.\n# TYPE recupdater_cluster_nodes gauge\n";
+	strResult += "recupdater_cluster_nodes " + std::to_string(iClusterNodes.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_cluster_owned_subdomains Subdomains that are written by this node of the cluster.\n# TYPE recupdater_cluster_owned_subdomains gauge\n";
+	strResult += "recupdater_cluster_owned_subdomains " + std::to_string(iClusterOwned.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_api_rate_limited_total API responses with status 429.\n# TYPE recupdater_api_rate_limited_total counter\n";
+	strResult += "recupdater_api_rate_limited_total " + std::to_string(iRateLimited.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_api_deferred_total Record updates deferred because the rate limit of their API key was used up.\n# TYPE recupdater_api_deferred_total counter\n";
+	strResult += "recupdater_api_deferred_total " + std::to_string(iRateDeferred.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_api_http2_requests_total API requests answered over HTTP/2.\n# TYPE recupdater_api_http2_requests_total counter\n";
+	strResult += "recupdater_api_http2_requests_total " + std::to_string(iHttp2Requests.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_api_connections_total Connections opened for API requests.\n# TYPE recupdater_api_connections_total counter\n";
+	strResult += "recupdater_api_connections_total " + std::to_string(iConnections.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_journal_pending Rrsets whose desired state is journaled but not published yet.\n# TYPE recupdater_journal_pending gauge\n";
+	strResult += "recupdater_journal_pending " + std::to_string(iJournalPending.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_dns_checks_total Lookups of updated rrsets at the authoritative nameservers.\n# TYPE recupdater_dns_checks_total counter\n";
+	strResult += "recupdater_dns_checks_total{result=\"confirmed\"} " + std::to_string(iDNSConfirmed.load(std::memory_order_relaxed)) + "\n";
+	strResult += "recupdater_dns_checks_total{result=\"unconfirmed\"} " + std::to_string(iDNSUnconfirmed.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_dns_requeued_total Rrsets updated again because the nameservers did not serve them.\n# TYPE recupdater_dns_requeued_total counter\n";
+	strResult += "recupdater_dns_requeued_total " + std::to_string(iDNSRequeued.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_ip_cross_check_mismatches_total Cross-checks whose address differed from the one of the local interfaces.\n# TYPE recupdater_ip_cross_check_mismatches_total counter\n";
+	strResult += "recupdater_ip_cross_check_mismatches_total " + std::to_string(iCrossCheckMismatches.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_ip_pushes_total Addresses received from the push listener.\n# TYPE recupdater_ip_pushes_total counter\n";
+	strResult += "recupdater_ip_pushes_total " + std::to_string(iPushes.load(std::memory_order_relaxed)) + "\n";
+
+	// IP lookups per service and family
+	strResult += "# HELP recupdater_ip_lookups_total Requests to the IP services.\n# TYPE recupdater_ip_lookups_total counter\n";
+	for (std::map<std::string, std::unique_ptr<SLookupMetrics>>::iterator iLookup = m_mapLookups.begin(); iLookup != m_mapLookups.end(); iLookup++)
+	{
+		std::string strLabels = "service=\"" + label(iLookup->first.substr(0, iLookup->first.find('\t'))) + "\",family=\"" + iLookup->first.substr(iLookup->first.find('\t') + 1) + "\"";
+		strResult += "recupdater_ip_lookups_total{" + strLabels + ",result=\"success\"} " + std::to_string(iLookup->second->iSuccess.load(std::memory_order_relaxed)) + "\n";
+		strResult += "recupdater_ip_lookups_total{" + strLabels + ",result=\"failure\"} " + std::to_string(iLookup->second->iFailure.load(std::memory_order_relaxed)) + "\n";
+		strResult += "recupdater_ip_lookups_total{" + strLabels + ",result=\"canceled\"} " + std::to_string(iLookup->second->iCanceled.load(std::memory_order_relaxed)) + "\n";
+	}
+	strResult += "# HELP recupdater_ip_lookup_duration_seconds Duration of finished requests to the IP services.\n# TYPE recupdater_ip_lookup_duration_seconds histogram\n";
+	for (std::map<std::string, std::unique_ptr<SLookupMetrics>>::iterator iLookup = m_mapLookups.begin(); iLookup != m_mapLookups.end(); iLookup++)
+		renderHistogram(&strResult, "recupdater_ip_lookup_duration_seconds", ("service=\"" + label(iLookup->first.substr(0, iLookup->first.find('\t'))) + "\",family=\"" + iLookup->first.substr(iLookup->first.find('\t') + 1) + "\""), iLookup->second->sLatency);
+
+	// API requests
+	strResult += "# HELP recupdater_api_request_duration_seconds Duration of requests to the API.\n# TYPE recupdater_api_request_duration_seconds histogram\n";
+	renderHistogram(&strResult, "recupdater_api_request_duration_seconds", "", m_sRequestLatency);
+	strResult += "# HELP recupdater_api_requests_total Requests to the API by domain and status class.\n# TYPE recupdater_api_requests_total counter\n";
+	for (std::list<SDomRecords>::const_iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+		for (uint8_t i = 0; i < METRICS_STATUS_CLASSES; i++)
+			if (iRec->sMetrics.iRequests[i].load(std::memory_order_relaxed) != 0)
+				strResult += "recupdater_api_requests_total{domain=\"" + label(iRec->strDomain) + "\",class=\"" + cClasses[i] + "\"} " + std::to_string(iRec->sMetrics.iRequests[i].load(std::memory_order_relaxed)) + "\n";
+
+	// Retries and backoff state
+	strResult += "# HELP recupdater_retries_total Scheduled retries of failed rrsets.\n# TYPE recupdater_retries_total counter\n";
+	for (std::list<SDomRecords>::const_iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+		strResult += "recupdater_retries_total{domain=\"" + label(iRec->strDomain) + "\"} " + std::to_string(iRec->sMetrics.iRetries.load(std::memory_order_relaxed)) + "\n";
+	strResult += "# HELP recupdater_rrsets_pending Rrsets waiting for an update.\n# TYPE recupdater_rrsets_pending gauge\n";
+	for (std::list<SDomRecords>::const_iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+		strResult += "recupdater_rrsets_pending{domain=\"" + label(iRec->strDomain) + "\"} " + std::to_string(iRec->setPending.size()) + "\n";
+	strBackoff = "# HELP recupdater_rrsets_backoff Rrsets waiting for a retry after a failure.\n# TYPE recupdater_rrsets_backoff gauge\n";
+	strAttempts = "# HELP recupdater_retry_attempts_max Highest amount of failed attempts of an rrset.\n# TYPE recupdater_retry_attempts_max gauge\n";
+	for (std::list<SDomRecords>::const_iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+	{
+		// Variables
+		size_t iBackoff = 0;
+		uint16_t iMaxAttempts = 0;
+
+
+		// Run through retry states
+		for (std::map<std::string, SRetryState>::const_iterator iRetry = iRec->mapRetries.begin(); iRetry != iRec->mapRetries.end(); iRetry++)
+		{
+			iBackoff += (iRetry->second.iAttempts > 0);
+			iMaxAttempts = std::max(iMaxAttempts, iRetry->second.iAttempts);
+		}
+		strBackoff += "recupdater_rrsets_backoff{domain=\"" + label(iRec->strDomain) + "\"} " + std::to_string(iBackoff) + "\n";
+		strAttempts += "recupdater_retry_attempts_max{domain=\"" + label(iRec->strDomain) + "\"} " + std::to_string(iMaxAttempts) + "\n";
+	}
+	strResult += strBackoff + strAttempts;
+
+	// Staleness (only records that have been published at least once)
+	strResult += "# HELP recupdater_seconds_since_last_publish Seconds since an rrset of the domain has been published or verified.\n# TYPE recupdater_seconds_since_last_publish gauge\n";
+	for (std::list<SDomRecords>::const_iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+	{
+		iSubDomains += iRec->lstSubDomains.size();
+		if (iRec->sMetrics.tLastPublish.load(std::memory_order_relaxed) != 0)
+			strResult += "recupdater_seconds_since_last_publish{domain=\"" + label(iRec->strDomain) + "\"} " + std::to_string(tNow - iRec->sMetrics.tLastPublish.load(std::memory_order_relaxed)) + "\n";
+	}
+
+	// Records
+	strResult += "# HELP recupdater_records Managed subdomains.\n# TYPE recupdater_records gauge\n";
+	strResult += "recupdater_records " + std::to_string(iSubDomains) + "\n";
+
+	// Return result
+	return strResult;
+
+} // CMetrics::render
+
+//
+// CMetrics::label
+//
+// Task: Escape a label value
+//
+std::string CMetrics::label(const std::string& strValue)
+{
+	// Variables
+	std::string strResult;
+
+
+	// Run through characters and escape backslashes, quotes and new lines
+	for (size_t i = 0; i < strValue.length(); i++)
+	{
+		if ((strValue[i] == '\\') || (strValue[i] == '\"'))
+			strResult += '\\';
+		strResult += (strValue[i] == '\n') ? std::string("\\n") : std::string(1, strValue[i]);
+	}
+
+	// Return result
+	return strResult;
+
+} // CMetrics::label
+
+//
+// CMetrics::renderHistogram
+//
+// Task: Render a histogram with cumulative buckets
+//
+void CMetrics::renderHistogram(std::string* pstrResult, const char* cName, const std::string& strLabels, const SHistogram& sHistogram)
+{
+	// Variables
+	std::string strPrefix = strLabels + (strLabels.empty() ? "" : ",");
+	uint64_t iCumulative = 0;
+	char cBound[SMALL_BUFFER];
+
+
+	// Run through buckets
+	for (size_t i = 0; i < METRICS_BUCKETS; i++)
+	{
+		iCumulative += sHistogram.iBuckets[i].load(std::memory_order_relaxed);
+		if (i < (METRICS_BUCKETS - 1))
+			snprintf(cBound, sizeof(cBound), "%g", (SHistogram::c_dBoundsMs[i] / 1000.0));
+		else
+			snprintf(cBound, sizeof(cBound), "+Inf");
+		*pstrResult += std::string(cName) + "_bucket{" + strPrefix + "le=\"" + cBound + "\"} " + std::to_string(iCumulative) + "\n";
+	}
+
+	// Sum and count
+	snprintf(cBound, sizeof(cBound), "%.6f", ((double)sHistogram.iSumUs.load(std::memory_order_relaxed) / 1000000.0));
+	*pstrResult += std::string(cName) + "_sum" + (strLabels.empty() ? "" : ("{" + strLabels + "}")) + " " + cBound + "\n";
+	*pstrResult += std::string(cName) + "_count" + (strLabels.empty() ? "" : ("{" + strLabels + "}")) + " " + std::to_string(sHistogram.iCount.load(std::memory_order_relaxed)) + "\n";
+
+} // CMetrics::renderHistogram
+
+
+//
+// CHttpServer::~CHttpServer
+//
+// Task: Close all connections and the listening socket
+//
+CHttpServer::~CHttpServer()
+{
+	// Close clients
+	for (std::map<int, SHttpConnection>::iterator iClient = m_mapClients.begin(); iClient != m_mapClients.end(); iClient++)
+		close(iClient->first);
+
+	// Close socket and timer
+	if (m_iSocket >= 0)
+		close(m_iSocket);
+	if (m_iTimer >= 0)
+		close(m_iTimer);
+
+} // CHttpServer::~CHttpServer
+
+//
+// CHttpServer::start
+//
+// Task: Listen on the given address and answer requests with the given handler on the event loop
+//
+bool CHttpServer::start(const std::string& strAddress, uint16_t iPort, CEventLoop* pcEventLoop, std::function<int(const std::string&, std::string*, std::string*)> fnHandle)
+{
+	// Variables
+	struct sockaddr_storage sAddr;
+	socklen_t iAddrLen;
+	int iReuse = 1;
+
+
+	// Parse address (IPv4 or IPv6)
+	memset(&sAddr, 0, sizeof(sAddr));
+	if (inet_pton(AF_INET, strAddress.c_str(), &((struct sockaddr_in*)&sAddr)->sin_addr) == 1)
+	{
+		((struct sockaddr_in*)&sAddr)->sin_family = AF_INET;
+		((struct sockaddr_in*)&sAddr)->sin_port = htons(iPort);
+		iAddrLen = sizeof(struct sockaddr_in);
+	}
+	else if (inet_pton(AF_INET6, strAddress.c_str(), &((struct sockaddr_in6*)&sAddr)->sin6_addr) == 1)
+	{
+		((struct sockaddr_in6*)&sAddr)->sin6_family = AF_INET6;
+		((struct sockaddr_in6*)&sAddr)->sin6_port = htons(iPort);
+		iAddrLen = sizeof(struct sockaddr_in6);
+	}
+	else
+	{
+		errno = EINVAL;
+		return false;
+	}
+
+	// Try to open socket and listen
+	if ((m_iSocket = socket(sAddr.ss_family, (SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC), 0)) < 0)
+		return false;
+	setsockopt(m_iSocket, SOL_SOCKET, SO_REUSEADDR, &iReuse, sizeof(iReuse));
+	if ((bind(m_iSocket, (struct sockaddr*)&sAddr, iAddrLen) < 0) || (listen(m_iSocket, HTTPD_BACKLOG) < 0) || ((m_iTimer = timerfd_create(CLOCK_MONOTONIC, (TFD_NONBLOCK | TFD_CLOEXEC))) < 0))
+	{
+		close(m_iSocket);
+		m_iSocket = -1;
+		return false;
+	}
+
+	// Remember settings and watch for connections and expired clients
+	m_pcEventLoop = pcEventLoop;
+	m_fnHandle = fnHandle;
+	return ((m_pcEventLoop->watch(m_iSocket, [this]() { accept(); })) && (m_pcEventLoop->watch(m_iTimer, [this]() { expire(); })));
+
+} // CHttpServer::start
+
+//
+// CHttpServer::accept
+//
+// Task: Accept pending connections and watch them for requests (the oldest client is closed if too many are connected)
+//
+void CHttpServer::accept()
+{
+	// Variables
+	int iClient;
+
+
+	// Run through pending connections
+	while ((iClient = accept4(m_iSocket, NULL, NULL, (SOCK_NONBLOCK | SOCK_CLOEXEC))) >= 0)
+	{
+		// Make room for the client
+		if (m_mapClients.size() >= HTTPD_MAX_CLIENTS)
+			drop(std::min_element(m_mapClients.begin(), m_mapClients.end(), [](const std::pair<const int, SHttpConnection>& sA, const std::pair<const int, SHttpConnection>& sB) { return (sA.second.tDeadline < sB.second.tDeadline); })->first);
+
+		// Watch client until its deadline
+		m_mapClients[iClient].tDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(HTTPD_TIMEOUT_S);
+		if (!m_pcEventLoop->watch(iClient, [this, iClient]() { serve(iClient); }))
+			drop(iClient);
+	}
+	arm();
+
+} // CHttpServer::accept
+
+//
+// CHttpServer::serve
+//
+// Task: Read the request of a client and send the answer once it is complete (without blocking, the rest is sent when the client is writable again)
+//
+void CHttpServer::serve(int iClient)
+{
+	// Variables
+	SHttpConnection* psClient = &m_mapClients[iClient];
+	std::string strHeaders, strBody;
+	int iStatus;
+	char cBuffer[BIG_BUFFER];
+	ssize_t iLength = 0;
+
+
+	// Read request if not answered yet
+	if (psClient->strResponse.empty())
+	{
+		// Read available data
+		while ((iLength = recv(iClient, cBuffer, sizeof(cBuffer), 0)) > 0)
+			psClient->strRequest.append(cBuffer, iLength);
+
+		// Drop closed, failed or too large requests
+		if ((iLength == 0) || ((iLength < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK)) || (psClient->strRequest.length() > HTTPD_MAX_REQUEST))
+		{
+			drop(iClient);
+			return;
+		}
+
+		// Wait for end of header
+		if ((psClient->strRequest.find("\r\n\r\n") == std::string::npos) && (psClient->strRequest.find("\n\n") == std::string::npos))
+			return;
+
+		// Build response
+		iStatus = m_fnHandle(psClient->strRequest, &strHeaders, &strBody);
+		psClient->strResponse = "HTTP/1.1 " + std::to_string(iStatus) + ((iStatus == 200) ? " OK" : ((iStatus == 401) ? " Unauthorized" : ((iStatus == 404) ? " Not Found" : " Bad Request"))) + "\r\n" + strHeaders;
+		psClient->strResponse += "Content-Length: " + std::to_string(strBody.length()) + "\r\nConnection: close\r\n\r\n" + strBody;
+	}
+
+	// Send as much of the response as possible
+	while ((psClient->iSent < psClient->strResponse.length()) && ((iLength = send(iClient, (psClient->strResponse.data() + psClient->iSent), (psClient->strResponse.length() - psClient->iSent), MSG_NOSIGNAL)) > 0))
+		psClient->iSent += iLength;
+
+	// Close connection once sent or failed, wait until writable otherwise
+	if ((psClient->iSent >= psClient->strResponse.length()) || ((errno != EAGAIN) && (errno != EWOULDBLOCK)) || (!m_pcEventLoop->watchWritable(iClient)))
+		drop(iClient);
+
+} // CHttpServer::serve
+
+//
+// CHttpServer::expire
+//
+// Task: Close all clients whose deadline has passed
+//
+void CHttpServer::expire()
+{
+	// Variables
+	std::chrono::steady_clock::time_point tNow = std::chrono::steady_clock::now();
+	std::vector<int> vecExpired;
+	uint64_t iExpirations;
+
+
+	// Read timer
+	if (read(m_iTimer, &iExpirations, sizeof(iExpirations)) < 0)
+		iExpirations = 0;
+
+	// Close expired clients and wait for the next deadline
+	for (std::map<int, SHttpConnection>::iterator iClient = m_mapClients.begin(); iClient != m_mapClients.end(); iClient++)
+		if (iClient->second.tDeadline <= tNow)
+			vecExpired.push_back(iClient->first);
+	for (size_t i = 0; i < vecExpired.size(); i++)
+		drop(vecExpired[i]);
+	arm();
+
+} // CHttpServer::expire
+
+//
+// CHttpServer::arm
+//
+// Task: Arm the timer for the earliest deadline of all clients (disarmed if there are none)
+//
+void CHttpServer::arm()
+{
+	// Variables
+	struct itimerspec sTimer;
+	std::chrono::steady_clock::time_point tFirst = std::chrono::steady_clock::time_point::max();
+	int64_t iExpireNs;
+
+
+	// Find earliest deadline
+	memset(&sTimer, 0, sizeof(sTimer));
+	for (std::map<int, SHttpConnection>::iterator iClient = m_mapClients.begin(); iClient != m_mapClients.end(); iClient++)
+		tFirst = std::min(tFirst, iClient->second.tDeadline);
+
+	// Set absolute expiration time (steady clock uses the monotonic clock, a zero value disarms the timer)
+	if (!m_mapClients.empty())
+	{
+		iExpireNs = std::chrono::duration_cast<std::chrono::nanoseconds>(tFirst.time_since_epoch()).count();
+		sTimer.it_value.tv_sec = (iExpireNs / 1000000000);
+		sTimer.it_value.tv_nsec = std::max<int64_t>((iExpireNs % 1000000000), ((iExpireNs < 1000000000) ? 1 : 0));
+	}
+	timerfd_settime(m_iTimer, TFD_TIMER_ABSTIME, &sTimer, NULL);
+
+} // CHttpServer::arm
+
+//
+// CHttpServer::drop
+//
+// Task: Close a client connection
+//
+void CHttpServer::drop(int iClient)
+{
+	// Stop watching and close
+	m_pcEventLoop->unwatch(iClient);
+	m_mapClients.erase(iClient);
+	close(iClient);
+
+} // CHttpServer::drop
+
+
+//
+// CControlServer::~CControlServer
+//
+// Task: Close all connections and remove the socket file
+//
+CControlServer::~CControlServer()
+{
+	// Close clients
+	for (std::map<int, std::string>::iterator iClient = m_mapClients.begin(); iClient != m_mapClients.end(); iClient++)
+		close(iClient->first);
+	for (std::list<std::pair<int, std::string>>::iterator iRequest = m_lstRequests.begin(); iRequest != m_lstRequests.end(); iRequest++)
+		close(iRequest->first);
+
+	// Close and remove socket
+	if (m_iSocket >= 0)
+	{
+		close(m_iSocket);
+		unlink(m_strPath.c_str());
+	}
+
+} // CControlServer::~CControlServer
+
+//
+// CControlServer::start
+//
+// Task: Listen on the Unix socket (only accessible for the owner) and read requests on the event loop
+//
+bool CControlServer::start(const std::string& strPath, CEventLoop* pcEventLoop)
+{
+	// Variables
+	struct sockaddr_un sAddr;
+	int iProbe;
+	int iResult;
+	int iError;
+
+
+	// Check path
+	memset(&sAddr, 0, sizeof(sAddr));
+	sAddr.sun_family = AF_UNIX;
+	if (strPath.length() >= sizeof(sAddr.sun_path))
+	{
+		errno = ENAMETOOLONG;
+		return false;
+	}
+	strcpy(sAddr.sun_path, strPath.c_str());
+
+	// Check if another instance still answers on the socket (only a stale socket file of a previous run is replaced)
+	if ((iProbe = socket(AF_UNIX, (SOCK_STREAM | SOCK_CLOEXEC), 0)) < 0)
+		return false;
+	iResult = connect(iProbe, (struct sockaddr*)&sAddr, sizeof(sAddr));
+	iError = errno;
+	close(iProbe);
+	if (iResult == 0)
+	{
+		errno = EADDRINUSE;
+		return false;
+	}
+	if ((iError == ECONNREFUSED) && (unlink(strPath.c_str()) < 0))
+		return false;
+	if ((iError != ECONNREFUSED) && (iError != ENOENT))
+	{
+		errno = iError;
+		return false;
+	}
+
+	// Try to open socket and listen
+	if ((m_iSocket = socket(AF_UNIX, (SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC), 0)) < 0)
+		return false;
+	if ((bind(m_iSocket, (struct sockaddr*)&sAddr, sizeof(sAddr)) < 0) || (chmod(strPath.c_str(), 0600) < 0) || (listen(m_iSocket, CTL_BACKLOG) < 0))
+	{
+		close(m_iSocket);
+		m_iSocket = -1;
+		return false;
+	}
+
+	// Remember settings and watch for connections
+	m_strPath = strPath;
+	m_pcEventLoop = pcEventLoop;
+	return m_pcEventLoop->watch(m_iSocket, [this]() { accept(); });
+
+} // CControlServer::start
+
+//
+// CControlServer::process
+//
+// Task: Answer all complete requests and close their connections
+//
+void CControlServer::process(std::function<std::string(const std::vector<std::string>&)> fnHandle)
+{
+	// Run through requests
+	while (!m_lstRequests.empty())
+	{
+		// Variables
+		int iClient = m_lstRequests.front().first;
+		std::string strResponse = fnHandle(splitList(m_lstRequests.front().second, ' '));
+		struct timeval sTimeout = { CTL_SEND_TIMEOUT_S, 0 };
+		ssize_t iLength;
+		size_t iSent = 0;
+
+
+		// Send response (blocking with timeout) and close connection
+		m_lstRequests.pop_front();
+		fcntl(iClient, F_SETFL, (fcntl(iClient, F_GETFL) & ~O_NONBLOCK));
+		setsockopt(iClient, SOL_SOCKET, SO_SNDTIMEO, &sTimeout, sizeof(sTimeout));
+		while ((iSent < strResponse.length()) && ((iLength = send(iClient, (strResponse.data() + iSent), (strResponse.length() - iSent), MSG_NOSIGNAL)) > 0))
+			iSent += iLength;
+		close(iClient);
+	}
+
+} // CControlServer::process
+
+//
+// CControlServer::accept
+//
+// Task: Accept pending connections and watch them for requests
+//
+void CControlServer::accept()
+{
+	// Variables
+	int iClient;
+
+
+	// Run through pending connections
+	while ((iClient = accept4(m_iSocket, NULL, NULL, (SOCK_NONBLOCK | SOCK_CLOEXEC))) >= 0)
+	{
+		m_mapClients[iClient].clear();
+		if (!m_pcEventLoop->watch(iClient, [this, iClient]() { serve(iClient); }))
+			drop(iClient);
+	}
+
+} // CControlServer::accept
+
+//
+// CControlServer::serve
+//
+// Task: Read the request line of a client and queue it once it is complete
+//
+void CControlServer::serve(int iClient)
+{
+	// Variables
+	std::string* pstrRequest = &m_mapClients[iClient];
+	char cBuffer[BIG_BUFFER];
+	ssize_t iLength;
+	size_t iEnd;
+
+
+	// Read available data
+	while ((iLength = recv(iClient, cBuffer, sizeof(cBuffer), 0)) > 0)
+		pstrRequest->append(cBuffer, iLength);
+
+	// Queue complete request (answered by the main loop when no update is running)
+	if ((iEnd = pstrRequest->find('\n')) != std::string::npos)
+	{
+		m_lstRequests.emplace_back(iClient, pstrRequest->substr(0, iEnd));
+		m_pcEventLoop->unwatch(iClient);
+		m_mapClients.erase(iClient);
+		return;
+	}
+
+	// Drop closed, failed or too large requests
+	if ((iLength == 0) || ((iLength < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK)) || (pstrRequest->length() > CTL_MAX_REQUEST))
+		drop(iClient);
+
+} // CControlServer::serve
+
+//
+// CControlServer::drop
+//
+// Task: Close a client connection
+//
+void CControlServer::drop(int iClient)
+{
+	// Stop watching and close
+	m_pcEventLoop->unwatch(iClient);
+	m_mapClients.erase(iClient);
+	close(iClient);
+
+} // CControlServer::drop
+
+
+//
+// CLogger::open
+//
+// Task: Open the logfile and start the background writer
+//
+bool CLogger::open(const char* cPath, bool bJson, off_t iMaxSize, uint16_t iRotateFiles)
+{
+	// Variables
+	struct stat sStat;
+
+
+	// Try to open file for appending
+	if ((m_iFd = ::open(cPath, (O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC), 0644)) < 0)
+		return false;
+	m_iSize = (fstat(m_iFd, &sStat) == 0) ? sStat.st_size : 0;
+	m_strPath = cPath;
+	m_bJson = bJson;
+	m_iMaxSize = iMaxSize;
+	m_iRotateFiles = std::max<uint16_t>(iRotateFiles, 1);
+
+	// Prepare ring (every slot is free for the lap of its index)
+	m_psRing.reset(new SLogRecord[LOG_RING_SIZE]);
+	for (size_t i = 0; i < LOG_RING_SIZE; i++)
+		m_psRing[i].iSequence.store(i, std::memory_order_relaxed);
+	m_iHead.store(0);
+	m_iTail = 0;
+
+	// Start writer
+	m_bStop = false;
+	m_bOpen = true;
+	m_thrWriter = std::thread(&CLogger::run, this);
+	return true;
+
+} // CLogger::open
+
+//
+// CLogger::close
+//
+// Task: Stop the writer after it wrote all remaining lines and close the logfile
+//
+void CLogger::close()
+{
+	// Check if open
+	if (!m_bOpen.exchange(false))
+		return;
+
+	// Stop writer
+	{
+		std::lock_guard<std::mutex> lockWake(m_mtxWake);
+		m_bStop = true;
+	}
+	m_condWake.notify_one();
+	m_thrWriter.join();
+
+	// Close file
+	::close(m_iFd);
+	m_iFd = -1;
+	m_psRing.reset();
+
+} // CLogger::close
+
+//
+// CLogger::log
+//
+// Task: Put a line into the ring without blocking (dropped if the ring is full)
+//
+void CLogger::log(uint8_t iLevel, const char* cFormat, ...)
+{
+	// Variables
+	size_t iPos;
+	SLogRecord* psRecord;
+	va_list vaArgs;
+	int iLength;
+
+
+	// Check if logging is enabled
+	if (!m_bOpen.load(std::memory_order_relaxed))
+		return;
+
+	// Claim a free slot
+	iPos = m_iHead.load(std::memory_order_relaxed);
+	while (true)
+	{
+		// Variables
+		intptr_t iDiff;
+
+
+		// Compare lap of slot with position
+		psRecord = &m_psRing[iPos & (LOG_RING_SIZE - 1)];
+		iDiff = (intptr_t)psRecord->iSequence.load(std::memory_order_acquire) - (intptr_t)iPos;
+		if ((iDiff == 0) && (m_iHead.compare_exchange_weak(iPos, (iPos + 1), std::memory_order_relaxed)))
+			break;
+
+		// Ring is full
+		if (iDiff < 0)
+		{
+			m_iDropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		// Slot was taken by another thread
+		if (iDiff > 0)
+			iPos = m_iHead.load(std::memory_order_relaxed);
+	}
+
+	// Fill slot (truncated lines end with dots)
+	psRecord->tTime = time(NULL);
+	psRecord->iLevel = iLevel;
+	va_start(vaArgs, cFormat);
+	iLength = vsnprintf(psRecord->cMessage, LOG_MESSAGE_SIZE, cFormat, vaArgs);
+	va_end(vaArgs);
+	if (iLength >= LOG_MESSAGE_SIZE)
+		memcpy((psRecord->cMessage + LOG_MESSAGE_SIZE - 4), "...", 4);
+
+	// Publish slot and wake writer early if a quarter of the ring is used
+	psRecord->iSequence.store((iPos + 1), std::memory_order_release);
+	if (((iPos + 1) % (LOG_RING_SIZE / 4)) == 0)
+		m_condWake.notify_one();
+
+} // CLogger::log
+
+//
+// CLogger::run
+//
+// Task: Collect published lines and write them to the logfile in batches
+//
+void CLogger::run()
+{
+	// Variables
+	std::string strBatch;
+	bool bStop = false;
+
+
+	// Writer loop
+	while (true)
+	{
+		// Variables
+		uint64_t iDropped;
+
+
+		// Collect published lines
+		strBatch.clear();
+		while (true)
+		{
+			// Variables
+			SLogRecord* psRecord = &m_psRing[m_iTail & (LOG_RING_SIZE - 1)];
+
+
+			// Check if published
+			if (psRecord->iSequence.load(std::memory_order_acquire) != (m_iTail + 1))
+				break;
+
+			// Format line and free slot for the next lap
+			append(*psRecord, &strBatch);
+			psRecord->iSequence.store((m_iTail + LOG_RING_SIZE), std::memory_order_release);
+			m_iTail++;
+		}
+
+		// Report dropped lines
+		if ((iDropped = m_iDropped.exchange(0)) != 0)
+		{
+			m_iDroppedTotal += iDropped;
+			SLogRecord sRecord;
+			sRecord.tTime = time(NULL);
+			sRecord.iLevel = LOG_LEVEL_WARNING;
+			snprintf(sRecord.cMessage, LOG_MESSAGE_SIZE, "Dropped %llu log line/s (logging too fast).", (unsigned long long)iDropped);
+			append(sRecord, &strBatch);
+		}
+
+		// Write batch with a single call
+		if (!strBatch.empty())
+			write(strBatch);
+
+		// Stop after the last batch
+		if (bStop)
+			break;
+
+		// Wait for more lines (until a quarter of the ring is used)
+		std::unique_lock<std::mutex> lockWake(m_mtxWake);
+		m_condWake.wait_for(lockWake, std::chrono::milliseconds(LOG_FLUSH_MS), [this]() { return ((m_bStop) || ((m_iHead.load(std::memory_order_relaxed) - m_iTail) >= (LOG_RING_SIZE / 4))); });
+		bStop = m_bStop;
+	}
+
+} // CLogger::run
+
+//
+// CLogger::append
+//
+// Task: Format a line as text or JSON (timestamp formatted once per second)
+//
+void CLogger::append(const SLogRecord& sRecord, std::string* pstrBatch)
+{
+	// Variables
+	static const char* c_cLevels[] = { "UPDATE", "WARNING", "ERROR", "INFO" };
+	static const char* c_cJsonLevels[] = { "update", "warning", "error", "info" };
+	tm sTime;
+	char cStamp[SMALL_BUFFER];
+
+
+	// Format timestamp if the second changed
+	if (sRecord.tTime != m_tStamp)
+	{
+		localtime_r(&sRecord.tTime, &sTime);
+		if (m_bJson)
+			strftime(cStamp, sizeof(cStamp), "%Y-%m-%dT%H:%M:%S%z", &sTime);
+		else
+			snprintf(cStamp, sizeof(cStamp), "[%.2i.%.2i.%i | %.2i:%.2i] ", sTime.tm_mday, (sTime.tm_mon + 1), (sTime.tm_year + 1900), sTime.tm_hour, sTime.tm_min);
+		m_strStamp = cStamp;
+		m_tStamp = sRecord.tTime;
+	}
+
+	// Append line (without temporary strings)
+	if (m_bJson)
+	{
+		pstrBatch->append("{\"time\": \"").append(m_strStamp).append("\", \"level\": \"").append(c_cJsonLevels[sRecord.iLevel]).append("\", \"message\": \"");
+		for (const char* cChar = sRecord.cMessage; *cChar != '\0'; cChar++)
+		{
+			if ((*cChar == '"') || (*cChar == '\\'))
+				pstrBatch->append(1, '\\').append(1, *cChar);
+			else if ((unsigned char)*cChar < 0x20)
+			{
+				snprintf(cStamp, sizeof(cStamp), "\\u%.4x", *cChar);
+				pstrBatch->append(cStamp);
+			}
+			else
+				pstrBatch->append(1, *cChar);
+		}
+		pstrBatch->append("\"}\n");
+	}
+	else
+		pstrBatch->append(m_strStamp).append(1, '[').append(c_cLevels[sRecord.iLevel]).append("]: ").append(sRecord.cMessage).append(1, '\n');
+
+} // CLogger::append
+
+//
+// CLogger::write
+//
+// Task: Write a batch to the logfile and rotate it if it became too big
+//
+void CLogger::write(const std::string& strBatch)
+{
+	// Variables
+	size_t iWritten = 0;
+	ssize_t iResult;
+
+
+	// Rotate before the file would exceed its size
+	if ((m_iMaxSize != 0) && (m_iSize != 0) && ((m_iSize + (off_t)strBatch.length()) > m_iMaxSize))
+		rotate();
+
+	// Write whole batch (lines are lost if the disk is full)
+	while ((iWritten < strBatch.length()) && (m_iFd >= 0))
+	{
+		if ((iResult = ::write(m_iFd, (strBatch.data() + iWritten), (strBatch.length() - iWritten))) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		iWritten += iResult;
+	}
+	m_iSize += iWritten;
+
+} // CLogger::write
+
+//
+// CLogger::rotate
+//
+// Task: Shift the rotated logfiles (<path>.1 is the newest) and start a new one
+//
+void CLogger::rotate()
+{
+	// Shift files (the oldest one is overwritten)
+	for (uint16_t i = m_iRotateFiles; i > 1; i--)
+		rename((m_strPath + "." + std::to_string(i - 1)).c_str(), (m_strPath + "." + std::to_string(i)).c_str());
+	rename(m_strPath.c_str(), (m_strPath + ".1").c_str());
+
+	// Open new file (keep writing to the old one if that fails)
+	int iFd = ::open(m_strPath.c_str(), (O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC), 0644);
+	if (iFd >= 0)
+	{
+		::close(m_iFd);
+		m_iFd = iFd;
+	}
+	m_iSize = 0;
+
+} // CLogger::rotate
+
+
+//
+// CStateStore::load
+//
+// Task: Load the published rrsets from the state file
+//
+bool CStateStore::load(const char* cPath)
+{
+	// Variables
+	std::ifstream cStateFile(cPath);
+	std::string strCurLine;
+
+
+	// Check if failed
+	if (cStateFile.fail())
+		return false;
+
+	// Run through file (domain, subdomain, type, TTL, value and time separated by tabs)
+	while (std::getline(cStateFile, strCurLine))
+	{
+		// Variables
+		std::vector<std::string> vecFields;
+		size_t iStart = 0, iEnd;
+		SPublishedRRSet sRRSet;
+
+
+		// Split line
+		while ((iEnd = strCurLine.find('\t', iStart)) != std::string::npos)
+		{
+			vecFields.push_back(strCurLine.substr(iStart, (iEnd - iStart)));
+			iStart = iEnd + 1;
+		}
+		vecFields.push_back(strCurLine.substr(iStart));
+
+		// Skip invalid lines
+		if (vecFields.size() != 6)
+			continue;
+
+		// Add rrset
+		sRRSet.iTTL = atoi(vecFields[3].c_str());
+		sRRSet.strValue = vecFields[4];
+		sRRSet.tPublished = atoll(vecFields[5].c_str());
+		m_mapRRSets[key(vecFields[0], vecFields[1], vecFields[2].c_str())] = sRRSet;
+	}
+
+	// Success
+	m_bDirty = false;
+	return true;
+
+} // CStateStore::load
+
+//
+// CStateStore::save
+//
+// Task: Write the published rrsets atomically to the state file if they have changed
+//
+bool CStateStore::save(const char* cPath)
+{
+	// Variables
+	std::filesystem::path ptDirPath = std::filesystem::path(cPath).parent_path();
+	std::string strTmpPath = std::string(cPath) + ".tmp";
+	std::error_code errCreateDir;
+	FILE* pFile;
+	bool bWritten = true;
+
+
+	// Nothing to do if unchanged
+	if (!m_bDirty)
+		return true;
+
+	// Create parent directory if required
+	if (!std::filesystem::exists(ptDirPath))
+		if (!std::filesystem::create_directories(ptDirPath, errCreateDir))
+			return false;
+
+	// Try to open temporary file
+	if ((pFile = fopen(strTmpPath.c_str(), "w")) == NULL)
+		return false;
+
+	// Write rrsets
+	for (std::unordered_map<std::string, SPublishedRRSet>::iterator iRRSet = m_mapRRSets.begin(); ((iRRSet != m_mapRRSets.end()) && (bWritten)); iRRSet++)
+		bWritten = (fprintf(pFile, "%s\t%u\t%s\t%lld\n", iRRSet->first.c_str(), iRRSet->second.iTTL, iRRSet->second.strValue.c_str(), (long long)iRRSet->second.tPublished) > 0);
+
+	// Flush file to disk and replace state file
+	bWritten = ((bWritten) && (fflush(pFile) == 0) && (fsync(fileno(pFile)) == 0));
+	if ((fclose(pFile) != 0) || (!bWritten) || (rename(strTmpPath.c_str(), cPath) != 0))
+	{
+		unlink(strTmpPath.c_str());
+		return false;
+	}
+
+	// Success
+	m_bDirty = false;
+	return true;
+
+} // CStateStore::save
+
+//
+// CStateStore::isPublished
+//
+// Task: Check if all rrsets of a record have been published with the given addresses (returns the oldest publishing time)
+//
+bool CStateStore::isPublished(const SDomRecords& sDomRecords, const SConfigContents& sConfigContents, const std::string& strIPv4, const std::string& strIPv6, time_t* ptPublished)
+{
+	// Variables
+	time_t tOldest = time(NULL);
+
+
+	// Run through subdomains
+	for (std::list<SSubDomain>::const_iterator iSDom = sDomRecords.lstSubDomains.begin(); iSDom != sDomRecords.lstSubDomains.end(); iSDom++)
+	{
+		// Check IPv4 record if enabled
+		if ((iSDom->bIPv4) && (!matches(key(sDomRecords.strDomain, iSDom->strName, "A"), strIPv4, iSDom->iTTL, &tOldest)))
+			return false;
+
+		// Check IPv6 record if enabled and valid
+		if ((iSDom->bIPv6) && (sConfigContents.bEnableIPv6) && (strIPv6.length() != 0) && (!matches(key(sDomRecords.strDomain, iSDom->strName, "AAAA"), strIPv6, iSDom->iTTL, &tOldest)))
+			return false;
+	}
+
+	// Success
+	*ptPublished = tOldest;
+	return true;
+
+} // CStateStore::isPublished
+
+//
+// CStateStore::setPublished
+//
+// Task: Remember a published rrset
+//
+void CStateStore::setPublished(const std::string& strDomain, const std::string& strSubDomain, const std::string& strType, const std::string& strValue, uint16_t iTTL, time_t tPublished)
+{
+	// Variables
+	SPublishedRRSet* psRRSet = &m_mapRRSets[key(strDomain, strSubDomain, strType.c_str())];
+
+
+	// Assign values and mark as changed
+	psRRSet->strValue = strValue;
+	psRRSet->iTTL = iTTL;
+	psRRSet->tPublished = tPublished;
+	m_bDirty = true;
+
+} // CStateStore::setPublished
+
+//
+// CStateStore::key
+//
+// Task: Get the key of an rrset
+//
+std::string CStateStore::key(const std::string& strDomain, const std::string& strSubDomain, const char* cType)
+{
+	// Return key
+	return strDomain + "\t" + strSubDomain + "\t" + cType;
+
+} // CStateStore::key
+
+//
+// CStateStore::matches
+//
+// Task: Check if an rrset has been published with the given value and TTL (keeps the oldest publishing time)
+//
+bool CStateStore::matches(const std::string& strKey, const std::string& strValue, uint16_t iTTL, time_t* ptPublished)
+{
+	// Variables
+	std::unordered_map<std::string, SPublishedRRSet>::iterator iRRSet = m_mapRRSets.find(strKey);
+
+
+	// Check if missing or different
+	if ((iRRSet == m_mapRRSets.end()) || (iRRSet->second.strValue != strValue) || (iRRSet->second.iTTL != iTTL))
+		return false;
+
+	// Keep oldest publishing time and return
+	*ptPublished = std::min(*ptPublished, iRRSet->second.tPublished);
+	return true;
+
+} // CStateStore::matches
+
+//
+// CJournal::open
+//
+// Task: Replay the journal file, rewrite it compacted and open it for appending
+//
+bool CJournal::open(const char* cPath)
+{
+	// Variables
+	std::ifstream cJournalFile(cPath);
+	std::string strCurLine;
+
+
+	// Remember path
+	m_strPath = cPath;
+
+	// Replay lines (the last line may be incomplete after a crash and is skipped)
+	while (std::getline(cJournalFile, strCurLine))
+	{
+		// Variables
+		std::vector<std::string> vecFields;
+		size_t iStart = 0, iEnd;
+		SJournalEntry sEntry;
+
+
+		// Split line
+		while ((iEnd = strCurLine.find('\t', iStart)) != std::string::npos)
+		{
+			vecFields.push_back(strCurLine.substr(iStart, (iEnd - iStart)));
+			iStart = iEnd + 1;
+		}
+		vecFields.push_back(strCurLine.substr(iStart));
+
+		// Desired state (W, domain, subdomain, type, TTL, value and time), the latest one of an rrset wins
+		if ((vecFields.size() == 7) && (vecFields[0] == "W"))
+		{
+			sEntry.iTTL = atoi(vecFields[4].c_str());
+			sEntry.strValue = vecFields[5];
+			sEntry.tDesired = atoll(vecFields[6].c_str());
+			m_mapEntries[vecFields[1] + "\t" + vecFields[2] + "\t" + vecFields[3]] = sEntry;
+		}
+		// Published (D, domain, subdomain and type)
+		else if ((vecFields.size() == 4) && (vecFields[0] == "D"))
+			m_mapEntries.erase(vecFields[1] + "\t" + vecFields[2] + "\t" + vecFields[3]);
+	}
+
+	// Rewrite file with the remaining entries and open it
+	return compact();
+
+} // CJournal::open
+
+//
+// CJournal::want
+//
+// Task: Remember the desired state of the given rrsets of a record (replaces older states of the same rrset)
+//
+void CJournal::want(const SDomRecords& sDomRecords, const std::set<std::string>& setRRSets, const std::string& strIPv4, const std::string& strIPv6)
+{
+	// Variables
+	time_t tNow = time(NULL);
+
+
+	// Run through subdomains and types
+	for (std::list<SSubDomain>::const_iterator iSDom = sDomRecords.lstSubDomains.begin(); iSDom != sDomRecords.lstSubDomains.end(); iSDom++)
+	{
+		for (const char* cType : { "A", "AAAA" })
+		{
+			// Variables
+			const std::string& strValue = ((cType[1] == '\0') ? strIPv4 : strIPv6);
+			std::string strKey = sDomRecords.strDomain + "\t" + iSDom->strName + "\t" + cType;
+			SJournalEntry* psEntry;
+
+
+			// Skip rrsets that are not requested
+			if (setRRSets.count(iSDom->strName + "\t" + cType) == 0)
+				continue;
+
+			// Skip if the same state is already journaled
+			psEntry = &m_mapEntries[strKey];
+			if ((psEntry->strValue == strValue) && (psEntry->iTTL == iSDom->iTTL))
+				continue;
+
+			// Replace state and append it
+			psEntry->strValue = strValue;
+			psEntry->iTTL = iSDom->iTTL;
+			psEntry->tDesired = tNow;
+			m_strBuffer += "W\t" + strKey + "\t" + std::to_string(iSDom->iTTL) + "\t" + strValue + "\t" + std::to_string(tNow) + "\n";
+			m_iLines++;
+		}
+	}
+
+} // CJournal::want
+
+//
+// CJournal::done
+//
+// Task: Forget the desired state of an rrset once it has been published
+//
+void CJournal::done(const std::string& strDomain, const std::string& strSubDomain, const std::string& strType)
+{
+	// Variables
+	std::string strKey = strDomain + "\t" + strSubDomain + "\t" + strType;
+
+
+	// Remove entry and append it if it existed
+	if (m_mapEntries.erase(strKey) == 0)
+		return;
+	m_strBuffer += "D\t" + strKey + "\n";
+	m_iLines++;
+
+} // CJournal::done
+
+//
+// CJournal::drop
+//
+// Task: Forget the desired states of all rrsets of a record (e.g. if the address has changed back to the published one)
+//
+void CJournal::drop(const SDomRecords& sDomRecords)
+{
+	// Nothing to do if empty
+	if (m_mapEntries.empty())
+		return;
+
+	// Run through subdomains
+	for (std::list<SSubDomain>::const_iterator iSDom = sDomRecords.lstSubDomains.begin(); iSDom != sDomRecords.lstSubDomains.end(); iSDom++)
+	{
+		done(sDomRecords.strDomain, iSDom->strName, "A");
+		done(sDomRecords.strDomain, iSDom->strName, "AAAA");
+	}
+
+} // CJournal::drop
+
+//
+// CJournal::prune
+//
+// Task: Forget the desired states of rrsets that are not managed anymore
+//
+void CJournal::prune(const std::list<SDomRecords>& lstRecords)
+{
+	// Variables
+	std::set<std::string> setKeys;
+
+
+	// Nothing to do if empty
+	if (m_mapEntries.empty())
+		return;
+
+	// Collect keys of all managed rrsets
+	for (std::list<SDomRecords>::const_iterator iRec = lstRecords.begin(); iRec != lstRecords.end(); iRec++)
+	{
+		for (std::list<SSubDomain>::const_iterator iSDom = iRec->lstSubDomains.begin(); iSDom != iRec->lstSubDomains.end(); iSDom++)
+		{
+			if (iSDom->bIPv4)
+				setKeys.insert(iRec->strDomain + "\t" + iSDom->strName + "\tA");
+			if (iSDom->bIPv6)
+				setKeys.insert(iRec->strDomain + "\t" + iSDom->strName + "\tAAAA");
+		}
+	}
+
+	// Remove all other entries
+	for (std::unordered_map<std::string, SJournalEntry>::iterator iEntry = m_mapEntries.begin(); iEntry != m_mapEntries.end();)
+	{
+		// Skip managed rrsets
+		if (setKeys.count(iEntry->first) != 0)
+		{
+			iEntry++;
+			continue;
+		}
+
+		// Remove entry and append it
+		m_strBuffer += "D\t" + iEntry->first + "\n";
+		m_iLines++;
+		iEntry = m_mapEntries.erase(iEntry);
+	}
+
+} // CJournal::prune
+
+//
+// CJournal::flush
+//
+// Task: Append the buffered changes and flush them to disk (compacts the file once it mostly contains superseded lines)
+//
+bool CJournal::flush()
+{
+	// Variables
+	size_t iWritten = 0;
+	ssize_t iResult;
+
+
+	// Check if not opened
+	if (m_iFile == -1)
+		return false;
+
+	// Rewrite file if too many lines are superseded or a write failed before (a partial line may be left)
+	if ((m_bCompact) || (m_iLines > std::max<size_t>(JOURNAL_COMPACT_LINES, (4 * m_mapEntries.size()))))
+		return compact();
+
+	// Nothing to do if unchanged
+	if (m_strBuffer.empty())
+		return true;
+
+	// Append buffer and flush it to disk
+	while ((iWritten < m_strBuffer.length()) && (((iResult = write(m_iFile, (m_strBuffer.data() + iWritten), (m_strBuffer.length() - iWritten))) > 0) || (errno == EINTR)))
+		iWritten += std::max<ssize_t>(iResult, 0);
+	if ((iWritten < m_strBuffer.length()) || (fdatasync(m_iFile) != 0))
+	{
+		m_bCompact = true;
+		return false;
+	}
+
+	// Success
+	m_strBuffer.clear();
+	return true;
+
+} // CJournal::flush
+
+//
+// CJournal::latest
+//
+// Task: Get the most recently desired value of a type
+//
+bool CJournal::latest(const char* cType, std::string* pstrValue)
+{
+	// Variables
+	time_t tLatest = -1;
+
+
+	// Run through entries of the type
+	for (std::unordered_map<std::string, SJournalEntry>::iterator iEntry = m_mapEntries.begin(); iEntry != m_mapEntries.end(); iEntry++)
+	{
+		if ((iEntry->second.tDesired > tLatest) && (iEntry->first.compare((iEntry->first.rfind('\t') + 1), std::string::npos, cType) == 0))
+		{
+			tLatest = iEntry->second.tDesired;
+			*pstrValue = iEntry->second.strValue;
+		}
+	}
+
+	// Return result
+	return (tLatest != -1);
+
+} // CJournal::latest
+
+//
+// CJournal::compact
+//
+// Task: Write the current entries atomically to the journal file and reopen it for appending
+//
+bool CJournal::compact()
+{
+	// Variables
+	std::filesystem::path ptDirPath = std::filesystem::path(m_strPath).parent_path();
+	std::string strTmpPath = m_strPath + ".tmp";
+	std::error_code errCreateDir;
+	FILE* pFile;
+	bool bWritten = true;
+	int iFile;
+
+
+	// Create parent directory if required
+	if (!std::filesystem::exists(ptDirPath))
+		if (!std::filesystem::create_directories(ptDirPath, errCreateDir))
+			return false;
+
+	// Try to open temporary file
+	if ((pFile = fopen(strTmpPath.c_str(), "w")) == NULL)
+		return false;
+
+	// Write entries
+	for (std::unordered_map<std::string, SJournalEntry>::iterator iEntry = m_mapEntries.begin(); ((iEntry != m_mapEntries.end()) && (bWritten)); iEntry++)
+		bWritten = (fprintf(pFile, "W\t%s\t%u\t%s\t%lld\n", iEntry->first.c_str(), iEntry->second.iTTL, iEntry->second.strValue.c_str(), (long long)iEntry->second.tDesired) > 0);
+
+	// Flush file to disk, replace journal file and open it for appending
+	bWritten = ((bWritten) && (fflush(pFile) == 0) && (fsync(fileno(pFile)) == 0));
+	if ((fclose(pFile) != 0) || (!bWritten) || (rename(strTmpPath.c_str(), m_strPath.c_str()) != 0) || ((iFile = ::open(m_strPath.c_str(), (O_WRONLY | O_APPEND | O_CLOEXEC))) == -1))
+	{
+		unlink(strTmpPath.c_str());
+		m_bCompact = true;
+		return false;
+	}
+	if (m_iFile != -1)
+		close(m_iFile);
+	m_iFile = iFile;
+
+	// Success
+	m_strBuffer.clear();
+	m_iLines = m_mapEntries.size();
+	m_bCompact = false;
+	return true;
+
+} // CJournal::compact
+
+
+//
+// CRateLimiter::configure
+//
+// Task: Set the allowed requests per minute and the burst of every API key (0 = only limits reported by the API)
+//
+void CRateLimiter::configure(uint16_t iPerMinute, uint16_t iBurst)
+{
+	// Lock buckets
+	std::lock_guard<std::mutex> lockBuckets(m_mtxBuckets);
+
+
+	// Assign limits and restart learning
+	m_dMaxRate = iPerMinute / 60.0;
+	m_dBurst = std::max<uint16_t>(iBurst, 1);
+	for (std::unordered_map<std::string, SRateBucket>::iterator iBucket = m_mapBuckets.begin(); iBucket != m_mapBuckets.end(); iBucket++)
+		iBucket->second.dRate = m_dMaxRate;
+
+} // CRateLimiter::configure
+
+//
+// CRateLimiter::acquire
+//
+// Task: Wait until a request of the API key is allowed and take its token (fails if canceled)
+//
+bool CRateLimiter::acquire(const std::string& strAPIKey)
+{
+	// Lock buckets
+	std::unique_lock<std::mutex> lockBuckets(m_mtxBuckets);
+
+
+	// Wait for a token (in slices, so an interrupt is noticed)
+	while (!g_sigInterrupt)
+	{
+		// Variables
+		std::chrono::steady_clock::time_point tNow = std::chrono::steady_clock::now(), tReady;
+
+
+		// Take token if available, otherwise wait until the next one is
+		if (take(strAPIKey, tNow, &tReady))
+			return true;
+		m_condBuckets.wait_until(lockBuckets, std::min(tReady, (tNow + std::chrono::milliseconds(RATE_WAIT_SLICE_MS))));
+	}
+
+	// Canceled
+	return false;
+
+} // CRateLimiter::acquire
+
+//
+// CRateLimiter::tryAcquire
+//
+// Task: Take a token of the API key without waiting (the time of the next one is returned if none is left)
+//
+bool CRateLimiter::tryAcquire(const std::string& strAPIKey, std::chrono::steady_clock::time_point* ptReady)
+{
+	// Lock buckets
+	std::lock_guard<std::mutex> lockBuckets(m_mtxBuckets);
+
+
+	// Try to take token
+	return take(strAPIKey, std::chrono::steady_clock::now(), ptReady);
+
+} // CRateLimiter::tryAcquire
+
+//
+// CRateLimiter::update
+//
+// Task: Adapt the bucket of the API key to the answer (rate limit headers, Retry-After and 429)
+//
+void CRateLimiter::update(const std::string& strAPIKey, const SHttpResponse& sResponse)
+{
+	// Lock buckets
+	std::lock_guard<std::mutex> lockBuckets(m_mtxBuckets);
+
+
+	// Variables
+	std::chrono::steady_clock::time_point tNow = std::chrono::steady_clock::now();
+	SRateBucket* psBucket = bucket(strAPIKey, tNow);
+	int64_t iDelayS = RATE_DEF_RETRY_AFTER_S;
+
+
+	// Request is done
+	if (psBucket->iInFlight > 0)
+		psBucket->iInFlight--;
+
+	// Get delay of Retry-After (seconds or HTTP date)
+	if (!sResponse.strRetryAfter.empty())
+		iDelayS = isdigit(sResponse.strRetryAfter[0]) ? atoll(sResponse.strRetryAfter.c_str()) : std::max<int64_t>((curl_getdate(sResponse.strRetryAfter.c_str(), NULL) - time(NULL)), 0);
+
+	// Throttled: stop the key until the delay has passed and halve its rate
+	if ((sResponse.iStatus == 429) || ((sResponse.iStatus == 503) && (!sResponse.strRetryAfter.empty())))
+	{
+		psBucket->tBlocked = std::max(psBucket->tBlocked, (tNow + std::chrono::seconds(iDelayS)));
+		psBucket->dTokens = 0.0;
+		psBucket->dRate = std::max((psBucket->dRate / 2.0), (m_dMaxRate * RATE_MIN_FACTOR));
+		if (sResponse.iStatus == 429)
+			g_cMetrics.iRateLimited++;
+	}
+	// Accepted: slowly raise the rate again
+	else if ((sResponse.iStatus >= 200) && (sResponse.iStatus < 400))
+		psBucket->dRate = std::min((psBucket->dRate + (m_dMaxRate * RATE_INCREASE_FACTOR)), m_dMaxRate);
+
+	// Never use more than the API reports as remaining (waits for the reset of its window if used up)
+	if (!sResponse.strRateRemaining.empty())
+	{
+		// Variables
+		int64_t iLeft = atoll(sResponse.strRateRemaining.c_str()) - psBucket->iInFlight;
+
+
+		// Limit tokens and stop key until the reset (seconds or epoch time)
+		psBucket->dTokens = std::min(psBucket->dTokens, (double)std::max<int64_t>(iLeft, 0));
+		if ((iLeft <= 0) && (!sResponse.strRateReset.empty()))
+		{
+			iDelayS = atoll(sResponse.strRateReset.c_str());
+			if (iDelayS > time(NULL))
+				iDelayS -= time(NULL);
+			psBucket->tBlocked = std::max(psBucket->tBlocked, (tNow + std::chrono::seconds(std::max<int64_t>(iDelayS, 1))));
+		}
+	}
+
+	// Wake waiting workers
+	m_condBuckets.notify_all();
+
+} // CRateLimiter::update
+
+//
+// CRateLimiter::budget
+//
+// Task: Get the amount of requests the API key may send now and the time the next one is allowed
+//
+size_t CRateLimiter::budget(const std::string& strAPIKey, std::chrono::steady_clock::time_point* ptReady)
+{
+	// Lock buckets
+	std::lock_guard<std::mutex> lockBuckets(m_mtxBuckets);
+
+
+	// Variables
+	std::chrono::steady_clock::time_point tNow = std::chrono::steady_clock::now();
+	SRateBucket* psBucket = bucket(strAPIKey, tNow);
+
+
+	// Stopped by the API
+	*ptReady = tNow;
+	if (tNow < psBucket->tBlocked)
+	{
+		*ptReady = psBucket->tBlocked;
+		return 0;
+	}
+
+	// No own limit
+	if (m_dMaxRate == 0)
+		return SIZE_MAX;
+
+	// Available tokens (time of the next one if none is left)
+	if (psBucket->dTokens < 1.0)
+		*ptReady = tNow + std::chrono::microseconds((int64_t)((1.0 - psBucket->dTokens) * 1000000.0 / std::max(psBucket->dRate, 0.001)));
+	return (size_t)psBucket->dTokens;
+
+} // CRateLimiter::budget
+
+//
+// CRateLimiter::bucket
+//
+// Task: Get the refilled bucket of an API key (created with a full burst)
+//
+SRateBucket* CRateLimiter::bucket(const std::string& strAPIKey, std::chrono::steady_clock::time_point tNow)
+{
+	// Variables
+	std::unordered_map<std::string, SRateBucket>::iterator iBucket = m_mapBuckets.find(strAPIKey);
+
+
+	// Create bucket if missing
+	if (iBucket == m_mapBuckets.end())
+	{
+		iBucket = m_mapBuckets.emplace(strAPIKey, SRateBucket()).first;
+		iBucket->second.dTokens = m_dBurst;
+		iBucket->second.dRate = m_dMaxRate;
+		iBucket->second.tRefill = tNow;
+		iBucket->second.tBlocked = tNow;
+		iBucket->second.iInFlight = 0;
+	}
+
+	// Refill tokens
+	iBucket->second.dTokens = std::min(m_dBurst, (iBucket->second.dTokens + (iBucket->second.dRate * std::chrono::duration<double>(tNow - iBucket->second.tRefill).count())));
+	iBucket->second.tRefill = tNow;
+	return &iBucket->second;
+
+} // CRateLimiter::bucket
+
+//
+// CRateLimiter::take
+//
+// Task: Take a token of the API key if one is available (buckets have to be locked)
+//
+bool CRateLimiter::take(const std::string& strAPIKey, std::chrono::steady_clock::time_point tNow, std::chrono::steady_clock::time_point* ptReady)
+{
+	// Variables
+	SRateBucket* psBucket = bucket(strAPIKey, tNow);
+
+
+	// Take token if available
+	if ((tNow >= psBucket->tBlocked) && ((m_dMaxRate == 0) || (psBucket->dTokens >= 1.0)))
+	{
+		if (m_dMaxRate != 0)
+			psBucket->dTokens -= 1.0;
+		psBucket->iInFlight++;
+		return true;
+	}
+
+	// Time of the next token (only the block if the rate is not limited)
+	if (m_dMaxRate == 0)
+		*ptReady = psBucket->tBlocked;
+	else
+		*ptReady = std::max(psBucket->tBlocked, (tNow + std::chrono::microseconds((int64_t)(std::max(0.0, (1.0 - psBucket->dTokens)) * 1000000.0 / std::max(psBucket->dRate, 0.001)))));
+	return false;
+
+} // CRateLimiter::take
+
+//
+// CRetryScheduler::schedule
+//
+// Task: Schedule the next attempt of an rrset (jittered exponential backoff depending on the amount of failed attempts)
+//
+std::chrono::steady_clock::time_point CRetryScheduler::schedule(SDomRecords* psDomRecords, const std::string& strRRSet, uint16_t iAttempts, std::chrono::steady_clock::time_point tNow)
+{
+	// Variables
+	SRetryEntry sEntry;
+	uint64_t iDelayMs = 0;
+
+
+	// Calculate delay (between half and full backoff)
+	if (iAttempts > 0)
+	{
+		iDelayMs = std::min<uint64_t>(((uint64_t)m_iBaseS * 1000) << std::min<uint16_t>((iAttempts - 1), 20), ((uint64_t)m_iMaxS * 1000));
+		iDelayMs = (iDelayMs / 2) + std::uniform_int_distribution<uint64_t>(0, (iDelayMs / 2))(m_cRandom);
+	}
+
+	// Remember state in record and queue entry
+	sEntry.tDue = tNow + std::chrono::milliseconds(iDelayMs);
+	sEntry.psDomRecords = psDomRecords;
+	sEntry.strRRSet = strRRSet;
+	psDomRecords->mapRetries[strRRSet].iAttempts = iAttempts;
+	psDomRecords->mapRetries[strRRSet].tNextAttempt = sEntry.tDue;
+	m_queEntries.push(sEntry);
+
+	// Return time of next attempt
+	return sEntry.tDue;
+
+} // CRetryScheduler::schedule
+
+//
+// CRetryScheduler::defer
+//
+// Task: Move the next attempt of an rrset to the given time (without counting a failed attempt)
+//
+std::chrono::steady_clock::time_point CRetryScheduler::defer(SDomRecords* psDomRecords, const std::string& strRRSet, std::chrono::steady_clock::time_point tDue)
+{
+	// Variables
+	SRetryEntry sEntry;
+
+
+	// Remember state in record and queue entry
+	sEntry.tDue = tDue;
+	sEntry.psDomRecords = psDomRecords;
+	sEntry.strRRSet = strRRSet;
+	psDomRecords->mapRetries[strRRSet].tNextAttempt = tDue;
+	m_queEntries.push(sEntry);
+
+	// Return time of next attempt
+	return tDue;
+
+} // CRetryScheduler::defer
+
+//
+// CRetryScheduler::popDue
+//
+// Task: Take all due rrsets from the queue (grouped by record, outdated entries are dropped)
+//
+std::map<SDomRecords*, std::set<std::string>> CRetryScheduler::popDue(std::chrono::steady_clock::time_point tNow)
+{
+	// Variables
+	std::map<SDomRecords*, std::set<std::string>> mapResult;
+
+
+	// Run through due entries
+	while ((!m_queEntries.empty()) && (m_queEntries.top().tDue <= tNow))
+	{
+		// Variables
+		const SRetryEntry& sEntry = m_queEntries.top();
+		std::map<std::string, SRetryState>::iterator iRetry = sEntry.psDomRecords->mapRetries.find(sEntry.strRRSet);
+
+
+		// Add entry if it is still the current attempt of a pending rrset
+		if ((sEntry.psDomRecords->setPending.count(sEntry.strRRSet) != 0) && (iRetry != sEntry.psDomRecords->mapRetries.end()) && (iRetry->second.tNextAttempt == sEntry.tDue))
+			mapResult[sEntry.psDomRecords].insert(sEntry.strRRSet);
+
+		// Remove entry
+		m_queEntries.pop();
+	}
+
+	// Return result
+	return mapResult;
+
+} // CRetryScheduler::popDue
+
+//
+// CRetryScheduler::nextDue
+//
+// Task: Get the time of the next queued attempt
+//
+bool CRetryScheduler::nextDue(std::chrono::steady_clock::time_point* ptNext)
+{
+	// Check if queue is empty
+	if (m_queEntries.empty())
+		return false;
+
+	// Return time of first entry
+	*ptNext = m_queEntries.top().tDue;
+	return true;
+
+} // CRetryScheduler::nextDue
+
+//
+// CRetryScheduler::remove
+//
+// Task: Remove all entries of a record (before it is deleted)
+//
+void CRetryScheduler::remove(const SDomRecords* psDomRecords)
+{
+	// Variables
+	std::vector<SRetryEntry> vecEntries;
+
+
+	// Keep entries of other records and rebuild heap
+	while (!m_queEntries.empty())
+	{
+		if (m_queEntries.top().psDomRecords != psDomRecords)
+			vecEntries.push_back(m_queEntries.top());
+		m_queEntries.pop();
+	}
+	for (size_t i = 0; i < vecEntries.size(); i++)
+		m_queEntries.push(vecEntries[i]);
+
+} // CRetryScheduler::remove
+
+//
+// CPollScheduler::changed
+//
+// Task: Remember a change of the address of a family (0 = IPv4, 1 = IPv6)
+//
+void CPollScheduler::changed(uint8_t iFamily, time_t tNow)
+{
+	// Add change and drop the oldest ones
+	m_deqChanges[iFamily].push_back(tNow);
+	while (m_deqChanges[iFamily].size() > POLL_HISTORY_SIZE)
+		m_deqChanges[iFamily].pop_front();
+	m_bDirty = true;
+
+} // CPollScheduler::changed
+
+//
+// CPollScheduler::next
+//
+// Task: Choose the interval until the next poll from the history of both families (kept within the bounds)
+//
+uint32_t CPollScheduler::next(time_t tNow)
+{
+	// Variables
+	time_t tLast = m_tStart;
+	uint64_t iSteps;
+	uint32_t iIntervalS;
+
+
+	// Fixed interval if disabled (a failed check is still retried soon)
+	if (!m_bAdaptive)
+	{
+		m_cReason = (m_iFailures > 0) ? "failure" : "fixed";
+		return (m_iIntervalS = retryInterval(m_iBaseS));
+	}
+
+	// Back off while the address is stable (doubled for every step without a change since the last one or the start)
+	for (uint8_t iFamily = 0; iFamily < 2; iFamily++)
+		if (!m_deqChanges[iFamily].empty())
+			tLast = std::max(tLast, m_deqChanges[iFamily].back());
+	iSteps = std::max<time_t>((tNow - tLast), 0) / POLL_STABLE_STEP_S;
+	iIntervalS = (uint32_t)std::min<uint64_t>(((uint64_t)m_iBaseS << std::min<uint64_t>(iSteps, 16)), UINT32_MAX);
+	m_cReason = (iSteps > 0) ? "stable" : "default";
+
+	// Poll again soon after failures
+	if (m_iFailures > 0)
+	{
+		iIntervalS = retryInterval(std::min<uint32_t>(m_iBaseS, iIntervalS));
+		m_cReason = "failure";
+	}
+
+	// Poll more often around changes that are expected by the history of each family
+	for (uint8_t iFamily = 0; iFamily < 2; iFamily++)
+		iIntervalS = familyInterval(m_deqChanges[iFamily], tNow, iIntervalS);
+
+	// Keep interval within bounds
+	m_iIntervalS = std::clamp<uint32_t>(iIntervalS, m_iMinS, std::max(m_iMinS, m_iMaxS));
+	return m_iIntervalS;
+
+} // CPollScheduler::next
+
+//
+// CPollScheduler::retryInterval
+//
+// Task: Choose the interval after failed checks (doubled with every further failure up to the given interval)
+//
+uint32_t CPollScheduler::retryInterval(uint32_t iIntervalS) const
+{
+	// Keep interval if the last check succeeded
+	if (m_iFailures == 0)
+		return iIntervalS;
+
+	return (uint32_t)std::min<uint64_t>(((uint64_t)m_iRetryS << std::min<uint32_t>((m_iFailures - 1), 16)), iIntervalS);
+
+} // CPollScheduler::retryInterval
+
+//
+// CPollScheduler::familyInterval
+//
+// Task: Shorten an interval if the changes of a family flap or are expected soon (lease period or hour of the day)
+//
+uint32_t CPollScheduler::familyInterval(const std::deque<time_t>& deqChanges, time_t tNow, uint32_t iIntervalS)
+{
+	// Variables
+	std::vector<time_t> vecPeriods, vecDeviations;
+	uint32_t iHours[24] = {};
+	size_t iRecent = 0;
+	time_t tPeriod, tDeviation, tTolerance, tNext;
+	struct tm sTime;
+
+
+	// Poll as often as allowed while the address flaps
+	for (size_t i = 0; i < deqChanges.size(); i++)
+		if ((tNow - deqChanges[i]) <= POLL_FLAP_WINDOW_S)
+			iRecent++;
+	if (iRecent >= POLL_FLAP_CHANGES)
+	{
+		m_cReason = "flapping";
+		return m_iMinS;
+	}
+
+	// Get lease period from the time between changes (flaps are skipped)
+	for (size_t i = 1; i < deqChanges.size(); i++)
+		if ((deqChanges[i] - deqChanges[i - 1]) >= POLL_FLAP_WINDOW_S)
+			vecPeriods.push_back(deqChanges[i] - deqChanges[i - 1]);
+
+	// Poll around the next expected change if the period is regular (expected changes may have kept the address)
+	if (vecPeriods.size() >= POLL_MIN_PERIODS)
+	{
+		tPeriod = median(vecPeriods);
+		for (size_t i = 0; i < vecPeriods.size(); i++)
+			vecDeviations.push_back(std::abs(vecPeriods[i] - tPeriod));
+		tDeviation = median(vecDeviations);
+		if ((tDeviation * 4) <= tPeriod)
+		{
+			// Get next expected change
+			tTolerance = std::max<time_t>(POLL_WINDOW_MIN_S, (2 * tDeviation));
+			tNext = deqChanges.back() + tPeriod;
+			if (tNow > (tNext + tTolerance))
+				tNext += (((tNow - tNext - tTolerance) / tPeriod) + 1) * tPeriod;
+
+			// Poll often within the window, wake up at its start otherwise
+			if (tNow >= (tNext - tTolerance))
+			{
+				m_cReason = "lease window";
+				return m_iMinS;
+			}
+			if ((tNext - tTolerance - tNow) < (time_t)iIntervalS)
+			{
+				iIntervalS = (uint32_t)(tNext - tTolerance - tNow);
+				m_cReason = "lease window";
+			}
+		}
+	}
+
+	// Count changes by hour of the day
+	for (size_t i = 0; i < deqChanges.size(); i++)
+		if (localtime_r(&deqChanges[i], &sTime) != NULL)
+			iHours[sTime.tm_hour]++;
+
+	// Poll often within the next hour that has many of the changes, wake up at its start otherwise
+	if (localtime_r(&tNow, &sTime) == NULL)
+		return iIntervalS;
+	for (int iAhead = 0; iAhead < 24; iAhead++)
+	{
+		// Variables
+		int iHour = (sTime.tm_hour + iAhead) % 24;
+
+
+		// Skip quiet hours
+		if ((iHours[iHour] < POLL_HOUR_MIN_CHANGES) || ((iHours[iHour] * 4) < deqChanges.size()))
+			continue;
+
+		// Check window
+		if (iAhead == 0)
+		{
+			m_cReason = "daily window";
+			return m_iMinS;
+		}
+		if (((iAhead * 3600) - (sTime.tm_min * 60) - sTime.tm_sec) < (int64_t)iIntervalS)
+		{
+			iIntervalS = (iAhead * 3600) - (sTime.tm_min * 60) - sTime.tm_sec;
+			m_cReason = "daily window";
+		}
+		break;
+	}
+
+	// Return interval
+	return iIntervalS;
+
+} // CPollScheduler::familyInterval
+
+//
+// CPollScheduler::median
+//
+// Task: Get the median of a list of durations
+//
+time_t CPollScheduler::median(std::vector<time_t> vecValues)
+{
+	// Check if empty
+	if (vecValues.empty())
+		return 0;
+
+	// Get middle value
+	std::nth_element(vecValues.begin(), (vecValues.begin() + (vecValues.size() / 2)), vecValues.end());
+	return vecValues[vecValues.size() / 2];
+
+} // CPollScheduler::median
+
+//
+// CPollScheduler::load
+//
+// Task: Read the address changes from the history file
+//
+bool CPollScheduler::load(const char* cPath)
+{
+	// Variables
+	std::ifstream cHistoryFile(cPath);
+	std::string strCurLine;
+
+
+	// Check if failed
+	if (cHistoryFile.fail())
+		return false;
+
+	// Run through file (type and time separated by a tab, oldest first)
+	while (std::getline(cHistoryFile, strCurLine))
+	{
+		// Variables
+		size_t iSepPos = strCurLine.find('\t');
+
+
+		// Skip invalid lines
+		if ((iSepPos == std::string::npos) || ((strCurLine.compare(0, iSepPos, "A") != 0) && (strCurLine.compare(0, iSepPos, "AAAA") != 0)))
+			continue;
+
+		// Add change
+		changed(((iSepPos == 1) ? 0 : 1), atoll(strCurLine.c_str() + iSepPos + 1));
+	}
+
+	// Success
+	m_bDirty = false;
+	return true;
+
+} // CPollScheduler::load
+
+//
+// CPollScheduler::save
+//
+// Task: Write the address changes atomically to the history file if they have changed
+//
+bool CPollScheduler::save(const char* cPath)
+{
+	// Variables
+	std::filesystem::path ptDirPath = std::filesystem::path(cPath).parent_path();
+	std::string strTmpPath = std::string(cPath) + ".tmp";
+	std::error_code errCreateDir;
+	FILE* pFile;
+	bool bWritten = true;
+
+
+	// Nothing to do if unchanged
+	if (!m_bDirty)
+		return true;
+
+	// Create parent directory if required
+	if (!std::filesystem::exists(ptDirPath))
+		if (!std::filesystem::create_directories(ptDirPath, errCreateDir))
+			return false;
+
+	// Try to open temporary file
+	if ((pFile = fopen(strTmpPath.c_str(), "w")) == NULL)
+		return false;
+
+	// Write changes
+	for (uint8_t iFamily = 0; iFamily < 2; iFamily++)
+		for (size_t i = 0; ((i < m_deqChanges[iFamily].size()) && (bWritten)); i++)
+			bWritten = (fprintf(pFile, "%s\t%lld\n", (iFamily ? "AAAA" : "A"), (long long)m_deqChanges[iFamily][i]) > 0);
+
+	// Flush file to disk and replace history file
+	bWritten = ((bWritten) && (fflush(pFile) == 0) && (fsync(fileno(pFile)) == 0));
+	if ((fclose(pFile) != 0) || (!bWritten) || (rename(strTmpPath.c_str(), cPath) != 0))
+	{
+		unlink(strTmpPath.c_str());
+		return false;
+	}
+
+	// Success
+	m_bDirty = false;
+	return true;
+
+} // CPollScheduler::save
+
+//
+// CCluster::start
+//
+// Task: Join the cluster by writing the lease of this node to the shared directory (the node takes over records only after a full lease period)
+//
+bool CCluster::start(const std::string& strDir, const std::string& strNode, uint16_t iLeaseS, std::string* pstrErrorMsg)
+{
+	// Variables
+	std::ifstream cLeaseFile;
+	struct itimerspec sTimerSpec = {};
+	std::error_code errCreateDir;
+	char cHostName[SMALL_BUFFER] = {};
+	long long iJoined = 0, iExpiry = 0;
+	uint32_t iRenewMs;
+
+
+	// Use host name if no node name is given (only characters that are valid in file names)
+	m_strNode = strNode;
+	if ((m_strNode.empty()) && (gethostname(cHostName, (sizeof(cHostName) - 1)) == 0))
+		m_strNode = cHostName;
+	for (size_t i = 0; i < m_strNode.length(); i++)
+		if ((!isalnum((unsigned char)m_strNode[i])) && (m_strNode[i] != '-') && (m_strNode[i] != '_') && (m_strNode[i] != '.'))
+			m_strNode[i] = '_';
+	if ((m_strNode.empty()) || (m_strNode[0] == '.'))
+	{
+		*pstrErrorMsg = "Invalid node name";
+		return false;
+	}
+
+	// Create shared directory if required
+	m_strDir = strDir;
+	m_strPath = m_strDir + "/" + m_strNode + CLUSTER_LEASE_EXTENSION;
+	m_iLeaseS = std::max<uint16_t>(iLeaseS, 1);
+	if ((!std::filesystem::exists(m_strDir)) && (!std::filesystem::create_directories(m_strDir, errCreateDir)))
+	{
+		*pstrErrorMsg = "Cannot create " + m_strDir + ": " + errCreateDir.message();
+		return false;
+	}
+
+	// Check if the node name is already used by a live node
+	cLeaseFile.open(m_strPath);
+	if ((cLeaseFile >> iJoined >> iExpiry) && (iExpiry >= time(NULL)))
+	{
+		*pstrErrorMsg = "Node '" + m_strNode + "' is already alive (lease expires in " + std::to_string(iExpiry - time(NULL) + 1) + "s)";
+		m_strPath.clear();
+		return false;
+	}
+
+	// Write first lease
+	m_tJoined = time(NULL);
+	if (!renew(m_tJoined))
+	{
+		*pstrErrorMsg = "Cannot write lease " + m_strPath + ": " + std::strerror(errno);
+		return false;
+	}
+	m_tRenewed = m_tJoined;
+
+	// Create timer that renews the lease and scans the other nodes three times per lease period
+	iRenewMs = std::max<uint32_t>(((m_iLeaseS * 1000) / 3), 1);
+	sTimerSpec.it_value.tv_nsec = 1;
+	sTimerSpec.it_interval.tv_sec = iRenewMs / 1000;
+	sTimerSpec.it_interval.tv_nsec = (iRenewMs % 1000) * 1000000L;
+	if (((m_iTimer = timerfd_create(CLOCK_MONOTONIC, (TFD_NONBLOCK | TFD_CLOEXEC))) < 0) || (timerfd_settime(m_iTimer, 0, &sTimerSpec, NULL) != 0))
+	{
+		*pstrErrorMsg = "Cannot create timer: " + std::string(std::strerror(errno));
+		stop();
+		return false;
+	}
+
+	// Success
+	return true;
+
+} // CCluster::start
+
+//
+// CCluster::stop
+//
+// Task: Leave the cluster (the lease is removed, so the other nodes take over right away)
+//
+void CCluster::stop()
+{
+	// Close timer
+	if (m_iTimer >= 0)
+		close(m_iTimer);
+	m_iTimer = -1;
+
+	// Remove lease
+	if (!m_strPath.empty())
+		unlink(m_strPath.c_str());
+	m_strPath.clear();
+	m_vecRing.clear();
+	m_bActive = false;
+
+} // CCluster::stop
+
+//
+// CCluster::process
+//
+// Task: Renew the lease and scan the leases of the other nodes (returns true if the owners have changed)
+//
+bool CCluster::process()
+{
+	// Variables
+	time_t tNow = time(NULL);
+	std::vector<std::string> vecNodes;
+	std::error_code errDir;
+	uint64_t iExpirations;
+	bool bRenewed, bActive;
+
+
+	// Read timer
+	if (read(m_iTimer, &iExpirations, sizeof(iExpirations)) < 0)
+		iExpirations = 0;
+
+	// Renew own lease (a node that cannot renew it stops writing a third of the lease period before the others take over and joins again later)
+	if (((tNow - m_tRenewed) * 3) >= (m_iLeaseS * 2))
+		m_tJoined = tNow;
+	if ((bRenewed = renew(tNow)))
+		m_tRenewed = tNow;
+	bActive = ((tNow >= (m_tJoined + m_iLeaseS)) && (((tNow - m_tRenewed) * 3) < (m_iLeaseS * 2)));
+	if (bActive)
+		vecNodes.push_back(m_strNode);
+
+	// Run through leases of the other nodes (they count once their lease is valid for half a period, before they take over themselves)
+	for (std::filesystem::directory_iterator iEntry(m_strDir, errDir); ((bRenewed) && (!errDir) && (iEntry != std::filesystem::directory_iterator())); iEntry.increment(errDir))
+	{
+		// Variables
+		std::string strName = iEntry->path().filename().string();
+		std::ifstream cLeaseFile;
+		long long iJoined = 0, iExpiry = 0;
+
+
+		// Skip own lease, temporary files and other files
+		if ((strName.empty()) || (strName[0] == '.') || (iEntry->path().extension() != CLUSTER_LEASE_EXTENSION) || (iEntry->path().stem() == m_strNode))
+			continue;
+
+		// Add live node
+		cLeaseFile.open(iEntry->path());
+		if ((cLeaseFile >> iJoined >> iExpiry) && (iExpiry >= tNow) && (((tNow - iJoined) * 2) >= m_iLeaseS))
+			vecNodes.push_back(iEntry->path().stem().string());
+	}
+
+	// Keep the other nodes if the directory cannot be accessed (they may still be alive, this node is fenced soon)
+	if ((!bRenewed) || (errDir))
+	{
+		vecNodes.resize(bActive ? 1 : 0);
+		for (size_t i = 0; i < m_vecNodes.size(); i++)
+			if (m_vecNodes[i] != m_strNode)
+				vecNodes.push_back(m_vecNodes[i]);
+	}
+	std::sort(vecNodes.begin(), vecNodes.end());
+
+	// Check if anything has changed
+	if ((bActive == m_bActive) && (vecNodes == m_vecNodes))
+		return false;
+
+	// Build ring of the live nodes (virtual nodes spread the records evenly)
+	m_bActive = bActive;
+	m_vecNodes = vecNodes;
+	m_vecRing.clear();
+	for (size_t i = 0; i < m_vecNodes.size(); i++)
+		for (uint16_t j = 0; j < CLUSTER_VIRTUAL_NODES; j++)
+			m_vecRing.push_back(std::make_pair(hash(m_vecNodes[i] + "#" + std::to_string(j)), i));
+	std::sort(m_vecRing.begin(), m_vecRing.end());
+
+	// Cancel writes of updates that have been queued with the old owners
+	m_iGeneration++;
+	return true;
+
+} // CCluster::process
+
+//
+// CCluster::owner
+//
+// Task: Get the live node that owns a subdomain of a domain (NULL if there is none)
+//
+const std::string* CCluster::owner(const std::string& strDomain, const std::string& strSubDomain) const
+{
+	// Variables
+	std::vector<std::pair<uint64_t, size_t>>::const_iterator iPoint;
+
+
+	// Check if there is any node
+	if (m_vecRing.empty())
+		return NULL;
+
+	// Get next point of the ring (wrapping around)
+	iPoint = std::lower_bound(m_vecRing.begin(), m_vecRing.end(), std::make_pair(hash(strDomain + "/" + strSubDomain), (size_t)0));
+	if (iPoint == m_vecRing.end())
+		iPoint = m_vecRing.begin();
+	return &m_vecNodes[iPoint->second];
+
+} // CCluster::owner
+
+//
+// CCluster::owns
+//
+// Task: Check if this node writes a subdomain of a domain (always if the cluster is disabled)
+//
+bool CCluster::owns(const std::string& strDomain, const std::string& strSubDomain) const
+{
+	// Variables
+	const std::string* pstrOwner;
+
+
+	// Check if disabled or not active
+	if (!enabled())
+		return true;
+	if (!m_bActive)
+		return false;
+
+	// Compare owner
+	pstrOwner = owner(strDomain, strSubDomain);
+	return ((pstrOwner != NULL) && (*pstrOwner == m_strNode));
+
+} // CCluster::owns
+
+//
+// CCluster::state
+//
+// Task: Get the state of this node for printing
+//
+const char* CCluster::state() const
+{
+	// Check state
+	if (m_bActive)
+		return "active";
+	return (((time(NULL) - m_tRenewed) * 3) >= (m_iLeaseS * 2)) ? "fenced" : "joining";
+
+} // CCluster::state
+
+//
+// CCluster::renew
+//
+// Task: Write the lease of this node atomically (time of joining and expiry)
+//
+bool CCluster::renew(time_t tNow)
+{
+	// Variables
+	std::string strTmpPath = m_strDir + "/." + m_strNode + CLUSTER_LEASE_EXTENSION + ".tmp";
+	FILE* pFile;
+	bool bWritten;
+
+
+	// Try to open temporary file
+	if ((pFile = fopen(strTmpPath.c_str(), "w")) == NULL)
+		return false;
+
+	// Write lease and replace the old one
+	bWritten = (fprintf(pFile, "%lld\t%lld\n", (long long)m_tJoined, (long long)(tNow + m_iLeaseS)) > 0);
+	if ((fclose(pFile) != 0) || (!bWritten) || (rename(strTmpPath.c_str(), m_strPath.c_str()) != 0))
+	{
+		unlink(strTmpPath.c_str());
+		return false;
+	}
+
+	// Success
+	return true;
+
+} // CCluster::renew
+
+//
+// CCluster::hash
+//
+// Task: Hash a string onto the ring (FNV-1a, mixed so that similar names are spread)
+//
+uint64_t CCluster::hash(const std::string& strValue)
+{
+	// Variables
+	uint64_t iHash = 14695981039346656037ULL;
+
+
+	// Hash characters
+	for (size_t i = 0; i < strValue.length(); i++)
+		iHash = (iHash ^ (unsigned char)strValue[i]) * 1099511628211ULL;
+
+	// Mix bits
+	iHash ^= iHash >> 33;
+	iHash *= 0xff51afd7ed558ccdULL;
+	iHash ^= iHash >> 33;
+	return iHash;
+
+} // CCluster::hash
+
+
+//
+// CRecordTable::add
+//
+// Task: Add a subdomain to the zone of the given API key and domain (duplicates are ignored)
+//
+bool CRecordTable::add(const std::string& strAPIKey, const std::string& strDomain, const SSubDomain& sSubDomain)
+{
+	// Variables
+	std::string strKey = strDomain + "\t" + sSubDomain.strName;
+	SDomRecords* psDomRecords;
+
+
+	// Check if subdomain is already defined
+	if (m_mapSubDomains.count(strKey) != 0)
+	{
+		m_iDuplicates++;
+		return false;
+	}
+
+	// Get zone or create it
+	if ((psDomRecords = m_mapDomains[strAPIKey + "\t" + strDomain]) == NULL)
+	{
+		psDomRecords = &(*m_lstRecords.emplace(m_lstRecords.end()));
+		psDomRecords->strAPIKey = strAPIKey;
+		psDomRecords->strDomain = strDomain;
+		m_mapDomains[strAPIKey + "\t" + strDomain] = psDomRecords;
+		countZone(strDomain, 1);
+	}
+
+	// Add subdomain and index it
+	psDomRecords->lstSubDomains.push_back(sSubDomain);
+	m_mapSubDomains[strKey] = &psDomRecords->lstSubDomains.back();
+	return true;
+
+} // CRecordTable::add
+
+//
+// CRecordTable::countZone
+//
+// Task: Count the zones of a domain and mark them if the domain is used with several API keys (their batches would replace each other's rrsets)
+//
+void CRecordTable::countZone(const std::string& strDomain, int iDelta)
+{
+	// Variables
+	size_t iZones = (m_mapZones[strDomain] += iDelta);
+
+
+	// Forget domain if it has no zone anymore
+	if (iZones == 0)
+		m_mapZones.erase(strDomain);
+
+	// Update zones only if the domain just became shared or not shared anymore
+	if (iZones != ((iDelta > 0) ? 2 : 1))
+		return;
+	m_iShared += ((iDelta > 0) ? 1 : -1);
+	for (std::list<SDomRecords>::iterator iRec = m_lstRecords.begin(); iRec != m_lstRecords.end(); iRec++)
+		if (iRec->strDomain == strDomain)
+			iRec->bShared = (iZones > 1);
+
+} // CRecordTable::countZone
+
+//
+// CRecordTable::find
+//
+// Task: Find a subdomain by domain and name
+//
+SSubDomain* CRecordTable::find(const std::string& strDomain, const std::string& strSubDomain)
+{
+	// Variables
+	std::unordered_map<std::string, SSubDomain*>::iterator iSubDomain = m_mapSubDomains.find(strDomain + "\t" + strSubDomain);
+
+
+	// Return subdomain if found
+	return ((iSubDomain != m_mapSubDomains.end()) ? iSubDomain->second : NULL);
+
+} // CRecordTable::find
+
+//
+// CRecordTable::findZone
+//
+// Task: Find the zone of a domain (the first one if it is used with several API keys)
+//
+SDomRecords* CRecordTable::findZone(const std::string& strDomain)
+{
+	// Run through zones
+	for (std::list<SDomRecords>::iterator iRec = m_lstRecords.begin(); iRec != m_lstRecords.end(); iRec++)
+		if (iRec->strDomain == strDomain)
+			return &(*iRec);
+
+	// Not found
+	return NULL;
+
+} // CRecordTable::findZone
+
+//
+// CRecordTable::remove
+//
+// Task: Remove a subdomain and its zone if it became empty (fnRemove is called before the zone is deleted)
+//
+bool CRecordTable::remove(const std::string& strDomain, const std::string& strSubDomain, std::function<void(SDomRecords*)> fnRemove)
+{
+	// Check if subdomain exists
+	if (m_mapSubDomains.erase(strDomain + "\t" + strSubDomain) == 0)
+		return false;
+
+	// Run through zones of the domain
+	for (std::list<SDomRecords>::iterator iRec = m_lstRecords.begin(); iRec != m_lstRecords.end(); iRec++)
+	{
+		// Variables
+		std::list<SSubDomain>::iterator iSDom;
+
+
+		// Find subdomain
+		if (iRec->strDomain != strDomain)
+			continue;
+		for (iSDom = iRec->lstSubDomains.begin(); ((iSDom != iRec->lstSubDomains.end()) && (iSDom->strName != strSubDomain)); iSDom++);
+		if (iSDom == iRec->lstSubDomains.end())
+			continue;
+
+		// Forget state of its rrsets and remove it
+		for (const char* cType : { "A", "AAAA" })
+		{
+			iRec->setPending.erase(strSubDomain + "\t" + cType);
+			iRec->mapRetries.erase(strSubDomain + "\t" + cType);
+			iRec->mapFailed.erase(strSubDomain + "\t" + cType);
+		}
+		iRec->lstSubDomains.erase(iSDom);
+
+		// Remove zone if empty
+		if (iRec->lstSubDomains.empty())
+		{
+			fnRemove(&(*iRec));
+			m_mapDomains.erase(iRec->strAPIKey + "\t" + iRec->strDomain);
+			m_lstRecords.erase(iRec);
+			countZone(strDomain, -1);
+		}
+		break;
+	}
+
+	// Success
+	return true;
+
+} // CRecordTable::remove
+
+//
+// CRecordTable::parseSubDomain
+//
+// Task: Parse the options of a record line (<domain> <subdomain> [TTL] [ipv4|ipv6|both])
+//
+bool CRecordTable::parseSubDomain(const std::vector<std::string>& vecFields, SSubDomain* psSubDomain, std::string* pstrErrorMsg)
+{
+	// Run through options
+	psSubDomain->strName = vecFields[1];
+	for (size_t i = 2; i < vecFields.size(); i++)
+	{
+		// TTL
+		if (isdigit(vecFields[i][0]))
+		{
+			if ((psSubDomain->iTTL = std::clamp(atoi(vecFields[i].c_str()), 0, 65535)) == 0)
+			{
+				*pstrErrorMsg = "Invalid TTL";
+				return false;
+			}
+		}
+		// Families
+		else if ((strcasecmp(vecFields[i].c_str(), "ipv4") == 0) || (strcasecmp(vecFields[i].c_str(), "ipv6") == 0) || (strcasecmp(vecFields[i].c_str(), "both") == 0))
+		{
+			psSubDomain->bIPv4 = (strcasecmp(vecFields[i].c_str(), "ipv6") != 0);
+			psSubDomain->bIPv6 = (strcasecmp(vecFields[i].c_str(), "ipv4") != 0);
+		}
+		// Error
+		else
+		{
+			*pstrErrorMsg = "Unknown option \'" + vecFields[i] + "\'";
+			return false;
+		}
+	}
+
+	// Success
+	return true;
+
+} // CRecordTable::parseSubDomain
+
+//
+// CRecordTable::loadDirectory
+//
+// Task: Load all records files of a directory (in alphabetical order, a missing directory is no error)
+//
+uint8_t CRecordTable::loadDirectory(const char* cPath, std::string* pstrErrorMsg)
+{
+	// Variables
+	std::error_code cError;
+	std::vector<std::string> vecFiles;
+	uint8_t iResult;
+
+
+	// Check if directory exists
+	if (!std::filesystem::is_directory(cPath, cError))
+		return REC_ERR_NONE;
+
+	// Collect records files
+	for (std::filesystem::directory_iterator iEntry(cPath, cError), iEnd; ((!cError) && (iEntry != iEnd)); iEntry.increment(cError))
+		if ((iEntry->is_regular_file(cError)) && (iEntry->path().extension() == REC_FILE_EXTENSION))
+			vecFiles.push_back(iEntry->path().string());
+
+	// Check if directory could not be read
+	if (cError)
+	{
+		*pstrErrorMsg = std::string(cPath) + ": " + cError.message();
+		return REC_ERR_FILE;
+	}
+
+	// Load files
+	std::sort(vecFiles.begin(), vecFiles.end());
+	for (size_t i = 0; i < vecFiles.size(); i++)
+		if ((iResult = loadFile(vecFiles[i], pstrErrorMsg)) != REC_ERR_NONE)
+			return iResult;
+
+	// Success
+	return REC_ERR_NONE;
+
+} // CRecordTable::loadDirectory
+
+//
+// CRecordTable::loadFile
+//
+// Task: Load a records file ("APIKey=<key>" followed by lines of "<domain> <subdomain> [TTL] [ipv4|ipv6|both]")
+//
+uint8_t CRecordTable::loadFile(const std::string& strPath, std::string* pstrErrorMsg)
+{
+	// Variables
+	std::ifstream cFile(strPath);
+	std::string strCurLine, strAPIKey;
+	size_t iLine = 0;
+
+
+	// Check if file could be opened
+	if (!cFile.is_open())
+	{
+		*pstrErrorMsg = strPath + ": " + std::strerror(errno);
+		return REC_ERR_FILE;
+	}
+
+	// Run through lines
+	while (std::getline(cFile, strCurLine))
+	{
+		// Variables
+		std::vector<std::string> vecFields;
+		SSubDomain sSubDomain;
+
+
+		// Split line into fields and skip empty lines and comments
+		iLine++;
+		std::replace(strCurLine.begin(), strCurLine.end(), '\t', ' ');
+		std::replace(strCurLine.begin(), strCurLine.end(), '\r', ' ');
+		vecFields = splitList(strCurLine, ' ');
+		if ((vecFields.empty()) || (vecFields[0][0] == '#'))
+			continue;
+
+		// API key for the following records
+		if ((vecFields.size() == 1) && (strcasecmp(vecFields[0].substr(0, 7).c_str(), "apikey=") == 0))
+		{
+			strAPIKey = vecFields[0].substr(7);
+			continue;
+		}
+
+		// Check if record is complete
+		if ((vecFields.size() < 2) || (strAPIKey.length() == 0))
+		{
+			*pstrErrorMsg = strPath + ":" + std::to_string(iLine) + ((strAPIKey.length() == 0) ? ": No API key specified" : ": Missing subdomain");
+			return REC_ERR_SYNTAX;
+		}
+
+		// Parse options and add record
+		if (!parseSubDomain(vecFields, &sSubDomain, pstrErrorMsg))
+		{
+			*pstrErrorMsg = strPath + ":" + std::to_string(iLine) + ": " + *pstrErrorMsg;
+			return REC_ERR_SYNTAX;
+		}
+		add(strAPIKey, vecFields[0], sSubDomain);
+	}
+
+	// Success
+	return REC_ERR_NONE;
+
+} // CRecordTable::loadFile
+
+//
+// CRecordTable::applyDefaultTTL
+//
+// Task: Assign the given TTL to all subdomains without their own one
+//
+void CRecordTable::applyDefaultTTL(uint16_t iTTL)
+{
+	// Run through zones and their subdomains
+	for (std::list<SDomRecords>::iterator iRec = m_lstRecords.begin(); iRec != m_lstRecords.end(); iRec++)
+		for (std::list<SSubDomain>::iterator iSDom = iRec->lstSubDomains.begin(); iSDom != iRec->lstSubDomains.end(); iSDom++)
+			if (iSDom->iTTL == 0)
+				iSDom->iTTL = iTTL;
+
+} // CRecordTable::applyDefaultTTL
+
+//
+// CRecordTable::merge
+//
+// Task: Take over the records of a newly loaded table while keeping the state of unchanged ones, returns the added or changed subdomains per zone
+//
+std::map<SDomRecords*, std::set<std::string>> CRecordTable::merge(CRecordTable* pcNew, std::function<void(SDomRecords*)> fnRemove, size_t* piRemoved)
+{
+	// Variables
+	std::map<SDomRecords*, std::set<std::string>> mapChanged;
+
+
+	// Remove zones and subdomains that do not exist anymore
+	*piRemoved = 0;
+	for (std::list<SDomRecords>::iterator iRec = m_lstRecords.begin(); iRec != m_lstRecords.end();)
+	{
+		// Variables
+		std::unordered_map<std::string, SDomRecords*>::iterator iNew = pcNew->m_mapDomains.find(iRec->strAPIKey + "\t" + iRec->strDomain);
+
+
+		// Run through subdomains
+		for (std::list<SSubDomain>::iterator iSDom = iRec->lstSubDomains.begin(); iSDom != iRec->lstSubDomains.end();)
+		{
+			// Keep subdomain if still defined for this zone
+			if ((iNew != pcNew->m_mapDomains.end()) && (pcNew->m_mapSubDomains.count(iRec->strDomain + "\t" + iSDom->strName) != 0))
+			{
+				iSDom++;
+				continue;
+			}
+
+			// Forget state of its rrsets and remove it
+			for (const char* cType : { "A", "AAAA" })
+			{
+				iRec->setPending.erase(iSDom->strName + "\t" + cType);
+				iRec->mapRetries.erase(iSDom->strName + "\t" + cType);
+				iRec->mapFailed.erase(iSDom->strName + "\t" + cType);
+			}
+			m_mapSubDomains.erase(iRec->strDomain + "\t" + iSDom->strName);
+			iSDom = iRec->lstSubDomains.erase(iSDom);
+			(*piRemoved)++;
+		}
+
+		// Keep zone if it still has subdomains
+		if (!iRec->lstSubDomains.empty())
+		{
+			iRec++;
+			continue;
+		}
+
+		// Remove zone
+		fnRemove(&(*iRec));
+		m_mapDomains.erase(iRec->strAPIKey + "\t" + iRec->strDomain);
+		countZone(iRec->strDomain, -1);
+		iRec = m_lstRecords.erase(iRec);
+	}
+
+	// Add new and update changed subdomains (in order of the new table)
+	for (std::list<SDomRecords>::iterator iNew = pcNew->m_lstRecords.begin(); iNew != pcNew->m_lstRecords.end(); iNew++)
+	{
+		for (std::list<SSubDomain>::iterator iSDom = iNew->lstSubDomains.begin(); iSDom != iNew->lstSubDomains.end(); iSDom++)
+		{
+			// Variables
+			SSubDomain* psSubDomain = find(iNew->strDomain, iSDom->strName);
+
+
+			// Add new subdomain
+			if (psSubDomain == NULL)
+			{
+				add(iNew->strAPIKey, iNew->strDomain, *iSDom);
+				mapChanged[m_mapDomains[iNew->strAPIKey + "\t" + iNew->strDomain]].insert(iSDom->strName);
+			}
+			// Update changed subdomain
+			else if ((psSubDomain->iTTL != iSDom->iTTL) || (psSubDomain->bIPv4 != iSDom->bIPv4) || (psSubDomain->bIPv6 != iSDom->bIPv6))
+			{
+				*psSubDomain = *iSDom;
+				mapChanged[m_mapDomains[iNew->strAPIKey + "\t" + iNew->strDomain]].insert(iSDom->strName);
+			}
+		}
+	}
+
+	// Take over amount of duplicates and return result
+	m_iDuplicates = pcNew->m_iDuplicates;
+	return mapChanged;
+
+} // CRecordTable::merge
+
+
+//
+// loadConfig
+//
+// Task: Load the configuration from file
+//
+uint8_t loadConfig(SConfigContents* psConfigContents)
+{
+	// Variables
+	std::string strCurLine, strOrgLine;
+	int iSepPos;
+	uint8_t iAssignedAttr = 0;
+	int8_t iIPv6Check, iLogCheck;
+	std::string strKey, strValue, strRawValue;
+	bool bOptSyntaxError = false;
+
+
+	// Try to open config file
+	std::ifstream cCfgFile(CFG_FILE_PATH);
+
+	// Check if failed
+	if (cCfgFile.fail())
+		return CFG_ERR_FILE;
+
+	// Run trough file
+	while (std::getline(cCfgFile, strCurLine))
+	{
+		// Convert to lower case (the original line is kept for case-sensitive values)
+		strOrgLine = strCurLine;
+		for (size_t i = 0; i < strCurLine.length(); i++)
+			strCurLine[i] = tolower(strCurLine[i]);
+
+		// Try to find separation specifier
+		iSepPos = strCurLine.find('=');
+
+		// Check if current line is an attribute
+		if (iSepPos != std::string::npos)
+		{
+			// Skip spaces from the right side of the specifier
+			for (iSepPos = (iSepPos + 1); ((iSepPos < strCurLine.length()) && ((strCurLine[iSepPos] == ' ') || (strCurLine[iSepPos] == '\"'))); iSepPos++);
+
+			// Remove spaces and quotes from the end of the string
+			for (size_t i = strCurLine.length(); ((i > 0) && ((strCurLine[i - 1] == ' ') || (strCurLine[i - 1] == '"'))); i--)
+				strCurLine.erase(i - 1);
+
+			// Get attribute name
+			strKey = strCurLine.substr(0, strCurLine.find('='));
+			while ((strKey.length() > 0) && (strKey.back() == ' '))
+				strKey.pop_back();
+
+			// Get attribute value (also in its original case)
+			strValue = strCurLine.substr(iSepPos);
+			strRawValue = strOrgLine.substr(iSepPos, strValue.length());
+
+			// Assign optional attribute (not counted)
+			if (assignOptionalAttr(psConfigContents, strKey, strValue, strRawValue, &bOptSyntaxError))
+				continue;
+
+			// Assign attribute
+			if (strCurLine.find("ipservice") != std::string::npos)
+				psConfigContents->strIPService = strCurLine.substr(iSepPos).c_str();
+			else if (strCurLine.find("api") != std::string::npos)
+				psConfigContents->strAPI = strCurLine.substr(iSepPos).c_str();
+			else if (strCurLine.find("successmsg") != std::string::npos)
+				psConfigContents->strSuccessMsg = strCurLine.substr(iSepPos).c_str();
+			else if (strCurLine.find("ttl") != std::string::npos)
+				psConfigContents->iTTL = atoi(strCurLine.substr(iSepPos).c_str()) >= 0 ? atoi(strCurLine.substr(iSepPos).c_str()) : 65535;
+			else if (strCurLine.find("updateperiods") != std::string::npos)
+				psConfigContents->iUpdatePeriodS = atoi(strCurLine.substr(iSepPos).c_str()) >= 0 ? atoi(strCurLine.substr(iSepPos).c_str()) : 65535;
+			else if (strCurLine.find("curltimeout") != std::string::npos)
+				psConfigContents->iCurlTimeout = atoi(strCurLine.substr(iSepPos).c_str()) >= 0 ? atoi(strCurLine.substr(iSepPos).c_str()) : 65535;
+			else if (strCurLine.find("enableipv6") != std::string::npos)
+				psConfigContents->bEnableIPv6 = iIPv6Check = strCurLine.substr(iSepPos).compare("true") != std::string::npos ? true : (strCurLine.substr(iSepPos).compare("false") != std::string::npos ? false : -1);
+			else if (strCurLine.find("logging") != std::string::npos)
+				psConfigContents->bLogging = iLogCheck = strCurLine.substr(iSepPos).compare("true") != std::string::npos ? true : (strCurLine.substr(iSepPos).compare("false") != std::string::npos ? false : -1);
+			// Unknown attribute
+			else
+			{
+				// Close file and return
+				cCfgFile.close();
+				return CFG_ERR_SYNTAX;
+			}
+
+			// Increase counter
+			iAssignedAttr++;
+		}
+	}
+
+	// Close file
+	cCfgFile.close();
+
+	// Check if not all attributte assigned
+	if (iAssignedAttr != CFG_AMOUNT_ATTRIBUTES)
+		return CFG_ERR_ATTR_MISSING;
+
+	// Check for error in Syntax
+	if ((psConfigContents->strIPService.length() == 0) || (psConfigContents->strSuccessMsg.length() == 0) || (psConfigContents->iTTL == 65535) || (psConfigContents->iUpdatePeriodS == 65535) || (iIPv6Check == -1) || (iLogCheck == -1) || (bOptSyntaxError))
+		return CFG_ERR_SYNTAX;
+
+	// Success
+	return CFG_ERR_NONE;
+
+} // loadConfig
+
+//
+// assignOptionalAttr
+//
+// Task: Assign an optional config attribute (strValue is lower case, strRawValue as written for case-sensitive settings), returns false if the attribute is unknown
+//
+bool assignOptionalAttr(SConfigContents* psConfigContents, const std::string& strKey, const std::string& strValue, const std::string& strRawValue, bool* pbSyntaxError)
+{
+	// Assign attribute
+	if (strKey == "maxparallelupdates")
+		*pbSyntaxError |= ((psConfigContents->iMaxParallelUpdates = std::max(atoi(strValue.c_str()), 0)) == 0);
+	else if (strKey == "batchupdates")
+		*pbSyntaxError |= !parseBool(strValue, &psConfigContents->bBatchUpdates);
+	else if (strKey == "netlinkevents")
+		*pbSyntaxError |= !parseBool(strValue, &psConfigContents->bNetlinkEvents);
+	else if (strKey == "ipservicequorum")
+		*pbSyntaxError |= ((psConfigContents->iIPServiceQuorum = std::clamp(atoi(strValue.c_str()), 0, 65535)) == 0);
+	else if (strKey == "readbeforewrite")
+		*pbSyntaxError |= !parseBool(strValue, &psConfigContents->bReadBeforeWrite);
+	else if (strKey == "verifyperiods")
+		psConfigContents->iVerifyPeriodS = std::clamp(atoi(strValue.c_str()), 0, 65535);
+	else if (strKey == "persiststate")
+		*pbSyntaxError |= !parseBool(strValue, &psConfigContents->bPersistState);
+	else if (strKey == "retrybases")
+		*pbSyntaxError |= ((psConfigContents->iRetryBaseS = std::clamp(atoi(strValue.c_str()), 0, 65535)) == 0);
+	else if (strKey == "retrymaxs")
+		*pbSyntaxError |= ((psConfigContents->iRetryMaxS = std::clamp(atoi(strValue.c_str()), 0, 65535)) == 0);
+	else if (strKey == "metricsport")
+		*pbSyntaxError |= ((!isdigit(strValue[0])) || ((psConfigContents->iMetricsPort = std::clamp(atoi(strValue.c_str()), 0, 65535)) != atoi(strValue.c_str())));
+	else if (strKey == "metricsaddress")
+		psConfigContents->strMetricsAddress = strValue;
+	else if (strKey == "logformat")
+		*pbSyntaxError |= (((psConfigContents->bLogJson = (strValue == "json")) == false) && (strValue != "text"));
+	else if (strKey == "logmaxsizekib")
+		psConfigContents->iLogMaxSizeKiB = std::clamp(atoi(strValue.c_str()), 0, 65535);
+	else if (strKey == "logrotatefiles")
+		*pbSyntaxError |= ((psConfigContents->iLogRotateFiles = std::clamp(atoi(strValue.c_str()), 0, 65535)) == 0);
+	else if (strKey == "ipsource")
+	{
+		psConfigContents->strIPSource = strValue;
+		for (const std::string& strSource : splitList(strValue, ','))
+			*pbSyntaxError |= ((strSource != IP_SOURCE_HTTP) && (strSource != IP_SOURCE_INTERFACE));
+		*pbSyntaxError |= splitList(strValue, ',').empty();
+	}
+	else if (strKey == "ipinterfaces")
+		psConfigContents->strIPInterfaces = strRawValue;
+	else if (strKey == "ipexclude")
+	{
+		psConfigContents->iIPExclude = 0;
+		for (const std::string& strRule : splitList(strValue, ','))
+		{
+			if (strRule == "private")
+				psConfigContents->iIPExclude |= IP_EXCLUDE_PRIVATE;
+			else if (strRule == "linklocal")
+				psConfigContents->iIPExclude |= IP_EXCLUDE_LINK_LOCAL;
+			else if (strRule == "ula")
+				psConfigContents->iIPExclude |= IP_EXCLUDE_ULA;
+			else if (strRule == "temporary")
+				psConfigContents->iIPExclude |= IP_EXCLUDE_TEMPORARY;
+			else if (strRule != "none")
+				*pbSyntaxError = true;
+		}
+	}
+	else if (strKey == "ipcrosschecks")
+		psConfigContents->iIPCrossCheckS = std::clamp(atoi(strValue.c_str()), 0, 65535);
+	else if (strKey == "apiratelimit")
+		psConfigContents->iAPIRateLimit = std::clamp(atoi(strValue.c_str()), 0, 65535);
+	else if (strKey == "apiburst")
+		*pbSyntaxError |= ((psConfigContents->iAPIBurst = std::clamp(atoi(strValue.c_str()), 0, 65535)) == 0);
+	else if (strKey == "dnsverify")
+		*pbSyntaxError |= !parseBool(strValue, &psConfigContents->bDNSVerify);
+	else if (strKey == "dnsservers")
+		psConfigContents->strDNSServers = strRawValue;
+	else if (strKey == "dnsverifydelays")
+		psConfigContents->iDNSVerifyDelayS = std::clamp(atoi(strValue.c_str()), 0, 65535);
+	else if (strKey == "dnsverifyattempts")
+		*pbSyntaxError |= ((psConfigContents->iDNSVerifyAttempts = std::clamp(atoi(strValue.c_str()), 0, 65535)) == 0);
+	else if (strKey == "dnstimeoutms")
+		*pbSyntaxError |= ((psConfigContents->iDNSTimeoutMs = std::clamp(atoi(strValue.c_str()), 0, 65535)) == 0);
+	else if (strKey == "httpversion")
+	{
+		if (strValue == "auto")
+			psConfigContents->iHttpVersion = CURL_HTTP_VERSION_2TLS;
+		else if (strValue == "1.1")
+			psConfigContents->iHttpVersion = CURL_HTTP_VERSION_1_1;
+		else if (strValue == "2")
+			psConfigContents->iHttpVersion = CURL_HTTP_VERSION_2_0;
+		else
+			*pbSyntaxError = true;
+	}
+	else if (strKey == "pushport")
+		*pbSyntaxError |= ((!isdigit(strValue[0])) || ((psConfigContents->iPushPort = std::clamp(atoi(strValue.c_str()), 0, 65535)) != atoi(strValue.c_str())));
+	else if (strKey == "pushaddress")
+		psConfigContents->strPushAddress = strValue;
+	else if (strKey == "pushtoken")
+		psConfigContents->strPushToken = strRawValue;
+	else if (strKey == "controlsocket")
+		psConfigContents->strControlSocket = strRawValue;
+	else if (strKey == "watchconfig")
+		*pbSyntaxError |= !parseBool(strValue, &psConfigContents->bWatchConfig);
+	else if (strKey == "safetypolls")
+		*pbSyntaxError |= ((psConfigContents->iSafetyPollS = std::clamp(atoi(strValue.c_str()), 0, 65535)) == 0);
+	else if (strKey == "adaptivepolling")
+		*pbSyntaxError |= !parseBool(strValue, &psConfigContents->bAdaptivePolling);
+	else if (strKey == "pollmins")
+		*pbSyntaxError |= ((psConfigContents->iPollMinS = std::clamp(atoi(strValue.c_str()), 0, 65535)) == 0);
+	else if (strKey == "pollmaxs")
+		*pbSyntaxError |= ((psConfigContents->iPollMaxS = std::clamp(atoi(strValue.c_str()), 0, 65535)) == 0);
+	else if (strKey == "clusterdir")
+		psConfigContents->strClusterDir = strRawValue;
+	else if (strKey == "clusternode")
+		psConfigContents->strClusterNode = strRawValue;
+	else if (strKey == "clusterleases")
+		*pbSyntaxError |= ((psConfigContents->iClusterLeaseS = std::clamp(atoi(strValue.c_str()), 0, 65535)) == 0);
+	// Unknown attribute
+	else
+		return false;
+
+	// Success
+	return true;
+
+} // assignOptionalAttr
+
+//
+// parseBool
+//
+// Task: Parse a boolean config value
+//
+bool parseBool(const std::string& strValue, bool* pbResult)
+{
+	// Check value
+	if (strValue == "true")
+		*pbResult = true;
+	else if (strValue == "false")
+		*pbResult = false;
+	// Syntax error
+	else
+		return false;
+
+	// Success
+	return true;
+
+} // parseBool
+
+//
+// generateConfig
+//
+// Task: Create a new config file with default settings
+//
+bool generateConfig()
+{
+	// Variables
+	std::filesystem::path ptDirPath = std::filesystem::path(CFG_FILE_PATH).parent_path();
+	std::error_code errCreateDir;
+
+
+	// Create parent directory if required
+	if (!std::filesystem::exists(ptDirPath))
+		if (!std::filesystem::create_directory(ptDirPath, ptDirPath.parent_path(), errCreateDir))
+			return false;
+
+	// Try to generate new config file
+	std::ofstream cCfgFile(CFG_FILE_PATH);
+
+	// Check if failed
+	if (cCfgFile.fail())
+		return false;
+
+	// Write default config
+	cCfgFile << "#####################################################" << std::endl;
+	cCfgFile << "# Config file managing record updates for gandi.net #" << std::endl;
+	cCfgFile << "#####################################################" << std::endl;
+	cCfgFile << "\n# Service/s that are used to determine your own IP address (comma separated, raced against each other)" << std::endl;
+	cCfgFile << "IPService=" << CFG_DEF_IP_SERVICE << std::endl;
+	cCfgFile << "\n# The address of the API service" << std::endl;
+	cCfgFile << "API=" << CFG_DEF_API << std::endl;
+	cCfgFile << "\n# The message that must be received in order to view the record update as successful" << std::endl;
+	cCfgFile << "SuccessMsg=\"" << CFG_DEF_SUCCESS_MSG << "\"" << std::endl;
+	cCfgFile << "\n# The \"time to live\" of the record/s" << std::endl;
+	cCfgFile << "TTL=" << CFG_DEF_TTL << std::endl;
+	cCfgFile << "\n# Controls the update interval" << std::endl;
+	cCfgFile << "UpdatePeriodS=" << CFG_DEF_UPDATE_PERIOD_S << std::endl;
+	cCfgFile << "\n# Controls the timeout for CURL" << std::endl;
+	cCfgFile << "CurlTimeoutS=" << CFG_DEF_CURL_TIMEOUT_S << std::endl;
+	cCfgFile << "\n# Controls wether IPv6 support is enabled or disabled" << std::endl;
+	cCfgFile << "EnableIPv6=" << (CFG_DEF_IP_SERVICE ? "true" : "false") << std::endl;
+	cCfgFile << "\n# Controls wether logging is enabled or disabled" << std::endl;
+	cCfgFile << "Logging=" << (CFG_DEF_LOGGING ? "true" : "false") << std::endl;
+	cCfgFile << "\n# Maximum amount of records that are updated at the same time (all of them on a single thread)" << std::endl;
+	cCfgFile << "MaxParallelUpdates=" << CFG_DEF_MAX_PARALLEL_UPDATES << std::endl;
+	cCfgFile << "\n# Controls wether all subdomains of a domain are updated with a single zone request" << std::endl;
+	cCfgFile << "BatchUpdates=" << (CFG_DEF_BATCH_UPDATES ? "true" : "false") << std::endl;
+	cCfgFile << "\n# Controls wether the IP address is only checked after local address or route changes" << std::endl;
+	cCfgFile << "NetlinkEvents=" << (CFG_DEF_NETLINK_EVENTS ? "true" : "false") << std::endl;
+	cCfgFile << "\n# Update interval used in addition to netlink events (e.g. for NAT setups)" << std::endl;
+	cCfgFile << "SafetyPollS=" << CFG_DEF_SAFETY_POLL_S << std::endl;
+	cCfgFile << "\n# Controls wether the poll interval follows the history of address changes (longer while stable, shorter around expected changes and after failures)" << std::endl;
+	cCfgFile << "AdaptivePolling=" << (CFG_DEF_ADAPTIVE_POLLING ? "true" : "false") << std::endl;
+	cCfgFile << "\n# Bounds of the adaptive poll interval" << std::endl;
+	cCfgFile << "PollMinS=" << CFG_DEF_POLL_MIN_S << std::endl;
+	cCfgFile << "PollMaxS=" << CFG_DEF_POLL_MAX_S << std::endl;
+	cCfgFile << "\n# Shared directory of the nodes of a cluster, each subdomain is written by one live node only (empty = disabled)" << std::endl;
+	cCfgFile << "ClusterDir=" << CFG_DEF_CLUSTER_DIR << std::endl;
+	cCfgFile << "\n# Name of this node in the cluster (empty = host name)" << std::endl;
+	cCfgFile << "ClusterNode=" << CFG_DEF_CLUSTER_NODE << std::endl;
+	cCfgFile << "\n# Time until the subdomains of a node that has disappeared are taken over by the others" << std::endl;
+	cCfgFile << "ClusterLeaseS=" << CFG_DEF_CLUSTER_LEASE_S << std::endl;
+	cCfgFile << "\n# Amount of IP services that must report the same address" << std::endl;
+	cCfgFile << "IPServiceQuorum=" << CFG_DEF_IP_SERVICE_QUORUM << std::endl;
+	cCfgFile << "\n# Controls wether the current rrsets are read first so that only changed ones are written" << std::endl;
+	cCfgFile << "ReadBeforeWrite=" << (CFG_DEF_READ_BEFORE_WRITE ? "true" : "false") << std::endl;
+	cCfgFile << "\n# Interval for verifying up to date records against the zone (0 = disabled)" << std::endl;
+	cCfgFile << "VerifyPeriodS=" << CFG_DEF_VERIFY_PERIOD_S << std::endl;
+	cCfgFile << "\n# Controls wether published records are remembered in " << STATE_FILE_PATH << " to skip them after a restart (pending updates are journaled in " << JOURNAL_FILE_PATH << ")" << std::endl;
+	cCfgFile << "PersistState=" << (CFG_DEF_PERSIST_STATE ? "true" : "false") << std::endl;
+	cCfgFile << "\n# Delay before the first retry of a failed record (doubled with every further failure)" << std::endl;
+	cCfgFile << "RetryBaseS=" << CFG_DEF_RETRY_BASE_S << std::endl;
+	cCfgFile << "\n# Maximum delay between two retries of a failed record" << std::endl;
+	cCfgFile << "RetryMaxS=" << CFG_DEF_RETRY_MAX_S << std::endl;
+	cCfgFile << "\n# Port of the local metrics listener in Prometheus format (0 = disabled)" << std::endl;
+	cCfgFile << "MetricsPort=" << CFG_DEF_METRICS_PORT << std::endl;
+	cCfgFile << "\n# Address of the metrics listener" << std::endl;
+	cCfgFile << "MetricsAddress=" << CFG_DEF_METRICS_ADDRESS << std::endl;
+	cCfgFile << "\n# Format of the logfile (text or json for one JSON object per line)" << std::endl;
+	cCfgFile << "LogFormat=" << (CFG_DEF_LOG_JSON ? "json" : "text") << std::endl;
+	cCfgFile << "\n# Size of the logfile before it is rotated (0 = never rotated)" << std::endl;
+	cCfgFile << "LogMaxSizeKiB=" << CFG_DEF_LOG_MAX_SIZE_KIB << std::endl;
+	cCfgFile << "\n# Amount of rotated logfiles that are kept" << std::endl;
+	cCfgFile << "LogRotateFiles=" << CFG_DEF_LOG_ROTATE_FILES << std::endl;
+	cCfgFile << "\n# Controls wether changes of this file and of " << REC_DIR_PATH << " are applied without a restart" << std::endl;
+	cCfgFile << "WatchConfig=" << (CFG_DEF_WATCH_CONFIG ? "true" : "false") << std::endl;
+	cCfgFile << "\n# Path of the control socket used by \"recUpdater --ctl\" (empty = disabled)" << std::endl;
+	cCfgFile << "ControlSocket=" << CFG_DEF_CONTROL_SOCKET << std::endl;
+	cCfgFile << "\n# Port of the listener for address updates pushed by your router (0 = disabled)" << std::endl;
+	cCfgFile << "PushPort=" << CFG_DEF_PUSH_PORT << std::endl;
+	cCfgFile << "\n# Address of the push listener" << std::endl;
+	cCfgFile << "PushAddress=" << CFG_DEF_PUSH_ADDRESS << std::endl;
+	cCfgFile << "\n# Token (or Basic auth password) the router has to send" << std::endl;
+	cCfgFile << "PushToken=" << CFG_DEF_PUSH_TOKEN << std::endl;
+	cCfgFile << "\n# Maximum API requests per minute and API key (lowered automatically if the API limits them, 0 = only limits reported by the API)" << std::endl;
+	cCfgFile << "APIRateLimit=" << CFG_DEF_API_RATE_LIMIT << std::endl;
+	cCfgFile << "\n# Amount of API requests per API key that may be sent at once after an idle time" << std::endl;
+	cCfgFile << "APIBurst=" << CFG_DEF_API_BURST << std::endl;
+	cCfgFile << "\n# Sources of your own IP address in the order they are asked (http and/or interface, later sources only fill missing families)" << std::endl;
+	cCfgFile << "IPSource=" << CFG_DEF_IP_SOURCE << std::endl;
+	cCfgFile << "\n# Interfaces whose addresses are used by the interface source (comma separated, empty = all)" << std::endl;
+	cCfgFile << "IPInterfaces=" << CFG_DEF_IP_INTERFACES << std::endl;
+	cCfgFile << "\n# Interface addresses that are ignored (private, linklocal, ula, temporary or none)" << std::endl;
+	cCfgFile << "IPExclude=private,linklocal,ula,temporary" << std::endl;
+	cCfgFile << "\n# Interval for cross-checking the address of the first source with the following ones (0 = disabled)" << std::endl;
+	cCfgFile << "IPCrossCheckS=" << CFG_DEF_IP_CROSS_CHECK_S << std::endl;
+	cCfgFile << "\n# Controls wether updated records are looked up at the authoritative nameservers of their domain (updated again if they are not served)" << std::endl;
+	cCfgFile << "DNSVerify=" << (CFG_DEF_DNS_VERIFY ? "true" : "false") << std::endl;
+	cCfgFile << "\n# Nameservers that are asked instead of the ones of the API (comma separated host[:port], empty = ask the API)" << std::endl;
+	cCfgFile << "DNSServers=" << CFG_DEF_DNS_SERVERS << std::endl;
+	cCfgFile << "\n# Time between an update and its lookup (doubled for every further lookup)" << std::endl;
+	cCfgFile << "DNSVerifyDelayS=" << CFG_DEF_DNS_VERIFY_DELAY_S << std::endl;
+	cCfgFile << "\n# Amount of lookups until a record that is not served is updated again" << std::endl;
+	cCfgFile << "DNSVerifyAttempts=" << CFG_DEF_DNS_VERIFY_ATTEMPTS << std::endl;
+	cCfgFile << "\n# Time to wait for an answer of a nameserver (a query is sent up to " << DNS_TRIES << " times)" << std::endl;
+	cCfgFile << "DNSTimeoutMs=" << CFG_DEF_DNS_TIMEOUT_MS << std::endl;
+	cCfgFile << "\n# HTTP version of API requests: auto (HTTP/2 over TLS if offered), 1.1 or 2 (also asks plain http servers to upgrade, falls back to HTTP/1.1)" << std::endl;
+	cCfgFile << "HTTPVersion=auto" << std::endl;
+
+	// Close file
+	cCfgFile.close();
+
+	// Success
 	return true;
 
-} // readIPAddress
+} // generateConfig
+
+//
+// runBenchmark
+//
+// Task: Run the benchmark given on the command line
+//
+int runBenchmark(int argc, char* argv[])
+{
+	// Records table
+	if ((argc >= 3) && (strcmp(argv[2], "records") == 0))
+		return benchRecords((argc >= 4) ? std::max(atol(argv[3]), 1L) : BENCH_DEF_RECORDS);
+
+	// Logging
+	if ((argc >= 3) && (strcmp(argv[2], "logging") == 0))
+		return benchLogging((argc >= 4) ? std::max(atol(argv[3]), 1L) : BENCH_DEF_LOG_LINES);
+
+	// Interface address source
+	if ((argc >= 3) && (strcmp(argv[2], "ip") == 0))
+		return benchIPProvider((argc >= 4) ? std::max(atol(argv[3]), 1L) : BENCH_DEF_IP_READS);
+
+	// Update cycles against the mock server
+	if ((argc >= 3) && (strcmp(argv[2], "updates") == 0))
+		return benchUpdates(((argc >= 4) ? std::max(atol(argv[3]), 1L) : BENCH_DEF_DOMAINS), ((argc >= 5) ? std::max(atol(argv[4]), 1L) : BENCH_DEF_SUBDOMAINS), ((argc >= 6) ? std::max(atol(argv[5]), 1L) : BENCH_DEF_CYCLES),
+			((argc >= 7) ? std::clamp(atoi(argv[6]), 0, 65535) : BENCH_DEF_LATENCY_MS), ((argc >= 8) ? std::clamp(atof(argv[7]), 0.0, 100.0) / 100.0 : 0.0), ((argc >= 9) ? std::clamp(atof(argv[8]), 0.0, 100.0) / 100.0 : 0.0),
+			((argc >= 10) ? std::max(atol(argv[9]), 0L) : 0));
+
+	// Heap allocations of rrset updates
+	if ((argc >= 3) && (strcmp(argv[2], "alloc") == 0))
+		return benchAllocations((argc >= 4) ? std::max(atol(argv[3]), 1L) : BENCH_DEF_ALLOC_UPDATES);
+
+	// Unknown benchmark
+	std::cerr << COLOR_RED << "[ERROR]: Unknown benchmark! Sytax: recUpdater --bench records [<amount>], recUpdater --bench logging [<lines>], recUpdater --bench ip [<reads>], recUpdater --bench updates [<domains>] [<subdomains>] [<cycles>] [<latencyMs>] [<error%>] [<429%>] [<requests/min>] or recUpdater --bench alloc [<updates>]" << COLOR_DEFAULT << std::endl;
+	return -1;
+
+} // runBenchmark
+
+//
+// benchRecords
+//
+// Task: Measure loading, lookup and update scan of a generated records directory
+//
+int benchRecords(size_t iAmount)
+{
+	// Variables
+	char cDir[] = "/tmp/recUpdater-bench-XXXXXX";
+	CRecordTable cRecordTable;
+	CRetryScheduler cRetryScheduler;
+	SConfigContents sConfigContents;
+	std::vector<std::pair<std::string, std::string>> vecKeys;
+	std::map<SDomRecords*, std::set<std::string>> mapDue;
+	std::chrono::steady_clock::time_point tStart;
+	std::string strErrorMsg;
+	struct rusage sUsage;
+	FILE* pFile = NULL;
+	size_t iFiles = 0, iFound = 0, iRRSets = 0, iMemBefore, iMemAfter;
+	double dLoadMs, dLookupMs, dScanMs;
+	std::error_code cError;
+
+
+	// Try to create directory
+	if (mkdtemp(cDir) == NULL)
+	{
+		std::cerr << COLOR_RED << "[ERROR]: Cannot create benchmark directory: " << std::strerror(errno) << "." << COLOR_DEFAULT << std::endl;
+		return -1;
+	}
+
+	// Generate records files (every third record with its own TTL, every fifth IPv4 only)
+	std::cout << "Generating " << iAmount << " records... " << std::flush;
+	for (size_t i = 0; i < iAmount; i++)
+	{
+		// Start next file
+		if ((i % (BENCH_SUBDOMAINS_PER_DOMAIN * BENCH_DOMAINS_PER_FILE)) == 0)
+		{
+			if (pFile != NULL)
+				fclose(pFile);
+			if ((pFile = fopen((std::string(cDir) + "/bench" + std::to_string(iFiles) + REC_FILE_EXTENSION).c_str(), "w")) == NULL)
+				break;
+			fprintf(pFile, "APIKey=benchkey%zu\n", (iFiles++ % BENCH_API_KEYS));
+		}
+
+		// Write record and remember its key
+		fprintf(pFile, "bench%zu.example host%zu%s%s\n", (i / BENCH_SUBDOMAINS_PER_DOMAIN), (i % BENCH_SUBDOMAINS_PER_DOMAIN), (((i % 3) == 0) ? " 300" : ""), (((i % 5) == 0) ? " ipv4" : ""));
+		vecKeys.emplace_back(("bench" + std::to_string(i / BENCH_SUBDOMAINS_PER_DOMAIN) + ".example"), ("host" + std::to_string(i % BENCH_SUBDOMAINS_PER_DOMAIN)));
+	}
+	if (pFile != NULL)
+		fclose(pFile);
+	std::cout << COLOR_GREEN << "OK" << COLOR_DEFAULT << std::endl;
+
+	// Load records
+	iMemBefore = residentMemoryKiB();
+	tStart = std::chrono::steady_clock::now();
+	if (cRecordTable.loadDirectory(cDir, &strErrorMsg) != REC_ERR_NONE)
+	{
+		std::cerr << COLOR_RED << "[ERROR]: Cannot load records: " << strErrorMsg << "." << COLOR_DEFAULT << std::endl;
+		std::filesystem::remove_all(cDir, cError);
+		return -1;
+	}
+	cRecordTable.applyDefaultTTL(sConfigContents.iTTL);
+	dLoadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tStart).count();
+	iMemAfter = residentMemoryKiB();
+
+	// Look up every record
+	std::shuffle(vecKeys.begin(), vecKeys.end(), std::mt19937(1));
+	tStart = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < vecKeys.size(); i++)
+		iFound += (cRecordTable.find(vecKeys[i].first, vecKeys[i].second) != NULL);
+	dLookupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tStart).count();
+
+	// Scan all records like after an address change (schedule every rrset and take them from the queue)
+	tStart = std::chrono::steady_clock::now();
+	for (std::list<SDomRecords>::iterator iRec = cRecordTable.records().begin(); iRec != cRecordTable.records().end(); iRec++)
+	{
+		iRec->setPending = rrsetKeys(*iRec, sConfigContents, "2001:db8::1");
+		for (std::set<std::string>::iterator iRRSet = iRec->setPending.begin(); iRRSet != iRec->setPending.end(); iRRSet++)
+			cRetryScheduler.schedule(&(*iRec), *iRRSet, 0, tStart);
+	}
+	mapDue = cRetryScheduler.popDue(std::chrono::steady_clock::now());
+	for (std::map<SDomRecords*, std::set<std::string>>::iterator iDue = mapDue.begin(); iDue != mapDue.end(); iDue++)
+		iRRSets += iDue->second.size();
+	dScanMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tStart).count();
+
+	// Remove files and print results
+	std::filesystem::remove_all(cDir, cError);
+	getrusage(RUSAGE_SELF, &sUsage);
+	printf("Records: %zu in %zu zones (%zu files, %zu duplicates, %zu found)\n", cRecordTable.size(), cRecordTable.records().size(), iFiles, cRecordTable.duplicates(), iFound);
+	printf("Loading: %.1f ms (%.0f records/s)\n", dLoadMs, ((double)cRecordTable.size() * 1000.0 / std::max(dLoadMs, 0.001)));
+	printf("Lookup:  %.0f ns/record\n", (dLookupMs * 1000000.0 / std::max<size_t>(vecKeys.size(), 1)));
+	printf("Scan:    %.1f ms (%zu rrsets due)\n", dScanMs, iRRSets);
+	printf("Memory:  %.1f MiB for the table (peak RSS %.1f MiB)\n", ((double)(iMemAfter - std::min(iMemAfter, iMemBefore)) / 1024.0), ((double)sUsage.ru_maxrss / 1024.0));
+	return 0;
+
+} // benchRecords
+
+//
+// benchLogging
+//
+// Task: Measure the time a line takes on the calling thread and how fast the writer empties the ring
+//
+int benchLogging(size_t iLines)
+{
+	// Variables
+	char cDirPath[] = "/tmp/recUpdater-bench-XXXXXX";
+	std::string strPath;
+	std::vector<double> vecLatencies;
+	struct stat sStat;
+
+
+	// Create temporary directory
+	if (mkdtemp(cDirPath) == NULL)
+	{
+		std::cerr << COLOR_RED << "[ERROR]: Cannot create temporary directory: " << std::strerror(errno) << "." << COLOR_DEFAULT << std::endl;
+		return -1;
+	}
+	strPath = std::string(cDirPath) + "/recUpdater.log";
+
+	// Measure both formats
+	for (bool bJson : { false, true })
+	{
+		// Variables
+		CLogger cLogger;
+		std::chrono::steady_clock::time_point tStart, tLogged, tWritten;
+
+
+		// Open logfile
+		if (!cLogger.open(strPath.c_str(), bJson, 0, 1))
+		{
+			std::cerr << COLOR_RED << "[ERROR]: Cannot open logfile: " << std::strerror(errno) << "." << COLOR_DEFAULT << std::endl;
+			std::filesystem::remove_all(cDirPath);
+			return -1;
+		}
+
+		// Log lines like the update loop does (in bursts of half the ring)
+		vecLatencies.clear();
+		vecLatencies.reserve(iLines);
+		tStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iLines; i++)
+		{
+			// Variables
+			std::chrono::steady_clock::time_point tLine = std::chrono::steady_clock::now();
+
+
+			// Log line
+			cLogger.log(LOG_LEVEL_UPDATE, "Updating record/s for '%s' (%s)... %s", ("bench" + std::to_string(i / BENCH_SUBDOMAINS_PER_DOMAIN) + ".example").c_str(), "www, mail, cloud", "Done");
+			vecLatencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tLine).count());
+			if (((i + 1) % (LOG_RING_SIZE / 2)) == 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		tLogged = std::chrono::steady_clock::now();
+
+		// Wait for the writer
+		cLogger.close();
+		tWritten = std::chrono::steady_clock::now();
+
+		// Print results
+		stat(strPath.c_str(), &sStat);
+		printf("%s: %zu lines (%llu dropped), p50 %.2f us, p99 %.2f us per line, %.1f ms total, written after %.1f ms (%.1f KiB)\n", (bJson ? "JSON" : "Text"), iLines, (unsigned long long)cLogger.dropped(), percentile(&vecLatencies, 0.5),
+			percentile(&vecLatencies, 0.99), std::chrono::duration<double, std::milli>(tLogged - tStart).count(), std::chrono::duration<double, std::milli>(tWritten - tStart).count(), ((double)sStat.st_size / 1024.0));
+		unlink(strPath.c_str());
+	}
+
+	// Remove temporary files
+	std::filesystem::remove_all(cDirPath);
+	return 0;
+
+} // benchLogging
+
+//
+// benchIPProvider
+//
+// Task: Measure how long the interface source takes to pick the addresses
+//
+int benchIPProvider(size_t iReads)
+{
+	// Variables
+	SConfigContents sConfigContents;
+	CInterfaceIPProvider cInterfaceIPProvider;
+	std::string strIPv4, strIPv6;
+	std::vector<double> vecLatencies;
+	bool bFound = false;
+
+
+	// Read addresses with the settings of the config (if available)
+	loadConfig(&sConfigContents);
+	vecLatencies.reserve(iReads);
+	for (size_t i = 0; i < iReads; i++)
+	{
+		// Variables
+		std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+
+
+		// Read addresses
+		bFound = cInterfaceIPProvider.read(sConfigContents, &strIPv4, (sConfigContents.bEnableIPv6 ? &strIPv6 : NULL));
+		vecLatencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tStart).count());
+	}
+
+	// Print results
+	printf("Interface source: %zu reads, p50 %.1f us, p99 %.1f us (IPv4: %s, IPv6: %s)\n", iReads, percentile(&vecLatencies, 0.5), percentile(&vecLatencies, 0.99),
+		(strIPv4.empty() ? "-" : strIPv4.c_str()), (strIPv6.empty() ? "-" : strIPv6.c_str()));
+	return (bFound ? 0 : 1);
+
+} // benchIPProvider
+
+//
+// residentMemoryKiB
+//
+// Task: Get the current resident memory of the process
+//
+size_t residentMemoryKiB()
+{
+	// Variables
+	FILE* pFile = fopen("/proc/self/statm", "r");
+	unsigned long iSize = 0, iResident = 0;
+
+
+	// Read resident pages
+	if (pFile == NULL)
+		return 0;
+	if (fscanf(pFile, "%lu %lu", &iSize, &iResident) != 2)
+		iResident = 0;
+	fclose(pFile);
+
+	// Return result
+	return (iResident * (sysconf(_SC_PAGESIZE) / 1024));
+
+} // residentMemoryKiB
+
+//
+// benchUpdates
+//
+// Task: Drive full update cycles of generated records against a mock server (in a child process) and measure them
+//
+int benchUpdates(size_t iDomains, size_t iSubDomains, size_t iCycles, uint16_t iLatencyMs, double dErrorRate, double dLimitRate, uint32_t iPerMinute)
+{
+	// Variables
+	CMockServer cMockServer(iLatencyMs, dErrorRate, dLimitRate, iPerMinute);
+	SConfigContents sConfigContents;
+	CRecordTable cRecordTable;
+	CIPServiceStats cIPServiceStats;
+	std::vector<double> vecLatencies;
+	std::string strIPv4, strIPv6, strBase;
+	struct rusage sUsage;
+	size_t iPublished = 0, iFailed = 0, iRetried = 0;
+	uint64_t iAllocations;
+	double dTotalMs = 0.0;
+	pid_t iMock;
+
+
+	// Try to open mock server on any port and run it in a child process (keeps its CPU time out of the measurement)
+	if (!cMockServer.listen(0))
+	{
+		std::cerr << COLOR_RED << "[ERROR]: Cannot start mock server: " << std::strerror(errno) << "." << COLOR_DEFAULT << std::endl;
+		return -1;
+	}
+	if ((iMock = fork()) == 0)
+	{
+		cMockServer.run();
+		_exit(0);
+	}
+	strBase = "http://127.0.0.1:" + std::to_string(cMockServer.port());
+
+	// Use settings of the config (if available) against the mock server
+	loadConfig(&sConfigContents);
+	sConfigContents.strAPI = strBase + "/api/v5/";
+	sConfigContents.strIPService = strBase + "/ip";
+	sConfigContents.iIPServiceQuorum = 1;
+	sConfigContents.bEnableIPv6 = false;
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+	g_cMetrics.init(splitList(sConfigContents.strIPService, ','));
+	g_cRateLimiter.configure(sConfigContents.iAPIRateLimit, sConfigContents.iAPIBurst);
+
+	// Generate records
+	for (size_t i = 0; i < (iDomains * iSubDomains); i++)
+		cRecordTable.add(("benchkey" + std::to_string((i / iSubDomains) % BENCH_API_KEYS)), ("bench" + std::to_string(i / iSubDomains) + ".example"), SSubDomain(("host" + std::to_string(i % iSubDomains)), sConfigContents.iTTL));
+
+	// Print settings
+	printf("Updating %zu domains x %zu subdomains in %zu cycles (%u records at once, batch %s, read before write %s)\n", iDomains, iSubDomains, iCycles, sConfigContents.iMaxParallelUpdates, (sConfigContents.bBatchUpdates ? "on" : "off"), (sConfigContents.bReadBeforeWrite ? "on" : "off"));
+	printf("Mock server on port %u: %u ms latency, %.1f %% errors, %.1f %% rate limited, %u requests/min per API key (client limit %u/min)\n", cMockServer.port(), iLatencyMs, (dErrorRate * 100.0), (dLimitRate * 100.0), iPerMinute, sConfigContents.iAPIRateLimit);
+
+	// Run cycles in their own scope (workers and connections are gone before measuring)
+	iAllocations = g_iAllocations.load();
+	{
+		// Variables
+		CHttpClient cHttpClient;
+		CZoneCache cZoneCache;
+
+
+		// Run through cycles
+		for (size_t iCycle = 0; ((iCycle < iCycles) && (!g_sigInterrupt)); iCycle++)
+		{
+			// Variables
+			SHttpResponse sResponse;
+			std::chrono::steady_clock::time_point tStart;
+
+
+			// Change address of mock server and read it
+			cHttpClient.request("PUT", sConfigContents.strIPService, {}, ("198.51.100." + std::to_string((iCycle % 250) + 1)), sConfigContents.iCurlTimeout, &sResponse);
+			tStart = std::chrono::steady_clock::now();
+			if (!readIPAddress(&strIPv4, &strIPv6, sConfigContents, &cHttpClient, &cIPServiceStats))
+			{
+				std::cerr << COLOR_RED << "[ERROR]: Cannot get IP address from mock server." << COLOR_DEFAULT << std::endl;
+				break;
+			}
+
+			// Mark all rrsets as pending
+			for (std::list<SDomRecords>::iterator iRec = cRecordTable.records().begin(); iRec != cRecordTable.records().end(); iRec++)
+				iRec->setPending = rrsetKeys(*iRec, sConfigContents, strIPv6);
+
+			// Update pending rrsets (failed ones are retried without delay in further rounds)
+			for (size_t iRound = 0; iRound < BENCH_MAX_ROUNDS; iRound++)
+			{
+				// Variables
+				std::list<SPendingUpdate> lstPending;
+
+
+				// Queue records with pending rrsets
+				for (std::list<SDomRecords>::iterator iRec = cRecordTable.records().begin(); iRec != cRecordTable.records().end(); iRec++)
+				{
+					// Skip records without pending rrsets
+					if (iRec->setPending.empty())
+						continue;
+
+					// Queue update
+					SPendingUpdate* psPending = &(*lstPending.emplace(lstPending.end()));
+					psPending->iRec = iRec;
+					psPending->setRRSets = iRec->setPending;
+				}
+
+				// Nothing left to do
+				if (lstPending.empty())
+					break;
+
+				// Run updates on this thread and gather results once each is done (latency of a rrset is the time since the address has been read)
+				updateRecords(&lstPending, sConfigContents, strIPv4, strIPv6, &cHttpClient, &cZoneCache, [&](SPendingUpdate* psPending) {
+					// Variables
+					double dLatencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tStart).count();
+
+
+					// Run through processed rrsets
+					for (std::set<std::string>::iterator iRRSet = psPending->setRRSets.begin(); iRRSet != psPending->setRRSets.end(); iRRSet++)
+					{
+						// Keep failed rrsets pending
+						if (psPending->iRec->mapFailed.count(*iRRSet) != 0)
+						{
+							iRetried++;
+							continue;
+						}
+
+						// Count published rrset
+						psPending->iRec->setPending.erase(*iRRSet);
+						vecLatencies.push_back(dLatencyMs);
+						iPublished++;
+					}
+				});
+			}
+
+			// Count rrsets that failed in every round
+			for (std::list<SDomRecords>::iterator iRec = cRecordTable.records().begin(); iRec != cRecordTable.records().end(); iRec++)
+			{
+				iFailed += iRec->setPending.size();
+				iRec->setPending.clear();
+			}
+			dTotalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tStart).count();
+		}
+	}
+
+	// Stop mock server and get resource usage of this process only
+	iAllocations = g_iAllocations.load() - iAllocations;
+	kill(iMock, SIGTERM);
+	waitpid(iMock, NULL, 0);
+	getrusage(RUSAGE_SELF, &sUsage);
+
+	// Print results
+	printf("Published: %zu rrsets (%zu failed, %zu retries, %llu throttled)\n", iPublished, iFailed, iRetried, (unsigned long long)g_cMetrics.iRateLimited.load());
+	printf("Throughput: %.1f records/s\n", ((double)iPublished * 1000.0 / std::max(dTotalMs, 0.001)));
+	printf("Latency: p50 %.1f ms, p99 %.1f ms\n", percentile(&vecLatencies, 0.5), percentile(&vecLatencies, 0.99));
+	printf("CPU time: %.2f s user, %.2f s system\n", (sUsage.ru_utime.tv_sec + (sUsage.ru_utime.tv_usec / 1000000.0)), (sUsage.ru_stime.tv_sec + (sUsage.ru_stime.tv_usec / 1000000.0)));
+	printf("Peak RSS: %.1f MiB\n", ((double)sUsage.ru_maxrss / 1024.0));
+#ifdef BENCH_ALLOC
+	printf("Heap allocations: %.1f per published rrset\n", ((double)iAllocations / std::max<size_t>(iPublished, 1)));
+#endif
+	return 0;
+
+} // benchUpdates
+
+//
+// benchAllocations
+//
+// Task: Count the heap allocations of steady state rrset updates of a record against a mock server (in a child process)
+//
+int benchAllocations(size_t iUpdates)
+{
+	// Variables
+	CMockServer cMockServer(0, 0.0, 0.0, 0);
+	SConfigContents sConfigContents;
+	CRecordTable cRecordTable;
+	SPendingUpdate sPending;
+	std::function<void(SPendingUpdate*)> fnDone = [](SPendingUpdate*) {};
+	const std::string strIPs[2] = { "198.51.100.1", "198.51.100.2" };
+	const std::string strIPv6;
+	std::chrono::steady_clock::time_point tStart;
+	uint64_t iAllocations = 0;
+	size_t iWritten = 0, iFailed = 0;
+	double dTotalMs;
+	pid_t iMock;
+
+
+#ifndef BENCH_ALLOC
+	// Allocations are only counted if compiled in
+	std::cerr << COLOR_RED << "[ERROR]: Allocation counting is not compiled in. Build with -DBENCH_ALLOC to run this benchmark." << COLOR_DEFAULT << std::endl;
+	return -1;
+#endif
+
+	// Try to open mock server on any port and run it in a child process
+	if (!cMockServer.listen(0))
+	{
+		std::cerr << COLOR_RED << "[ERROR]: Cannot start mock server: " << std::strerror(errno) << "." << COLOR_DEFAULT << std::endl;
+		return -1;
+	}
+	if ((iMock = fork()) == 0)
+	{
+		cMockServer.run();
+		_exit(0);
+	}
+
+	// Use settings of the config (if available) against the mock server, rrsets are written right away without rate limit
+	loadConfig(&sConfigContents);
+	sConfigContents.strAPI = "http://127.0.0.1:" + std::to_string(cMockServer.port()) + "/api/v5/";
+	sConfigContents.bEnableIPv6 = false;
+	sConfigContents.bBatchUpdates = false;
+	sConfigContents.bReadBeforeWrite = false;
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+	g_cRateLimiter.configure(0, sConfigContents.iAPIBurst);
+
+	// Generate record
+	for (size_t i = 0; i < BENCH_DEF_SUBDOMAINS; i++)
+		cRecordTable.add("benchkey0", "bench0.example", SSubDomain(("host" + std::to_string(i)), sConfigContents.iTTL));
+	sPending.iRec = cRecordTable.records().begin();
+	sPending.setRRSets = rrsetKeys(*sPending.iRec, sConfigContents, strIPv6);
+
+	// Print settings
+	printf("Updating %zu rrsets of a record %zu times (warm up %u times)\n", sPending.setRRSets.size(), iUpdates, BENCH_ALLOC_WARMUP);
+
+	// Run updates in their own scope (connections are gone before measuring)
+	{
+		// Variables
+		CHttpClient cHttpClient;
+		CZoneCache cZoneCache;
+		CTaskGroup cTasks(&cHttpClient);
+
+
+		// Assign context of the update task
+		sPending.psConfigContents = &sConfigContents;
+		sPending.pstrIPs[1] = &strIPv6;
+		sPending.pcTasks = &cTasks;
+		sPending.pcZoneCache = &cZoneCache;
+		sPending.pfnDone = &fnDone;
+
+		// Update record with alternating addresses (counting starts once all buffers are warm)
+		for (size_t i = 0; ((i < (iUpdates + BENCH_ALLOC_WARMUP)) && (!g_sigInterrupt)); i++)
+		{
+			// Start measurement
+			if (i == BENCH_ALLOC_WARMUP)
+			{
+				iAllocations = g_iAllocations.load();
+				tStart = std::chrono::steady_clock::now();
+			}
+
+			// Update record
+			sPending.pstrIPs[0] = &strIPs[i % 2];
+			updateRecord(&sPending);
+			cTasks.run();
+			if (i >= BENCH_ALLOC_WARMUP)
+			{
+				iWritten += sPending.iRec->iWritten;
+				iFailed += sPending.iRec->mapFailed.size();
+			}
+		}
+		iAllocations = g_iAllocations.load() - iAllocations;
+		dTotalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tStart).count();
+	}
+
+	// Stop mock server
+	kill(iMock, SIGTERM);
+	waitpid(iMock, NULL, 0);
+
+	// Print results (allocations of libcurl itself are not counted)
+	printf("Written: %zu rrsets (%zu failed) in %.1f ms\n", iWritten, iFailed, dTotalMs);
+	printf("Heap allocations: %llu (%.2f per rrset)\n", (unsigned long long)iAllocations, ((double)iAllocations / std::max<size_t>(iWritten + iFailed, 1)));
+	return 0;
+
+} // benchAllocations
+
+//
+// percentile
+//
+// Task: Get the value at the given rank (0..1) of a list of values
+//
+double percentile(std::vector<double>* pvecValues, double dRank)
+{
+	// Check if empty
+	if (pvecValues->empty())
+		return 0.0;
+
+	// Select element of rank
+	size_t iIndex = (size_t)(dRank * (pvecValues->size() - 1));
+	std::nth_element(pvecValues->begin(), (pvecValues->begin() + iIndex), pvecValues->end());
+	return (*pvecValues)[iIndex];
+
+} // percentile
+
+#ifdef BENCH_ALLOC
+//
+// operator new
+//
+// Task: Allocate memory and count the allocation (only compiled in with -DBENCH_ALLOC for the allocation benchmark)
+//
+void* operator new(size_t iSize)
+{
+	// Variables
+	void* pMemory;
+
+
+	// Count allocation and allocate memory
+	g_iAllocations.fetch_add(1, std::memory_order_relaxed);
+	if ((pMemory = malloc((iSize > 0) ? iSize : 1)) == NULL)
+		throw std::bad_alloc();
+	return pMemory;
+
+} // operator new
 
 //
-// updateRecord
+// operator new[]
+//
+// Task: Allocate memory of an array and count the allocation
+//
+void* operator new[](size_t iSize)
+{
+	// Allocate memory
+	return operator new(iSize);
+
+} // operator new[]
+
+//
+// operator delete
+//
+// Task: Free memory allocated by operator new (never inlined, so the compiler does not pair the free with the malloc of operator new)
+//
+__attribute__((noinline)) void operator delete(void* pMemory) noexcept
+{
+	// Free memory
+	free(pMemory);
+
+} // operator delete
+
+//
+// operator delete
+//
+// Task: Free memory allocated by operator new (sized)
+//
+__attribute__((noinline)) void operator delete(void* pMemory, size_t) noexcept
+{
+	// Free memory
+	free(pMemory);
+
+} // operator delete
+
+//
+// operator delete[]
+//
+// Task: Free memory of an array allocated by operator new[]
+//
+__attribute__((noinline)) void operator delete[](void* pMemory) noexcept
+{
+	// Free memory
+	free(pMemory);
+
+} // operator delete[]
+
+//
+// operator delete[]
+//
+// Task: Free memory of an array allocated by operator new[] (sized)
+//
+__attribute__((noinline)) void operator delete[](void* pMemory, size_t) noexcept
+{
+	// Free memory
+	free(pMemory);
+
+} // operator delete[]
+#endif
+
 //
-// Task: Update an record
+// runMock
 //
-bool updateRecord(SDomRecords *psDomRecords, SConfigContents sConfigContents, std::string strIPv4, std::string strIPv6, std::string *pstrErrorMsg)
+// Task: Run the mock server in the foreground
+//
+int runMock(int argc, char* argv[])
 {
 	// Variables
-	char cCommand[BIG_BUFFER];
-	std::string strResult;
-	int iMsgStartPos, iMsgEndPos;
+	uint16_t iPort = (argc >= 3) ? std::clamp(atoi(argv[2]), 0, 65535) : MOCK_DEF_PORT;
+	CMockServer cMockServer(((argc >= 4) ? std::clamp(atoi(argv[3]), 0, 65535) : 0), ((argc >= 5) ? std::clamp(atof(argv[4]), 0.0, 100.0) / 100.0 : 0.0), ((argc >= 6) ? std::clamp(atof(argv[5]), 0.0, 100.0) / 100.0 : 0.0), ((argc >= 7) ? std::max(atol(argv[6]), 0L) : 0), ((argc >= 8) ? std::max(atol(argv[7]), 0L) : 0));
 
 
-	// Run through subdomains
-	for (std::list<std::string>::iterator iSDom = psDomRecords->lstSubDomains.begin(); iSDom != psDomRecords->lstSubDomains.end(); iSDom++)
+	// Try to listen
+	if (!cMockServer.listen(iPort))
 	{
-		// Format and execute command
-		sprintf(cCommand, "curl -m %i -s -XPUT -d \'{\"rrset_ttl\": \"%i\", \"rrset_values\": [\"%s\"]}\' -H \"X-Api-Key: %s\" -H \"Content-Type: application/json\" %s/domains/%s/records/%s/A", sConfigContents.iCurlTimeout, sConfigContents.iTTL, strIPv4.c_str(), psDomRecords->strAPIKey.c_str(), sConfigContents.strAPI.c_str(), psDomRecords->strDomain.c_str(), iSDom->c_str());
-		strResult = exec(cCommand);
-
-		// Convert result to lower case
-		for (uint16_t i = 0; i < strResult.length(); i++)
-			strResult[i] = tolower(strResult[i]);
+		std::cerr << COLOR_RED << "[ERROR]: Cannot start mock server: " << std::strerror(errno) << ". Sytax: recUpdater --mock [<port>] [<latencyMs>] [<error%>] [<429%>] [<requests/min>] [<propagationS>]" << COLOR_DEFAULT << std::endl;
+		return -1;
+	}
 
-		// Check if execution was successfull
-		if (strResult.find(sConfigContents.strSuccessMsg) == std::string::npos)
-		{
-			// Assign error message if required
-			if ((pstrErrorMsg != NULL) && ((iMsgStartPos = strResult.find("\"message\":")) != std::string::npos) && (strResult.length() >= (iMsgStartPos + 12)) && ((iMsgEndPos = strResult.find("\"", (iMsgStartPos + 12))) != std::string::npos))
-				*pstrErrorMsg = strResult.substr((iMsgStartPos + 12), (iMsgEndPos - (iMsgStartPos + 12)));
-			else if (pstrErrorMsg != NULL)
-				*pstrErrorMsg = "Unknown error";
+	// Print to terminal and serve
+	std::cout << "Mock server listening on 127.0.0.1:" << cMockServer.port() << " (IPService=http://127.0.0.1:" << cMockServer.port() << "/ip, API=http://127.0.0.1:" << cMockServer.port() << "/api/v5/, DNSServers=127.0.0.1:" << cMockServer.port() << ")" << std::endl;
+	cMockServer.run();
+	return 0;
 
-			// Failure
-			return false;
-		}
+} // runMock
 
-		// Check if IPv6 is enabled and valid
-		if ((sConfigContents.bEnableIPv6) && (strIPv6.length() != 0))
-		{
-			// Format and execute command
-			sprintf(cCommand, "curl -m %i -s -XPUT -d \'{\"rrset_ttl\": \"%i\", \"rrset_values\": [\"%s\"]}\' -H \"X-Api-Key: %s\" -H \"Content-Type: application/json\" %s/domains/%s/records/%s/A", sConfigContents.iCurlTimeout, sConfigContents.iTTL, strIPv6.c_str(), psDomRecords->strAPIKey.c_str(), sConfigContents.strAPI.c_str(), psDomRecords->strDomain.c_str(), iSDom->c_str());
-			strResult = exec(cCommand);
 
-			// Convert result to lower case
-			for (uint16_t i = 0; i < strResult.length(); i++)
-				strResult[i] = tolower(strResult[i]);
+//
+// CMockServer::listen
+//
+// Task: Open the listening socket on the loopback interface (port 0 picks any free port)
+//
+bool CMockServer::listen(uint16_t iPort)
+{
+	// Variables
+	struct sockaddr_in sAddr;
+	int iReuse = 1;
 
-			// Check if execution was successfull
-			if (strResult.find(sConfigContents.strSuccessMsg) == std::string::npos)
-			{
-				// Assign error message if required
-				if ((pstrErrorMsg != NULL) && ((iMsgStartPos = strResult.find("\"message\":")) != std::string::npos) && (strResult.length() >= (iMsgStartPos + 12)) && ((iMsgEndPos = strResult.find("\"", (iMsgStartPos + 12))) != std::string::npos))
-					*pstrErrorMsg = strResult.substr((iMsgStartPos + 12), (iMsgEndPos - (iMsgStartPos + 12)));
-				else if (pstrErrorMsg != NULL)
-					*pstrErrorMsg = "Unknown error";
 
-				// Failure
-				return false;
-			}
-		}
+	// Try to open socket, bind and listen
+	memset(&sAddr, 0, sizeof(sAddr));
+	sAddr.sin_family = AF_INET;
+	sAddr.sin_port = htons(iPort);
+	sAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if ((m_iSocket = socket(AF_INET, (SOCK_STREAM | SOCK_CLOEXEC), 0)) < 0)
+		return false;
+	setsockopt(m_iSocket, SOL_SOCKET, SO_REUSEADDR, &iReuse, sizeof(iReuse));
+	if ((bind(m_iSocket, (struct sockaddr*)&sAddr, sizeof(sAddr)) < 0) || (::listen(m_iSocket, SOMAXCONN) < 0))
+	{
+		close(m_iSocket);
+		m_iSocket = -1;
+		return false;
+	}
 
-		// Set update flag
-		psDomRecords->bUpToData = true;
+	// Try to answer DNS queries on the same port (no nameserver if taken)
+	sAddr.sin_port = htons(port());
+	if (((m_iDnsSocket = socket(AF_INET, (SOCK_DGRAM | SOCK_CLOEXEC), 0)) >= 0) && (bind(m_iDnsSocket, (struct sockaddr*)&sAddr, sizeof(sAddr)) < 0))
+	{
+		close(m_iDnsSocket);
+		m_iDnsSocket = -1;
 	}
 
 	// Success
 	return true;
 
-} // updateRecord
-
+} // CMockServer::listen
 
 //
-// sigInterrupt
+// CMockServer::port
 //
-// Task: Process terminate-interrupt
+// Task: Get the port of the listening socket
 //
-void sigInterrupt(int iSignal)
+uint16_t CMockServer::port()
 {
-	// Set flag and notify main thread
-	g_sigInterrupt = 1;
-	g_condSigInterrupt.notify_one();
+	// Variables
+	struct sockaddr_in sAddr;
+	socklen_t iAddrLen = sizeof(sAddr);
+
 
-} // sigInterrupt
+	// Get bound address
+	if (getsockname(m_iSocket, (struct sockaddr*)&sAddr, &iAddrLen) < 0)
+		return 0;
+	return ntohs(sAddr.sin_port);
 
+} // CMockServer::port
 
 //
-// loadConfig
+// CMockServer::run
 //
-// Task: Load the configuration from file
+// Task: Accept connections and serve each one in its own thread
 //
-uint8_t loadConfig(SConfigContents* psConfigContents)
+void CMockServer::run()
 {
 	// Variables
-	std::string strCurLine;
-	int iSepPos;
-	uint8_t iAssignedAttr = 0;
-	int8_t iIPv6Check, iLogCheck;
+	int iClient;
 
 
-	// Try to open config file
-	std::ifstream cCfgFile(CFG_FILE_PATH);
+	// Answer DNS queries in the background
+	if (m_iDnsSocket != -1)
+		std::thread(&CMockServer::serveDns, this).detach();
 
-	// Check if failed
-	if (cCfgFile.fail())
-		return CFG_ERR_FILE;
+	// Accept loop
+	while ((iClient = accept(m_iSocket, NULL, NULL)) >= 0)
+		std::thread(&CMockServer::serve, this, iClient).detach();
 
-	// Run trough file
-	while (std::getline(cCfgFile, strCurLine))
+} // CMockServer::run
+
+//
+// CMockServer::serve
+//
+// Task: Answer the requests of a keep-alive connection
+//
+void CMockServer::serve(int iClient)
+{
+	// Variables
+	std::string strBuffer;
+	char cBuffer[BIG_BUFFER * 20];
+	ssize_t iLength;
+
+
+	// Request loop
+	while (true)
 	{
-		// Convert to lower case
-		for (uint8_t i = 0; i < strCurLine.length(); i++)
-			strCurLine[i] = tolower(strCurLine[i]);
+		// Variables
+		std::string strHead, strMethod, strPath, strIfNoneMatch, strAPIKey, strBody, strResponse, strHeaders;
+		size_t iHeadEnd, iContentLength = 0, iPos;
+		bool bClose = false;
+		int iStatus;
 
-		// Try to find separation specifier
-		iSepPos = strCurLine.find('=');
 
-		// Check if current line is an attribute
-		if (iSepPos != std::string::npos)
+		// Read until the header is complete
+		while ((iHeadEnd = strBuffer.find("\r\n\r\n")) == std::string::npos)
 		{
-			// Skip spaces from the right side of the specifier
-			for (iSepPos = (iSepPos + 1); ((iSepPos < strCurLine.length()) && ((strCurLine[iSepPos] == ' ') || (strCurLine[iSepPos] == '\"'))); iSepPos++);
+			if ((strBuffer.length() > MOCK_MAX_HEADER) || ((iLength = recv(iClient, cBuffer, sizeof(cBuffer), 0)) <= 0))
+			{
+				close(iClient);
+				return;
+			}
+			strBuffer.append(cBuffer, iLength);
+		}
 
-			// Remove spaces and quotes from the end of the string
-			for (uint8_t i = (strCurLine.length() - 1); ((i >= 0) && ((strCurLine[i] == ' ') || (strCurLine[i] == '"'))); i--)
-				strCurLine.erase(i);
+		// Parse request line and header (names in lower case)
+		strHead = strBuffer.substr(0, iHeadEnd + 2);
+		for (size_t i = 0; i < strHead.length(); i++)
+			strHead[i] = tolower(strHead[i]);
+		strMethod = strBuffer.substr(0, strBuffer.find(' '));
+		strPath = strBuffer.substr((strMethod.length() + 1), (strBuffer.find(' ', (strMethod.length() + 1)) - (strMethod.length() + 1)));
+		if ((iPos = strHead.find("\r\ncontent-length:")) != std::string::npos)
+			iContentLength = atol(strHead.c_str() + iPos + 17);
+		if ((iPos = strHead.find("\r\nif-none-match:")) != std::string::npos)
+		{
+			strIfNoneMatch = strBuffer.substr((iPos + 16), (strBuffer.find("\r\n", (iPos + 16)) - (iPos + 16)));
+			while ((strIfNoneMatch.length() > 0) && (isspace(strIfNoneMatch.front())))
+				strIfNoneMatch.erase(0, 1);
+		}
+		if ((iPos = strHead.find("\r\nx-api-key:")) != std::string::npos)
+		{
+			strAPIKey = strBuffer.substr((iPos + 12), (strBuffer.find("\r\n", (iPos + 12)) - (iPos + 12)));
+			while ((strAPIKey.length() > 0) && (isspace(strAPIKey.front())))
+				strAPIKey.erase(0, 1);
+		}
+		bClose = (strHead.find("\r\nconnection: close") != std::string::npos);
 
-			// Assign attribute
-			if (strCurLine.find("ipservice") != std::string::npos)
-				psConfigContents->strIPService = strCurLine.substr(iSepPos).c_str();
-			else if (strCurLine.find("api") != std::string::npos)
-				psConfigContents->strAPI = strCurLine.substr(iSepPos).c_str();
-			else if (strCurLine.find("successmsg") != std::string::npos)
-				psConfigContents->strSuccessMsg = strCurLine.substr(iSepPos).c_str();
-			else if (strCurLine.find("ttl") != std::string::npos)
-				psConfigContents->iTTL = atoi(strCurLine.substr(iSepPos).c_str()) >= 0 ? atoi(strCurLine.substr(iSepPos).c_str()) : 65535;
-			else if (strCurLine.find("updateperiods") != std::string::npos)
-				psConfigContents->iUpdatePeriodS = atoi(strCurLine.substr(iSepPos).c_str()) >= 0 ? atoi(strCurLine.substr(iSepPos).c_str()) : 65535;
-			else if (strCurLine.find("curltimeout") != std::string::npos)
-				psConfigContents->iCurlTimeout = atoi(strCurLine.substr(iSepPos).c_str()) >= 0 ? atoi(strCurLine.substr(iSepPos).c_str()) : 65535;
-			else if (strCurLine.find("enableipv6") != std::string::npos)
-				psConfigContents->bEnableIPv6 = iIPv6Check = strCurLine.substr(iSepPos).compare("true") != std::string::npos ? true : (strCurLine.substr(iSepPos).compare("false") != std::string::npos ? false : -1);
-			else if (strCurLine.find("logging") != std::string::npos)
-				psConfigContents->bLogging = iLogCheck = strCurLine.substr(iSepPos).compare("true") != std::string::npos ? true : (strCurLine.substr(iSepPos).compare("false") != std::string::npos ? false : -1);
-			// Unknown attribute
-			else
+		// Read body
+		while (strBuffer.length() < (iHeadEnd + 4 + iContentLength))
+		{
+			if ((iLength = recv(iClient, cBuffer, sizeof(cBuffer), 0)) <= 0)
 			{
-				// Close file and return
-				cCfgFile.close();
-				return CFG_ERR_SYNTAX;
+				close(iClient);
+				return;
 			}
+			strBuffer.append(cBuffer, iLength);
+		}
+		strBody = strBuffer.substr((iHeadEnd + 4), iContentLength);
+		strBuffer.erase(0, (iHeadEnd + 4 + iContentLength));
 
-			// Increase counter
-			iAssignedAttr++;
+		// Handle request and send response
+		iStatus = handle(strMethod, strPath, strIfNoneMatch, strAPIKey, strBody, &strResponse, &strHeaders);
+		strHeaders = "HTTP/1.1 " + std::to_string(iStatus) + " Mock\r\nContent-Length: " + std::to_string(strResponse.length()) + "\r\n" + strHeaders + "\r\n" + strResponse;
+		if ((send(iClient, strHeaders.data(), strHeaders.length(), MSG_NOSIGNAL) != (ssize_t)strHeaders.length()) || (bClose))
+		{
+			close(iClient);
+			return;
 		}
 	}
 
-	// Close file
-	cCfgFile.close();
+} // CMockServer::serve
 
-	// Check if not all attributte assigned
-	if (iAssignedAttr != CFG_AMOUNT_ATTRIBUTES)
-		return CFG_ERR_ATTR_MISSING;
+//
+// CMockServer::serveDns
+//
+// Task: Answer A and AAAA queries for the rrsets of the zones (changes are served after the propagation delay)
+//
+void CMockServer::serveDns()
+{
+	// Variables
+	unsigned char cPacket[DNS_MAX_PACKET];
+	struct sockaddr_storage sFrom;
+	socklen_t iFromLen = sizeof(sFrom);
+	ssize_t iLength;
 
-	// Check for error in Syntax
-	if ((psConfigContents->strIPService.length() == 0) || (psConfigContents->strSuccessMsg.length() == 0) || (psConfigContents->iTTL == 65535) || (psConfigContents->iUpdatePeriodS == 65535) || (iIPv6Check == -1) || (iLogCheck == -1))
-		return CFG_ERR_SYNTAX;
 
-	// Success
-	return CFG_ERR_NONE;
+	// Request loop
+	while ((iLength = recvfrom(m_iDnsSocket, cPacket, sizeof(cPacket), 0, (struct sockaddr*)&sFrom, &iFromLen)) >= 0)
+	{
+		// Variables
+		std::vector<std::string> vecValues;
+		std::string strName, strResponse;
+		size_t iPos = 12;
+		uint16_t iType;
+		uint8_t iRCode = 5;
+
+
+		// Read question name (queries with exactly one uncompressed question only)
+		iFromLen = sizeof(sFrom);
+		if ((iLength < 12) || ((cPacket[2] & 0x80) != 0) || (cPacket[4] != 0) || (cPacket[5] != 1))
+			continue;
+		while ((iPos < (size_t)iLength) && (cPacket[iPos] != 0) && ((cPacket[iPos] & 0xC0) == 0) && ((iPos + 1 + cPacket[iPos]) < (size_t)iLength))
+		{
+			strName += std::string((strName.empty() ? "" : ".")) + std::string((const char*)(cPacket + iPos + 1), cPacket[iPos]);
+			iPos += 1 + cPacket[iPos];
+		}
+		if (((iPos + 5) > (size_t)iLength) || (cPacket[iPos] != 0))
+			continue;
+		iType = (cPacket[iPos + 1] << 8) | cPacket[iPos + 2];
+		iPos += 5;
+		std::transform(strName.begin(), strName.end(), strName.begin(), ::tolower);
 
-} // loadConfig
+		// Look up served values of the rrset (REFUSED for foreign zones)
+		{
+			std::lock_guard<std::mutex> lockZones(m_mtxZones);
+			for (std::map<std::string, SMockZone>::iterator iZone = m_mapZones.begin(); iZone != m_mapZones.end(); iZone++)
+			{
+				// Variables
+				std::map<std::string, SMockRRSet>::iterator iRRSet;
+				std::string strSubDomain;
+
+
+				// Skip other zones
+				if (strName == iZone->first)
+					strSubDomain = "@";
+				else if ((strName.length() > iZone->first.length()) && (strName.compare((strName.length() - iZone->first.length() - 1), std::string::npos, ("." + iZone->first)) == 0))
+					strSubDomain = strName.substr(0, (strName.length() - iZone->first.length() - 1));
+				else
+					continue;
+
+				// Take over values
+				iRCode = 0;
+				if ((iRRSet = iZone->second.mapRRSets.find(strSubDomain + "\t" + ((iType == DNS_TYPE_A) ? "A" : "AAAA"))) != iZone->second.mapRRSets.end())
+					vecValues = ((time(NULL) - iRRSet->second.tChanged) >= m_iPropagationS) ? iRRSet->second.vecValues : iRRSet->second.vecPrevious;
+				break;
+			}
+		}
+		if ((iType != DNS_TYPE_A) && (iType != DNS_TYPE_AAAA))
+			vecValues.clear();
+
+		// Header (authoritative answer) and question
+		strResponse.append((const char*)cPacket, 2);
+		strResponse += (char)(0x84 | (cPacket[2] & 0x01));
+		strResponse += (char)iRCode;
+		strResponse.append("\0\1\0\0\0\0\0\0", 8);
+		strResponse.append((const char*)(cPacket + 12), (iPos - 12));
+
+		// Answers (owner is a pointer to the question)
+		for (size_t i = 0; i < vecValues.size(); i++)
+		{
+			// Variables
+			unsigned char cAddress[16];
+			uint8_t iSize = (iType == DNS_TYPE_A) ? 4 : 16;
+
+
+			// Append record if the value is valid
+			if (inet_pton(((iType == DNS_TYPE_A) ? AF_INET : AF_INET6), vecValues[i].c_str(), cAddress) != 1)
+				continue;
+			strResponse.append("\xC0\x0C", 2);
+			strResponse += (char)(iType >> 8);
+			strResponse += (char)(iType & 0xFF);
+			strResponse.append("\0\1\0\0\1\x2C\0", 7);
+			strResponse += (char)iSize;
+			strResponse.append((const char*)cAddress, iSize);
+			strResponse[7]++;
+		}
+
+		// Send response
+		sendto(m_iDnsSocket, strResponse.data(), strResponse.length(), 0, (struct sockaddr*)&sFrom, sizeof(struct sockaddr_in));
+	}
+
+} // CMockServer::serveDns
 
 //
-// generateConfig
+// CMockServer::handle
 //
-// Task: Create a new config file with default settings
+// Task: Handle a request of the IP service or the LiveDNS record endpoints
 //
-bool generateConfig()
+int CMockServer::handle(const std::string& strMethod, const std::string& strPath, const std::string& strIfNoneMatch, const std::string& strAPIKey, const std::string& strBody, std::string* pstrResponse, std::string* pstrHeaders)
 {
 	// Variables
-	std::filesystem::path ptDirPath = std::filesystem::path(CFG_FILE_PATH).parent_path();
-	std::error_code errCreateDir;
+	static thread_local std::mt19937 cRandom(std::random_device{}());
+	std::uniform_real_distribution<double> cChance(0.0, 1.0);
+	std::vector<std::string> vecParts;
+	size_t iPos;
+	SJsonValue sBody;
 
 
-	// Create parent directory if required
-	if (!std::filesystem::exists(ptDirPath))
-		if (!std::filesystem::create_directory(ptDirPath, ptDirPath.parent_path(), errCreateDir))
-			return false;
+	// Simulate latency
+	if (m_iLatencyMs != 0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(m_iLatencyMs));
 
-	// Try to generate new config file
-	std::ofstream cCfgFile(CFG_FILE_PATH);
+	// IP service (PUT changes the address)
+	if (strPath == "/ip")
+	{
+		std::lock_guard<std::mutex> lockZones(m_mtxZones);
+		if (strMethod == "PUT")
+			m_strAddress = strBody;
+		*pstrResponse = m_strAddress + "\n";
+		*pstrHeaders = "Content-Type: text/plain\r\n";
+		return 200;
+	}
 
-	// Check if failed
-	if (cCfgFile.fail())
-		return false;
+	// Split record path ("/domains/<domain>/records[/<name>/<type>]")
+	if ((iPos = strPath.find("/domains/")) == std::string::npos)
+	{
+		*pstrResponse = "{\"message\": \"Not found\"}";
+		return 404;
+	}
+	vecParts = splitList(strPath.substr(iPos + 9), '/');
+	if ((vecParts.size() < 2) || ((vecParts[1] != "records") && (vecParts[1] != "nameservers")))
+	{
+		*pstrResponse = "{\"message\": \"Not found\"}";
+		return 404;
+	}
 
-	// Write default config
-	cCfgFile << "#####################################################" << std::endl;
-	cCfgFile << "# Config file managing record updates for gandi.net #" << std::endl;
-	cCfgFile << "#####################################################" << std::endl;
-	cCfgFile << "\n# Service that is used to determine your own IP address" << std::endl;
-	cCfgFile << "IPService=" << CFG_DEF_IP_SERVICE << std::endl;
-	cCfgFile << "\n# The address of the API service" << std::endl;
-	cCfgFile << "API=" << CFG_DEF_API << std::endl;
-	cCfgFile << "\n# The message that must be received in order to view the record update as successful" << std::endl;
-	cCfgFile << "SuccessMsg=\"" << CFG_DEF_SUCCESS_MSG << "\"" << std::endl;
-	cCfgFile << "\n# The \"time to live\" of the record/s" << std::endl;
-	cCfgFile << "TTL=" << CFG_DEF_TTL << std::endl;
-	cCfgFile << "\n# Controls the update interval" << std::endl;
-	cCfgFile << "UpdatePeriodS=" << CFG_DEF_UPDATE_PERIOD_S << std::endl;
-	cCfgFile << "\n# Controls the timeout for CURL" << std::endl;
-	cCfgFile << "CurlTimeoutS=" << CFG_DEF_CURL_TIMEOUT_S << std::endl;
-	cCfgFile << "\n# Controls wether IPv6 support is enabled or disabled" << std::endl;
-	cCfgFile << "EnableIPv6=" << (CFG_DEF_IP_SERVICE ? "true" : "false") << std::endl;
-	cCfgFile << "\n# Controls wether logging is enabled or disabled" << std::endl;
-	cCfgFile << "Logging=" << (CFG_DEF_LOGGING ? "true" : "false") << std::endl;
+	// Enforce limit per API key and simulate rate limits and errors
+	if (!limit(strAPIKey, pstrHeaders))
+	{
+		*pstrResponse = "{\"message\": \"Too many requests\"}";
+		return 429;
+	}
+	if ((m_dLimitRate > 0.0) && (cChance(cRandom) < m_dLimitRate))
+	{
+		*pstrResponse = "{\"message\": \"Too many requests\"}";
+		*pstrHeaders += "Retry-After: 1\r\n";
+		return 429;
+	}
+	if ((m_dErrorRate > 0.0) && (cChance(cRandom) < m_dErrorRate))
+	{
+		*pstrResponse = "{\"message\": \"Internal error\"}";
+		return 500;
+	}
 
-	// Close file
-	cCfgFile.close();
+	// Nameservers (the mock server itself)
+	if ((strMethod == "GET") && (vecParts[1] == "nameservers"))
+	{
+		*pstrResponse = "[\"127.0.0.1:" + std::to_string(port()) + "\"]";
+		*pstrHeaders += "Content-Type: application/json\r\n";
+		return 200;
+	}
 
-	// Success
-	return true;
+	// Lock zones
+	std::lock_guard<std::mutex> lockZones(m_mtxZones);
+	SMockZone* psZone = &m_mapZones[vecParts[0]];
+	std::string strETag = "\"" + std::to_string(psZone->iVersion) + "\"";
 
-} // generateConfig
+
+	// Read whole zone
+	if ((strMethod == "GET") && (vecParts.size() == 2))
+	{
+		// Check entity tag
+		*pstrHeaders += "ETag: " + strETag + "\r\n";
+		if (strIfNoneMatch == strETag)
+			return 304;
+
+		// Format rrsets
+		*pstrResponse = "[";
+		for (std::map<std::string, SMockRRSet>::iterator iRRSet = psZone->mapRRSets.begin(); iRRSet != psZone->mapRRSets.end(); iRRSet++)
+		{
+			*pstrResponse += std::string((pstrResponse->length() > 1) ? ", " : "") + "{\"rrset_name\": \"" + jsonEscape(iRRSet->second.strName) + "\", \"rrset_type\": \"" + jsonEscape(iRRSet->second.strType) + "\", \"rrset_ttl\": " + std::to_string(iRRSet->second.iTTL) + ", \"rrset_values\": [";
+			for (size_t i = 0; i < iRRSet->second.vecValues.size(); i++)
+				*pstrResponse += std::string(i ? ", " : "") + "\"" + jsonEscape(iRRSet->second.vecValues[i]) + "\"";
+			*pstrResponse += "]}";
+		}
+		*pstrResponse += "]";
+		*pstrHeaders += "Content-Type: application/json\r\n";
+		return 200;
+	}
+
+	// Replace whole zone or a single rrset
+	if ((strMethod == "PUT") && ((vecParts.size() == 2) || (vecParts.size() == 4)) && (parseJson(strBody, &sBody)))
+	{
+		// Variables
+		const SJsonValue* psItems = (vecParts.size() == 2) ? sBody.member("items") : NULL;
+		std::map<std::string, SMockRRSet> mapPrevious;
+		std::map<std::string, SMockRRSet>* pmapPrevious = (vecParts.size() == 2) ? &mapPrevious : &psZone->mapRRSets;
+		std::map<std::string, SMockRRSet>::iterator iPrevious;
+
+
+		// Check body
+		if ((vecParts.size() == 2) && ((psItems == NULL) || (psItems->eType != SJsonValue::JSON_ARRAY)))
+		{
+			*pstrResponse = "{\"message\": \"Invalid body\"}";
+			return 400;
+		}
+
+		// Clear zone if replaced (the nameservers keep serving the previous values for a while)
+		if (vecParts.size() == 2)
+			mapPrevious.swap(psZone->mapRRSets);
+
+		// Run through rrsets
+		for (size_t i = 0; i < ((vecParts.size() == 2) ? psItems->vecItems.size() : 1); i++)
+		{
+			// Variables
+			const SJsonValue* psItem = (vecParts.size() == 2) ? &psItems->vecItems[i] : &sBody;
+			const SJsonValue* psName = (vecParts.size() == 2) ? psItem->member("rrset_name") : NULL;
+			const SJsonValue* psType = (vecParts.size() == 2) ? psItem->member("rrset_type") : NULL;
+			const SJsonValue* psTTL = psItem->member("rrset_ttl");
+			const SJsonValue* psValues = psItem->member("rrset_values");
+			SMockRRSet sRRSet;
+
+
+			// Skip invalid rrsets
+			if (((vecParts.size() == 2) && ((psName == NULL) || (psType == NULL))) || (psValues == NULL))
+				continue;
+
+			// Store rrset
+			sRRSet.strName = (vecParts.size() == 2) ? psName->strValue : vecParts[2];
+			sRRSet.strType = (vecParts.size() == 2) ? psType->strValue : vecParts[3];
+			sRRSet.iTTL = (psTTL != NULL) ? atoi(psTTL->strValue.c_str()) : CFG_DEF_TTL;
+			for (size_t j = 0; j < psValues->vecItems.size(); j++)
+				sRRSet.vecValues.push_back(psValues->vecItems[j].strValue);
+			if ((iPrevious = pmapPrevious->find(sRRSet.strName + "\t" + sRRSet.strType)) != pmapPrevious->end())
+				sRRSet.vecPrevious = ((time(NULL) - iPrevious->second.tChanged) >= m_iPropagationS) ? iPrevious->second.vecValues : iPrevious->second.vecPrevious;
+			sRRSet.tChanged = time(NULL);
+			psZone->mapRRSets[sRRSet.strName + "\t" + sRRSet.strType] = sRRSet;
+		}
+
+		// Change version and answer like LiveDNS
+		psZone->iVersion++;
+		*pstrResponse = (vecParts.size() == 2) ? "{\"message\": \"Domain Records Updated\"}" : "{\"message\": \"DNS Record Created\"}";
+		*pstrHeaders += "Content-Type: application/json\r\n";
+		return 201;
+	}
+
+	// Unsupported request
+	*pstrResponse = "{\"message\": \"Bad request\"}";
+	return 400;
+
+} // CMockServer::handle
+
+//
+// CMockServer::limit
+//
+// Task: Count a request of an API key in its window of a minute and add the rate limit headers (false if exceeded)
+//
+bool CMockServer::limit(const std::string& strAPIKey, std::string* pstrHeaders)
+{
+	// Variables
+	time_t tNow = time(NULL);
+	std::pair<time_t, uint32_t>* psWindow;
+
+
+	// Check if enabled
+	if (m_iPerMinute == 0)
+		return true;
+
+	// Start new window if the current one is over
+	std::lock_guard<std::mutex> lockZones(m_mtxZones);
+	psWindow = &m_mapWindows[strAPIKey];
+	if ((tNow - psWindow->first) >= 60)
+		*psWindow = std::make_pair(tNow, 0);
+
+	// Count request and add headers
+	if (psWindow->second < m_iPerMinute)
+		psWindow->second++;
+	else
+		*pstrHeaders += "Retry-After: " + std::to_string(psWindow->first + 60 - tNow) + "\r\n";
+	*pstrHeaders += "X-RateLimit-Limit: " + std::to_string(m_iPerMinute) + "\r\nX-RateLimit-Remaining: " + std::to_string(m_iPerMinute - psWindow->second) + "\r\nX-RateLimit-Reset: " + std::to_string(psWindow->first + 60 - tNow) + "\r\n";
+	return (pstrHeaders->find("Retry-After:") == std::string::npos);
+
+} // CMockServer::limit
+
+//
+// runControl
+//
+// Task: Send a command to the control socket of the running program and print the response
+//
+int runControl(int argc, char* argv[])
+{
+	// Variables
+	SConfigContents sConfigContents;
+	struct sockaddr_un sAddr;
+	std::string strRequest, strResponse;
+	char cBuffer[BIG_BUFFER];
+	ssize_t iLength;
+	int iSocket;
+
+
+	// Get path of the socket from the config (default if missing)
+	loadConfig(&sConfigContents);
+	memset(&sAddr, 0, sizeof(sAddr));
+	sAddr.sun_family = AF_UNIX;
+	strncpy(sAddr.sun_path, sConfigContents.strControlSocket.c_str(), (sizeof(sAddr.sun_path) - 1));
+
+	// Build request from arguments
+	for (int i = 2; i < argc; i++)
+		strRequest += std::string((i > 2) ? " " : "") + argv[i];
+	strRequest += "\n";
+
+	// Try to connect and send request
+	if (((iSocket = socket(AF_UNIX, (SOCK_STREAM | SOCK_CLOEXEC), 0)) < 0) || (connect(iSocket, (struct sockaddr*)&sAddr, sizeof(sAddr)) < 0) || (send(iSocket, strRequest.data(), strRequest.length(), MSG_NOSIGNAL) != (ssize_t)strRequest.length()))
+	{
+		std::cerr << COLOR_RED << "[ERROR]: Cannot connect to " << sConfigContents.strControlSocket << ": " << std::strerror(errno) << ". Is the program running?" << COLOR_DEFAULT << std::endl;
+		if (iSocket >= 0)
+			close(iSocket);
+		return -1;
+	}
+
+	// Read response until the connection is closed
+	while ((iLength = recv(iSocket, cBuffer, sizeof(cBuffer), 0)) > 0)
+		strResponse.append(cBuffer, iLength);
+	close(iSocket);
+
+	// Print response (errors in red)
+	if (strResponse.compare(0, 3, "OK\n") == 0)
+	{
+		std::cout << strResponse.substr(3) << std::flush;
+		return 0;
+	}
+	std::cerr << COLOR_RED << "[" << strResponse.substr(0, strResponse.find('\n')).replace(0, 5, "ERROR]") << COLOR_DEFAULT << std::endl;
+	return -1;
+
+} // runControl